@@ -0,0 +1,50 @@
+#include "microbench.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include "camera.hpp"
+#include "clustered_lighting.hpp"
+
+namespace engine::bench {
+
+	namespace {
+
+		// NOLINTBEGIN
+		// lights scattered through the view volume of the default camera, all with the same range
+		std::vector<PointLight> scatterLights(size_t count, float range) {
+			const float intensity = PointLightComponent::CUTOFF * range * range;
+			std::vector<PointLight> lights(count);
+			for (size_t i = 0; i < count; i++) {
+				const auto f = static_cast<float>(i);
+				const float z = 0.5F + std::fmod(f * 0.618F, 9.0F);
+				const glm::vec3 position { (std::fmod(f * 0.37F, 2.0F) - 1.0F) * z * 0.6F, (std::fmod(f * 0.73F, 2.0F) - 1.0F) * z * 0.4F, z };
+				lights[i] = { glm::vec4(position, 0.1F), glm::vec4(1.0F, 1.0F, 1.0F, intensity) };
+			}
+			return lights;
+		}
+		// NOLINTEND
+
+	}
+
+	// Cluster assignment cost for a growing number of visible lights; count caps the largest light
+	// count at ClusteredLighting::MAX_LIGHTS.
+	void runClusterBench(size_t count) {
+		Camera camera {};
+		camera.perspectiveProjection(glm::radians(50.0F), 16.0F / 9.0F, 0.1F, 10.0F); // NOLINT
+
+		std::vector<ClusterRange> clusters(LightClusters::CLUSTER_COUNT);
+		std::vector<uint32_t> indices(ClusteredLighting::MAX_LIGHT_INDICES);
+		LightClusters grid {};
+		const size_t max_lights = std::min<size_t>(count, ClusteredLighting::MAX_LIGHTS);
+		for (size_t lights_count = 10; lights_count <= max_lights; lights_count *= 4) { // NOLINT
+			const auto lights = scatterLights(lights_count, 0.5F); // NOLINT
+			uint32_t used = 0;
+			report("cluster_assign", lights_count, measureMs([&] {
+				used = grid.build(camera.view(), camera.projection(), camera.nearPlane(), camera.farPlane(), lights.data(), static_cast<uint32_t>(lights.size()), clusters.data(), indices.data(), ClusteredLighting::MAX_LIGHT_INDICES);
+			}));
+			std::cerr << "lights " << lights_count << ": " << used << " cluster entries, " << static_cast<double>(used) / LightClusters::CLUSTER_COUNT << " per cluster\n";
+		}
+	}
+
+}
@@ -0,0 +1,124 @@
+#include "microbench.hpp"
+
+#include <memory>
+#include <unordered_map>
+
+#include "scene_object.hpp"
+
+namespace engine::bench {
+
+	namespace {
+
+		const size_t LIGHT_EVERY = 8;
+		const size_t MODEL_EVERY = 2;
+
+		// stands in for a loaded model, which needs a device: the same size as std::shared_ptr<Model> and
+		// only its null check matters for iteration
+		using ModelHandle = std::shared_ptr<int>;
+
+		// ModelComponent with the stand-in handle
+		struct BenchModelComponent {
+			ModelHandle model {};
+		};
+
+		// layout of a scene object before the entity registry: one node per object holding every component
+		struct MapObject {
+			ModelHandle model {};
+			glm::vec3 color {};
+			TransformComponent transform {};
+			std::unique_ptr<PointLightComponent> pointLight = nullptr;
+		};
+
+		using ObjectMap = std::unordered_map<uint32_t, MapObject>;
+
+		glm::vec3 position(size_t i) {
+			return { static_cast<float>(i % 101), static_cast<float>(i % 37), static_cast<float>(i % 13) }; // NOLINT
+		}
+
+	}
+
+	void runEcsBench(size_t count) {
+		const auto model = std::make_shared<int>(0);
+
+		ObjectMap objects {};
+		const double map_build_ms = measureMs([&] {
+			objects = ObjectMap {};
+			for (size_t i = 0; i < count; i++) {
+				MapObject obj {};
+				obj.transform.setTranslation(position(i));
+				if (i % MODEL_EVERY == 0) {
+					obj.model = model;
+				}
+				if (i % LIGHT_EVERY == 0) {
+					obj.pointLight = std::make_unique<PointLightComponent>();
+				}
+				objects.emplace(static_cast<uint32_t>(i), std::move(obj));
+			}
+		});
+		report("map_build", count, map_build_ms);
+
+		Scene scene {};
+		const double registry_build_ms = measureMs([&] {
+			scene = Scene {};
+			scene.pool<TransformComponent>().reserve(count);
+			for (size_t i = 0; i < count; i++) {
+				auto entity = scene.createObject();
+				scene.get<TransformComponent>(entity).setTranslation(position(i));
+				if (i % MODEL_EVERY == 0) {
+					scene.emplace<BenchModelComponent>(entity, model);
+				}
+				if (i % LIGHT_EVERY == 0) {
+					scene.emplace<PointLightComponent>(entity);
+				}
+			}
+		});
+		report("registry_build", count, registry_build_ms);
+
+		glm::vec3 sum {};
+		report("map_iterate_models", count, measureMs([&] {
+			for (auto& kv : objects) {
+				if (kv.second.model == nullptr) {
+					continue;
+				}
+				sum += kv.second.transform.translation();
+			}
+			doNotOptimize(sum);
+		}));
+		report("registry_iterate_models", count, measureMs([&] {
+			scene.each<BenchModelComponent, TransformComponent>([&](Entity, BenchModelComponent&, TransformComponent& transform) {
+				sum += transform.translation();
+			});
+			doNotOptimize(sum);
+		}));
+
+		report("map_iterate_lights", count, measureMs([&] {
+			for (auto& kv : objects) {
+				if (kv.second.pointLight == nullptr) {
+					continue;
+				}
+				sum += kv.second.transform.translation() * kv.second.pointLight->lightIntensity;
+			}
+			doNotOptimize(sum);
+		}));
+		report("registry_iterate_lights", count, measureMs([&] {
+			scene.each<PointLightComponent, TransformComponent>([&](Entity, PointLightComponent& light, TransformComponent& transform) {
+				sum += transform.translation() * light.lightIntensity;
+			});
+			doNotOptimize(sum);
+		}));
+
+		report("map_iterate_transforms", count, measureMs([&] {
+			for (auto& kv : objects) {
+				sum += kv.second.transform.translation();
+			}
+			doNotOptimize(sum);
+		}));
+		report("registry_iterate_transforms", count, measureMs([&] {
+			scene.each<TransformComponent>([&](Entity, TransformComponent& transform) {
+				sum += transform.translation();
+			});
+			doNotOptimize(sum);
+		}));
+	}
+
+}
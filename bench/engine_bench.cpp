@@ -0,0 +1,509 @@
+// Headless end to end benchmark: renders synthetic scenes for a fixed number of frames and reports
+// CPU stage times, GPU times per pass and system, render counters, pipeline statistics, heap
+// allocations per frame, frame and stage time percentiles and hitches as CSV or JSON. Runs are reproducible: scenes come from a fixed seed, the camera follows
+// a scripted path and every frame advances the simulation by the same step.
+//
+// usage: 3d_engine_bench [list | all | <scenario>...] [--objects N] [--unique R] [--lights N] [--frames N]
+//                        [--deferred] [--format csv|json] [--out path] [--baseline path] [--threshold T]
+//                        [--trace path] [--fail-on-allocations]
+//        3d_engine_bench compare <baseline.csv> <current.csv> [--threshold T]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+#include "allocation_tracker.hpp"
+#include "app.hpp"
+#include "clustered_lighting.hpp"
+#include "cpu_profiler.hpp"
+#include "render_system.hpp"
+
+namespace {
+
+	using engine::Entity;
+	using engine::Model;
+	using engine::Scene;
+
+	const uint32_t SEED = 1234;
+	const float FRAME_STEP = 1.0F / 60.0F;
+	const double DEFAULT_THRESHOLD = 0.10;
+	// workload metrics only differ by float formatting when the runs did the same work
+	const double WORKLOAD_TOLERANCE = 1.0e-6;
+	// a time that was 0 in the baseline regresses once it exceeds this; hitches once there is any
+	const double ZERO_BASELINE_MS = 0.05;
+	const int OUTPUT_PRECISION = 10;
+	const uint32_t WARMUP_FRAMES = 30;
+	// the scene stays inside the camera's 10 unit far plane
+	const float SCENE_RADIUS = 4.0F;
+
+	enum class CameraPath {
+		Orbit, // circles the scene looking at its center
+		Flythrough // moves straight through the scene
+	};
+
+	struct Scenario {
+		std::string name;
+		uint32_t objects = 0;
+		float uniqueRatio = 0.0F; // objects with their own model buffers, the rest share one model
+		uint32_t lights = 0;
+		uint32_t frames = 0;
+		CameraPath camera = CameraPath::Orbit;
+		engine::RenderPath path = engine::RenderPath::Forward;
+	};
+
+	struct Metric {
+		std::string name;
+		double value = 0.0;
+	};
+
+	struct ScenarioResult {
+		std::string name;
+		std::vector<Metric> metrics;
+	};
+
+	std::vector<Scenario> builtinScenarios() {
+		using engine::RenderPath;
+		return {
+			{ "small_instanced", 100, 0.0F, 4, 300, CameraPath::Orbit, RenderPath::Forward },
+			{ "medium_mixed", 1000, 0.25F, 32, 300, CameraPath::Orbit, RenderPath::Forward },
+			{ "large_instanced", 5000, 0.0F, 64, 300, CameraPath::Flythrough, RenderPath::Forward },
+			{ "large_unique", 5000, 1.0F, 64, 300, CameraPath::Flythrough, RenderPath::Forward },
+			{ "many_lights", 1000, 0.25F, 1024, 300, CameraPath::Orbit, RenderPath::Forward },
+			{ "deferred_mixed", 1000, 0.25F, 256, 300, CameraPath::Orbit, RenderPath::Deferred },
+		};
+	}
+
+	// NOLINTBEGIN
+	Model::Builder sphereBuilder(uint32_t rings, uint32_t segments) {
+		Model::Builder builder {};
+		for (uint32_t ring = 0; ring <= rings; ring++) {
+			const float phi = glm::pi<float>() * static_cast<float>(ring) / static_cast<float>(rings);
+			for (uint32_t segment = 0; segment <= segments; segment++) {
+				const float theta = glm::two_pi<float>() * static_cast<float>(segment) / static_cast<float>(segments);
+				Model::Vertex vertex {};
+				vertex.normal = { std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta) };
+				vertex.position = vertex.normal * 0.1F;
+				vertex.color = { 0.8F, 0.8F, 0.8F };
+				vertex.uv = { static_cast<float>(segment) / static_cast<float>(segments), static_cast<float>(ring) / static_cast<float>(rings) };
+				builder.vertices.push_back(vertex);
+			}
+		}
+		for (uint32_t ring = 0; ring < rings; ring++) {
+			for (uint32_t segment = 0; segment < segments; segment++) {
+				const uint32_t a = ring * (segments + 1) + segment;
+				const uint32_t b = a + segments + 1;
+				builder.indices.insert(builder.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+		return builder;
+	}
+
+	void loadSyntheticScene(const Scenario& scenario, engine::EngineDevice& device, Scene& scene) {
+		std::mt19937 random { SEED };
+		std::uniform_real_distribution<float> position { -SCENE_RADIUS, SCENE_RADIUS };
+		std::uniform_real_distribution<float> height { -1.0F, 1.0F };
+		std::uniform_real_distribution<float> unit { 0.0F, 1.0F };
+
+		const auto builder = sphereBuilder(16, 32);
+		const std::shared_ptr<Model> shared = std::make_shared<Model>(device, builder);
+		const auto unique = static_cast<uint32_t>(std::lround(static_cast<float>(scenario.objects) * scenario.uniqueRatio));
+		for (uint32_t i = 0; i < scenario.objects; i++) {
+			const Entity entity = scene.createModelObject(i < unique ? std::make_shared<Model>(device, builder) : shared);
+			auto& transform = scene.get<engine::TransformComponent>(entity);
+			transform.setTranslation({ position(random), height(random), position(random) });
+			transform.setScale(glm::vec3(0.5F + unit(random)));
+		}
+		for (uint32_t i = 0; i < scenario.lights; i++) {
+			const glm::vec3 color { 0.5F + 0.5F * unit(random), 0.5F + 0.5F * unit(random), 0.5F + 0.5F * unit(random) };
+			const Entity light = scene.createPointLight(0.5F + unit(random), 0.05F, color);
+			scene.get<engine::TransformComponent>(light).setTranslation({ position(random), height(random) - 1.0F, position(random) });
+		}
+	}
+
+	// y points down in view space, so the camera sits at negative y and pitches down toward the scene
+	void placeCamera(CameraPath path, uint32_t frame, uint32_t frames, engine::TransformComponent& viewer) {
+		const float t = static_cast<float>(frame) / static_cast<float>(std::max(frames, 1U));
+		if (path == CameraPath::Orbit) {
+			const float radius = SCENE_RADIUS + 2.0F;
+			const float camera_height = 2.0F;
+			const float angle = glm::two_pi<float>() * t;
+			viewer.setTranslation({ -std::sin(angle) * radius, -camera_height, -std::cos(angle) * radius });
+			viewer.setRotation({ -std::atan2(camera_height, radius), angle, 0.0F });
+			return;
+		}
+		viewer.setTranslation({ 0.0F, -0.5F, -SCENE_RADIUS - 2.0F + t * (2.0F * SCENE_RADIUS + 4.0F) });
+		viewer.setRotation({ 0.0F, 0.0F, 0.0F });
+	}
+	// NOLINTEND
+
+	template<typename Field>
+	double mean(const std::vector<engine::FrameStats>& frames, Field field) {
+		double sum = 0.0;
+		for (const auto& frame : frames) {
+			sum += static_cast<double>(field(frame));
+		}
+		return frames.empty() ? 0.0 : sum / static_cast<double>(frames.size());
+	}
+
+	// percentiles of the measured frames from the app's histograms, and the hitches among them by cause
+	std::vector<Metric> frameTimeMetrics(const engine::FrameTimeStats& times) {
+		using engine::FrameStage;
+		using engine::HitchCause;
+		const auto& frame = times.total(FrameStage::Frame);
+		std::vector<Metric> metrics {
+			{ "frame_p50_ms", frame.percentileMs(0.50) },
+			{ "frame_p95_ms", frame.percentileMs(0.95) },
+			{ "frame_p99_ms", frame.percentileMs(0.99) },
+			{ "frame_max_ms", frame.maxMs() },
+		};
+		for (const auto stage : { FrameStage::Acquire, FrameStage::Update, FrameStage::Shadow, FrameStage::Record, FrameStage::Submit }) {
+			const std::string name = std::string { "cpu_" } + engine::frameStageName(stage);
+			metrics.push_back({ name + "_p99_ms", times.total(stage).percentileMs(0.99) });
+			metrics.push_back({ name + "_max_ms", times.total(stage).maxMs() });
+		}
+		metrics.push_back({ "hitches", static_cast<double>(times.hitchCount()) });
+		for (const auto cause : { HitchCause::SwapChainRecreation, HitchCause::ModelUpload, HitchCause::FenceWait, HitchCause::Unattributed }) {
+			metrics.push_back({ std::string { "hitches_" } + engine::hitchCauseName(cause), static_cast<double>(times.hitchCount(cause)) });
+		}
+		return metrics;
+	}
+
+	ScenarioResult runScenario(const Scenario& scenario) {
+		std::vector<engine::FrameStats> measured {};
+		measured.reserve(scenario.frames);
+
+		engine::HeadlessOptions options {};
+		options.frames = WARMUP_FRAMES + scenario.frames;
+		options.fixedFrameTime = FRAME_STEP;
+		options.loadScene = [&](engine::EngineDevice& device, Scene& scene) { loadSyntheticScene(scenario, device, scene); };
+		options.cameraPath = [&](uint32_t frame, engine::TransformComponent& viewer) {
+			placeCamera(scenario.camera, frame < WARMUP_FRAMES ? 0 : frame - WARMUP_FRAMES, scenario.frames, viewer);
+		};
+		engine::App* app_ptr = nullptr;
+		// warmup frames wait for pipelines and fill the shadow cache
+		options.onFrame = [&](const engine::FrameStats& stats) {
+			if (stats.frame + 1 == WARMUP_FRAMES) {
+				app_ptr->gpuProfiler().resetTotals();
+				app_ptr->frameTimes().resetTotals();
+			}
+			if (stats.frame >= WARMUP_FRAMES) {
+				measured.push_back(stats);
+			}
+		};
+		std::vector<Metric> gpu_metrics {};
+		std::vector<Metric> frame_time_metrics {};
+		{
+			engine::App app { options };
+			app_ptr = &app;
+			app.setRenderPath(scenario.path);
+			app.run();
+			// absent when the graphics queue has no timestamps
+			for (const auto& scope : app.gpuProfiler().scopes()) {
+				gpu_metrics.push_back({ "gpu_" + scope.name + "_ms", scope.meanMs() });
+			}
+			frame_time_metrics = frameTimeMetrics(app.frameTimes());
+		}
+
+		using engine::FrameStats;
+		ScenarioResult result { scenario.name, {
+			{ "objects", static_cast<double>(scenario.objects) },
+			{ "unique_ratio", static_cast<double>(scenario.uniqueRatio) },
+			{ "lights", static_cast<double>(scenario.lights) },
+			{ "frames", static_cast<double>(measured.size()) },
+			{ "cpu_acquire_ms", mean(measured, [](const FrameStats& s) { return s.acquireMs; }) },
+			{ "cpu_update_ms", mean(measured, [](const FrameStats& s) { return s.updateMs; }) },
+			{ "cpu_shadow_ms", mean(measured, [](const FrameStats& s) { return s.shadowMs; }) },
+			{ "cpu_record_ms", mean(measured, [](const FrameStats& s) { return s.recordMs; }) },
+			{ "cpu_submit_ms", mean(measured, [](const FrameStats& s) { return s.submitMs; }) },
+			{ "shadow_views", mean(measured, [](const FrameStats& s) { return s.shadowViews; }) },
+			{ "draw_calls", mean(measured, [](const FrameStats& s) { return s.counters.drawCalls; }) },
+			{ "triangles", mean(measured, [](const FrameStats& s) { return s.counters.triangles; }) },
+			{ "pipeline_binds", mean(measured, [](const FrameStats& s) { return s.counters.pipelineBinds; }) },
+			{ "buffer_writes", mean(measured, [](const FrameStats& s) { return s.counters.bufferWrites; }) },
+			{ "bytes_written", mean(measured, [](const FrameStats& s) { return s.counters.bytesWritten; }) },
+			{ "buffer_copies", mean(measured, [](const FrameStats& s) { return s.counters.bufferCopies; }) },
+			{ "bytes_copied", mean(measured, [](const FrameStats& s) { return s.counters.bytesCopied; }) },
+		} };
+		// absent when the engine does not count allocations, see AllocationTracker
+		if (engine::AllocationTracker::enabled()) {
+			uint64_t allocations_max = 0;
+			for (const auto& stats : measured) {
+				allocations_max = std::max(allocations_max, stats.allocations);
+			}
+			result.metrics.insert(result.metrics.end(), {
+				{ "allocations_per_frame", mean(measured, [](const FrameStats& s) { return s.allocations; }) },
+				{ "allocations_max", static_cast<double>(allocations_max) },
+			});
+		}
+		// absent without the pipelineStatisticsQuery feature
+		const bool has_statistics = std::any_of(measured.begin(), measured.end(), [](const FrameStats& s) { return s.gpuStatistics.valid; });
+		if (has_statistics) {
+			result.metrics.insert(result.metrics.end(), {
+				{ "gpu_input_vertices", mean(measured, [](const FrameStats& s) { return s.gpuStatistics.inputVertices; }) },
+				{ "gpu_input_primitives", mean(measured, [](const FrameStats& s) { return s.gpuStatistics.inputPrimitives; }) },
+				{ "gpu_vertex_invocations", mean(measured, [](const FrameStats& s) { return s.gpuStatistics.vertexInvocations; }) },
+				{ "gpu_clipping_invocations", mean(measured, [](const FrameStats& s) { return s.gpuStatistics.clippingInvocations; }) },
+				{ "gpu_clipping_primitives", mean(measured, [](const FrameStats& s) { return s.gpuStatistics.clippingPrimitives; }) },
+				{ "gpu_fragment_invocations", mean(measured, [](const FrameStats& s) { return s.gpuStatistics.fragmentInvocations; }) },
+			});
+		}
+		result.metrics.insert(result.metrics.end(), frame_time_metrics.begin(), frame_time_metrics.end());
+		result.metrics.insert(result.metrics.end(), gpu_metrics.begin(), gpu_metrics.end());
+		return result;
+	}
+
+	void writeCsv(std::ostream& out, const std::vector<ScenarioResult>& results) {
+		out << std::setprecision(OUTPUT_PRECISION) << "scenario,metric,value\n";
+		for (const auto& result : results) {
+			for (const auto& metric : result.metrics) {
+				out << result.name << "," << metric.name << "," << metric.value << "\n";
+			}
+		}
+	}
+
+	void writeJson(std::ostream& out, const std::vector<ScenarioResult>& results) {
+		out << std::setprecision(OUTPUT_PRECISION) << "{\n\t\"scenarios\": [";
+		for (size_t i = 0; i < results.size(); i++) {
+			out << (i == 0 ? "" : ",") << "\n\t\t{ \"name\": \"" << results[i].name << "\", \"metrics\": {";
+			const auto& metrics = results[i].metrics;
+			for (size_t m = 0; m < metrics.size(); m++) {
+				out << (m == 0 ? " " : ", ") << "\"" << metrics[m].name << "\": " << metrics[m].value;
+			}
+			out << " } }";
+		}
+		out << "\n\t]\n}\n";
+	}
+
+	using MetricTable = std::map<std::string, std::map<std::string, double>>;
+
+	MetricTable readCsv(const std::string& path) {
+		std::ifstream file { path };
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open " + path);
+		}
+		MetricTable table {};
+		std::string line {};
+		std::getline(file, line); // header
+		while (std::getline(file, line)) {
+			std::istringstream fields { line };
+			std::string scenario {};
+			std::string metric {};
+			std::string value {};
+			if (std::getline(fields, scenario, ',') && std::getline(fields, metric, ',') && std::getline(fields, value)) {
+				table[scenario][metric] = std::stod(value);
+			}
+		}
+		return table;
+	}
+
+	// Time and hitch metrics regress when they grow by more than the threshold, or past an absolute
+	// limit when the baseline is 0. Workload metrics such as draw calls must match exactly, a
+	// difference means the runs are not comparable.
+	int compare(const MetricTable& baseline, const MetricTable& current, double threshold) {
+		int regressions = 0;
+		for (const auto& [scenario, metrics] : current) {
+			const auto base_scenario = baseline.find(scenario);
+			if (base_scenario == baseline.end()) {
+				std::cerr << scenario << ": not in baseline\n";
+				continue;
+			}
+			for (const auto& [metric, value] : metrics) {
+				const auto base = base_scenario->second.find(metric);
+				if (base == base_scenario->second.end()) {
+					continue;
+				}
+				const bool milliseconds = metric.size() > 3 && metric.compare(metric.size() - 3, 3, "_ms") == 0;
+				const bool timing = milliseconds || metric.rfind("hitches", 0) == 0;
+				const bool zero_baseline = base->second == 0.0;
+				const double change = zero_baseline ? 0.0 : (value - base->second) / base->second;
+				bool regressed = false;
+				if (!zero_baseline) {
+					regressed = timing ? change > threshold : std::abs(change) > WORKLOAD_TOLERANCE;
+				} else if (timing) {
+					regressed = value > (milliseconds ? ZERO_BASELINE_MS : 0.0);
+				} else {
+					regressed = std::abs(value) > WORKLOAD_TOLERANCE;
+				}
+				std::cout << (regressed ? "REGRESSION " : "ok         ") << scenario << " " << metric << ": " << base->second << " -> " << value;
+				if (timing && !zero_baseline) {
+					std::cout << " (" << (change >= 0.0 ? "+" : "") << change * 100.0 << "%)"; // NOLINT
+				}
+				std::cout << "\n";
+				regressions += regressed ? 1 : 0;
+			}
+		}
+		std::cout << regressions << " regression(s) at " << threshold * 100.0 << "% threshold\n"; // NOLINT
+		return regressions == 0 ? 0 : 1;
+	}
+
+	void usage(const std::vector<Scenario>& scenarios) {
+		std::cerr << "usage: 3d_engine_bench [list | all | <scenario>...] [--objects N] [--unique R] [--lights N] [--frames N]\n"
+			<< "                       [--deferred] [--format csv|json] [--out path] [--baseline path] [--threshold T]\n"
+			<< "                       [--trace path] [--fail-on-allocations]\n"
+			<< "       3d_engine_bench compare <baseline.csv> <current.csv> [--threshold T]\nscenarios:";
+		for (const auto& scenario : scenarios) {
+			std::cerr << " " << scenario.name;
+		}
+		std::cerr << "\n";
+	}
+
+}
+
+int main(int argc, char** argv) {
+	const auto scenarios = builtinScenarios();
+	const std::vector<std::string> args(argv + 1, argv + argc); // NOLINT
+
+	double threshold = DEFAULT_THRESHOLD;
+	for (size_t i = 0; i + 1 < args.size(); i++) {
+		if (args[i] == "--threshold") {
+			threshold = std::stod(args[i + 1]);
+		}
+	}
+
+	try {
+		if (!args.empty() && args[0] == "compare") {
+			if (args.size() < 3) {
+				usage(scenarios);
+				return -1;
+			}
+			return compare(readCsv(args[1]), readCsv(args[2]), threshold);
+		}
+		if (!args.empty() && args[0] == "list") {
+			for (const auto& scenario : scenarios) {
+				std::cout << scenario.name << ": " << scenario.objects << " objects, " << scenario.uniqueRatio * 100.0F << "% unique, " // NOLINT
+					<< scenario.lights << " lights, " << scenario.frames << " frames\n";
+			}
+			return 0;
+		}
+
+		std::vector<Scenario> selected {};
+		std::string format = "csv";
+		std::string out_path {};
+		std::string baseline_path {};
+		std::string trace_path {};
+		// applied to every selected scenario
+		bool deferred = false;
+		bool fail_on_allocations = false;
+		std::optional<uint32_t> objects {};
+		std::optional<float> unique_ratio {};
+		std::optional<uint32_t> lights {};
+		std::optional<uint32_t> frames {};
+		for (size_t i = 0; i < args.size(); i++) {
+			const std::string& arg = args[i];
+			const bool has_value = i + 1 < args.size();
+			if (arg == "--deferred") {
+				deferred = true;
+			} else if (arg == "--fail-on-allocations") {
+				fail_on_allocations = true;
+			} else if (arg.rfind("--", 0) == 0 && !has_value) {
+				usage(scenarios);
+				return -1;
+			} else if (arg == "--objects") {
+				objects = std::min(static_cast<uint32_t>(std::stoul(args[++i])), engine::RenderSystem::MAX_OBJECTS);
+			} else if (arg == "--unique") {
+				unique_ratio = std::clamp(std::stof(args[++i]), 0.0F, 1.0F);
+			} else if (arg == "--lights") {
+				lights = std::min(static_cast<uint32_t>(std::stoul(args[++i])), engine::ClusteredLighting::MAX_LIGHTS);
+			} else if (arg == "--frames") {
+				frames = static_cast<uint32_t>(std::stoul(args[++i]));
+			} else if (arg == "--format") {
+				format = args[++i];
+			} else if (arg == "--out") {
+				out_path = args[++i];
+			} else if (arg == "--baseline") {
+				baseline_path = args[++i];
+			} else if (arg == "--trace") {
+				trace_path = args[++i];
+			} else if (arg == "--threshold") {
+				i++;
+			} else if (arg == "all") {
+				selected.insert(selected.end(), scenarios.begin(), scenarios.end());
+			} else {
+				const auto it = std::find_if(scenarios.begin(), scenarios.end(), [&](const Scenario& scenario) { return scenario.name == arg; });
+				if (it == scenarios.end()) {
+					usage(scenarios);
+					return -1;
+				}
+				selected.push_back(*it);
+			}
+		}
+		if (selected.empty()) {
+			selected = scenarios;
+		}
+		for (auto& scenario : selected) {
+			scenario.path = deferred ? engine::RenderPath::Deferred : scenario.path;
+			scenario.objects = objects.value_or(scenario.objects);
+			scenario.uniqueRatio = unique_ratio.value_or(scenario.uniqueRatio);
+			scenario.lights = lights.value_or(scenario.lights);
+			scenario.frames = frames.value_or(scenario.frames);
+		}
+		if (format != "csv" && format != "json") {
+			usage(scenarios);
+			return -1;
+		}
+		if (fail_on_allocations && !engine::AllocationTracker::enabled()) {
+			std::cerr << "--fail-on-allocations needs the engine built with ENGINE_TRACK_ALLOCATIONS\n";
+			return -1;
+		}
+
+		std::vector<ScenarioResult> results {};
+		for (const auto& scenario : selected) {
+			std::cerr << "running " << scenario.name << "\n";
+			results.push_back(runScenario(scenario));
+		}
+		// CPU zones of the last frames of every scenario, see CpuProfiler::ZONES_PER_THREAD
+		if (!trace_path.empty() && !engine::CpuProfiler::writeChromeTrace(trace_path)) {
+			std::cerr << "failed to write trace " << trace_path << "\n";
+		}
+
+		std::ofstream out_file {};
+		if (!out_path.empty()) {
+			out_file.open(out_path);
+		}
+		std::ostream& out = out_path.empty() ? std::cout : out_file;
+		if (format == "json") {
+			writeJson(out, results);
+		} else {
+			writeCsv(out, results);
+		}
+
+		int status = 0;
+		if (fail_on_allocations) {
+			for (const auto& result : results) {
+				for (const auto& metric : result.metrics) {
+					if (metric.name == "allocations_max" && metric.value > 0.0) {
+						std::cerr << result.name << ": up to " << metric.value << " allocations in a measured frame\n";
+						status = 1;
+					}
+				}
+			}
+		}
+		if (!baseline_path.empty()) {
+			MetricTable current {};
+			for (const auto& result : results) {
+				for (const auto& metric : result.metrics) {
+					current[result.name][metric.name] = metric.value;
+				}
+			}
+			status = std::max(status, compare(readCsv(baseline_path), current, threshold));
+		}
+		return status;
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << "\n";
+		return -1;
+	}
+	return 0;
+}
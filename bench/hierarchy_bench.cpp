@@ -0,0 +1,82 @@
+#include "microbench.hpp"
+
+#include <vector>
+
+#include "scene_object.hpp"
+
+namespace engine::bench {
+
+	namespace {
+
+		const size_t WIDE_CHILDREN = 99;
+
+		// deep: a single chain; wide: many short root subtrees, which is where the parallel update applies
+		void buildDeep(Scene& scene, std::vector<Entity>& roots, std::vector<Entity>& leaves, size_t count) {
+			Entity parent = NULL_ENTITY;
+			for (size_t i = 0; i < count; i++) {
+				const Entity entity = scene.createObject();
+				scene.setParent(entity, parent);
+				if (parent == NULL_ENTITY) {
+					roots.push_back(entity);
+				}
+				parent = entity;
+			}
+			leaves.push_back(parent);
+		}
+
+		void buildWide(Scene& scene, std::vector<Entity>& roots, std::vector<Entity>& leaves, size_t count) {
+			for (size_t i = 0; i < count; i += WIDE_CHILDREN + 1) {
+				const Entity root = scene.createObject();
+				roots.push_back(root);
+				for (size_t child = 0; child < WIDE_CHILDREN && i + child + 1 < count; child++) {
+					const Entity entity = scene.createObject();
+					scene.setParent(entity, root);
+					leaves.push_back(entity);
+				}
+			}
+		}
+
+		template<typename Build>
+		void runShape(const std::string& shape, size_t count, Build&& build) {
+			Scene scene {};
+			std::vector<Entity> roots {};
+			std::vector<Entity> leaves {};
+			report(shape + "_build", count, measureMs([&] {
+				scene = Scene {};
+				roots.clear();
+				leaves.clear();
+				build(scene, roots, leaves, count);
+				scene.updateTransforms();
+			}));
+
+			report(shape + "_clean", count, measureMs([&] {
+				scene.updateTransforms();
+			}));
+
+			float nudge = -1.0e-3F;
+			report(shape + "_roots_moved", count, measureMs([&] {
+				nudge = -nudge;
+				for (const Entity root : roots) {
+					auto& transform = scene.get<TransformComponent>(root);
+					transform.setRotation(transform.rotation() + glm::vec3(nudge));
+				}
+				scene.updateTransforms();
+			}));
+
+			report(shape + "_leaf_moved", count, measureMs([&] {
+				nudge = -nudge;
+				auto& transform = scene.get<TransformComponent>(leaves.back());
+				transform.setTranslation(transform.translation() + glm::vec3(nudge));
+				scene.updateTransforms();
+			}));
+			doNotOptimize(scene.worldMatrix(leaves.back()));
+		}
+
+	}
+
+	void runHierarchyBench(size_t count) {
+		runShape("deep", count, buildDeep);
+		runShape("wide", count, buildWide);
+	}
+
+}
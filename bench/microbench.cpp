@@ -0,0 +1,38 @@
+#include "microbench.hpp"
+
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace {
+
+	const size_t DEFAULT_COUNT = 1000000;
+
+	void usage(const std::map<std::string, std::function<void(size_t)>>& benches) {
+		std::cerr << "usage: 3d_engine_microbench <bench> [count]\nbenches:";
+		for (const auto& kv : benches) {
+			std::cerr << " " << kv.first;
+		}
+		std::cerr << "\n";
+	}
+
+}
+
+int main(int argc, char** argv) {
+	const std::map<std::string, std::function<void(size_t)>> benches {
+		{ "ecs", engine::bench::runEcsBench },
+		{ "transform", engine::bench::runTransformBench },
+		{ "hierarchy", engine::bench::runHierarchyBench },
+		{ "scene_file", engine::bench::runSceneFileBench },
+		{ "cluster", engine::bench::runClusterBench },
+	};
+	if (argc < 2 || benches.count(argv[1]) == 0) {
+		usage(benches);
+		return -1;
+	}
+	const size_t count = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : DEFAULT_COUNT; // NOLINT
+	std::cout << "name,count,ms,ns_per_item\n";
+	benches.at(argv[1])(count);
+	return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef MICROBENCH_HPP
+#define MICROBENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace engine::bench {
+
+	const int REPETITIONS = 5;
+
+	// best of REPETITIONS runs in milliseconds; the best run is the least disturbed by the rest of the system
+	template<typename Func>
+	double measureMs(Func&& func) {
+		double best = std::numeric_limits<double>::max();
+		for (int i = 0; i < REPETITIONS; i++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			func();
+			auto end = std::chrono::high_resolution_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		return best;
+	}
+
+	inline void report(const std::string& name, size_t count, double ms) {
+		std::cout << name << "," << count << "," << ms << "," << (ms * 1.0e6 / static_cast<double>(count)) << "\n";
+	}
+
+	// keeps the optimizer from discarding benchmark results
+	template<typename T>
+	void doNotOptimize(const T& value) {
+		asm volatile("" : : "r,m"(value) : "memory");
+	}
+
+	void runEcsBench(size_t count);
+	void runTransformBench(size_t count);
+	void runHierarchyBench(size_t count);
+	void runSceneFileBench(size_t count);
+	void runClusterBench(size_t count);
+
+}
+
+#endif // MICROBENCH_HPP
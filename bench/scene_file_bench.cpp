@@ -0,0 +1,60 @@
+#include "microbench.hpp"
+
+#include <filesystem>
+
+#include "scene_file.hpp"
+
+namespace engine::bench {
+
+	namespace {
+
+		const size_t LIGHT_EVERY = 8;
+		const size_t CHILD_EVERY = 4;
+
+		// NOLINTBEGIN
+		void buildWithApi(Scene& scene, size_t count) {
+			scene.pool<TransformComponent>().reserve(count);
+			Entity previous = NULL_ENTITY;
+			for (size_t i = 0; i < count; i++) {
+				const auto f = static_cast<float>(i);
+				const Entity entity = i % LIGHT_EVERY == 0 ? scene.createPointLight(1.0F + f * 1.0e-6F) : scene.createObject();
+				auto& transform = scene.get<TransformComponent>(entity);
+				transform.setTranslation({ f, f * 0.5F, -f });
+				transform.setRotation({ f * 0.01F, f * 0.02F, f * 0.03F });
+				if (i % CHILD_EVERY != 0) {
+					scene.setParent(entity, previous);
+				}
+				previous = entity;
+			}
+		}
+		// NOLINTEND
+
+	}
+
+	void runSceneFileBench(size_t count) {
+		const auto path = (std::filesystem::temp_directory_path() / "3d_engine_bench.scene").string();
+		const auto no_models = [](const std::string&) { return std::shared_ptr<Model> {}; };
+
+		Scene scene {};
+		report("api_build", count, measureMs([&] {
+			scene = Scene {};
+			buildWithApi(scene, count);
+			scene.updateTransforms();
+		}));
+
+		report("file_save", count, measureMs([&] {
+			SceneFile::save(path, scene);
+		}));
+
+		Scene loaded {};
+		report("file_load", count, measureMs([&] {
+			loaded = Scene {};
+			SceneFile::load(path, loaded, no_models);
+			loaded.updateTransforms();
+		}));
+		doNotOptimize(loaded.size());
+
+		std::filesystem::remove(path);
+	}
+
+}
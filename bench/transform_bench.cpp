@@ -0,0 +1,96 @@
+#include "microbench.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include "scene_object.hpp"
+#include "transform_kernel.hpp"
+
+namespace engine::bench {
+
+	namespace {
+
+		// NOLINTBEGIN
+		void fillTransforms(size_t count, std::vector<TransformComponent>& components, TransformArrays& arrays) {
+			components.assign(count, TransformComponent {});
+			arrays.resize(count);
+			for (size_t i = 0; i < count; i++) {
+				const auto f = static_cast<float>(i);
+				const glm::vec3 translation { std::fmod(f, 101.0F), std::fmod(f, 37.0F), std::fmod(f, 13.0F) };
+				const glm::vec3 rotation { std::fmod(f * 0.37F, 12.0F) - 6.0F, std::fmod(f * 0.11F, 12.0F) - 6.0F, std::fmod(f * 0.73F, 12.0F) - 6.0F };
+				const glm::vec3 scale { 0.5F + std::fmod(f, 3.0F), 1.0F, 0.25F + std::fmod(f, 5.0F) };
+				components[i].setTranslation(translation);
+				components[i].setRotation(rotation);
+				components[i].setScale(scale);
+				arrays.set(i, translation, rotation, scale);
+			}
+		}
+		// NOLINTEND
+
+		float maxError(const std::vector<TransformComponent>& components, const std::vector<glm::mat4>& matrices, const std::vector<glm::mat3>& normal_matrices) {
+			float error = 0.0F;
+			for (size_t i = 0; i < components.size(); i++) {
+				const auto& expected = components[i].mat4();
+				const auto& expected_normal = components[i].normalMatrix();
+				for (int col = 0; col < 4; col++) {
+					for (int row = 0; row < 4; row++) {
+						error = std::max(error, std::abs(expected[col][row] - matrices[i][col][row]));
+					}
+				}
+				for (int col = 0; col < 3; col++) {
+					for (int row = 0; row < 3; row++) {
+						error = std::max(error, std::abs(expected_normal[col][row] - normal_matrices[i][col][row]));
+					}
+				}
+			}
+			return error;
+		}
+
+		void runOnce(size_t count) {
+			std::vector<TransformComponent> components {};
+			TransformArrays arrays {};
+			fillTransforms(count, components, arrays);
+			std::vector<glm::mat4> matrices(count);
+			std::vector<glm::mat3> normal_matrices(count);
+
+			// reapplying the same rotation is a no-op, so nudge back and forth to keep the cache dirty
+			float nudge = -1.0e-3F;
+			report("transform_component", count, measureMs([&] {
+				nudge = -nudge;
+				for (auto& transform : components) {
+					transform.setRotation(transform.rotation() + glm::vec3(nudge));
+					doNotOptimize(transform.mat4());
+					doNotOptimize(transform.normalMatrix());
+				}
+			}));
+			fillTransforms(count, components, arrays);
+
+			report("kernel_scalar", count, measureMs([&] {
+				computeTransforms(arrays, matrices.data(), normal_matrices.data(), TransformKernel::Scalar);
+				doNotOptimize(matrices.data());
+			}));
+			std::cerr << "kernel_scalar max error: " << maxError(components, matrices, normal_matrices) << "\n";
+
+			if (bestTransformKernel() != TransformKernel::Avx2) {
+				std::cerr << "avx2 not available, skipping kernel_avx2\n";
+				return;
+			}
+			report("kernel_avx2", count, measureMs([&] {
+				computeTransforms(arrays, matrices.data(), normal_matrices.data(), TransformKernel::Avx2);
+				doNotOptimize(matrices.data());
+			}));
+			std::cerr << "kernel_avx2 max error: " << maxError(components, matrices, normal_matrices) << "\n";
+		}
+
+	}
+
+	// runs at count / 100, count / 10 and count, so the default count covers 10k, 100k and 1M
+	void runTransformBench(size_t count) {
+		for (size_t n : { count / 100, count / 10, count }) { // NOLINT
+			if (n > 0) {
+				runOnce(n);
+			}
+		}
+	}
+
+}
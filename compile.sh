@@ -4,3 +4,9 @@
 /Users/masamonoke/lib/vulkan/macOS/bin/glslc shader/point_light.vert -o shader/build/point_light.vert.spv
 /Users/masamonoke/lib/vulkan/macOS/bin/glslc shader/point_light.frag -o shader/build/point_light.frag.spv
 
+/Users/masamonoke/lib/vulkan/macOS/bin/glslc shader/gbuffer.frag -o shader/build/gbuffer.frag.spv
+/Users/masamonoke/lib/vulkan/macOS/bin/glslc shader/fullscreen.vert -o shader/build/fullscreen.vert.spv
+/Users/masamonoke/lib/vulkan/macOS/bin/glslc shader/deferred_lighting.frag -o shader/build/deferred_lighting.frag.spv
+
+/Users/masamonoke/lib/vulkan/macOS/bin/glslc shader/shadow.vert -o shader/build/shadow.vert.spv
+/Users/masamonoke/lib/vulkan/macOS/bin/glslc shader/shadow.frag -o shader/build/shadow.frag.spv
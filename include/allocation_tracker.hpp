@@ -0,0 +1,22 @@
+#ifndef ALLOCATION_TRACKER_HPP
+#define ALLOCATION_TRACKER_HPP
+
+#include <cstdint>
+
+namespace engine {
+
+	// Counts calls to the global operator new. When built with ENGINE_TRACK_ALLOCATIONS the engine
+	// library replaces operator new and delete with counting versions over malloc; otherwise every count
+	// stays 0. Allocations made directly with malloc, as C libraries and drivers do, are not seen.
+	class AllocationTracker {
+		public:
+			[[nodiscard]] static bool enabled();
+			// by every thread since startup
+			[[nodiscard]] static uint64_t allocations();
+			// by the calling thread since it started, cheap enough to sample around a frame
+			[[nodiscard]] static uint64_t threadAllocations();
+	};
+
+}
+
+#endif // ALLOCATION_TRACKER_HPP
@@ -1,7 +1,10 @@
 #ifndef APP_H
 #define APP_H
 
+#include <functional>
 #include <memory>
+#include <optional>
+#include <string>
 
 #include <vulkan/vulkan.h>
 #define GLM_FORCE_RADIANS
@@ -11,17 +14,43 @@
 #include "window.hpp"
 #include "engine_device.hpp"
 #include "scene_object.hpp"
+#include "frame_info.hpp"
 #include "renderer.hpp"
 #include "descriptor.hpp"
+#include "bindless_heap.hpp"
+#include "gpu_profiler.hpp"
+#include "frame_time_stats.hpp"
+#include "telemetry.hpp"
+#include "pipeline_statistics.hpp"
 
 namespace engine {
 
+	// Renders a fixed number of frames without a window, for machines without a display. The hooks
+	// let a benchmark supply its own scene and camera and collect per frame statistics.
+	struct HeadlessOptions {
+		uint32_t width = 1280; // NOLINT
+		uint32_t height = 720; // NOLINT
+		uint32_t frames = 300; // NOLINT
+		std::string captureDirectory {}; // frames are written here as PPM files when set
+		float fixedFrameTime = 0.0F; // seconds advanced per frame for reproducible runs, 0 uses wall time
+		std::function<void(EngineDevice&, Scene&)> loadScene {}; // replaces the default scene
+		std::function<void(uint32_t frame, TransformComponent& viewer)> cameraPath {};
+		std::function<void(const FrameStats&)> onFrame {};
+		bool logFrameTimes = false; // frame time summaries and hitches on stdout, as a windowed app always does
+	};
+
 	class App {
 		public:
 			static constexpr int WIDTH = 1280;
 			static constexpr int HEIGHT = 720;
+			static constexpr int TOGGLE_RENDER_PATH_KEY = GLFW_KEY_TAB;
+			static constexpr int TOGGLE_SPECULAR_KEY = GLFW_KEY_P;
+			static constexpr int TOGGLE_SHADING_MODEL_KEY = GLFW_KEY_M;
+			static constexpr int DUMP_TRACE_KEY = GLFW_KEY_T;
+			static constexpr const char* DEFAULT_TRACE_PATH = "trace.json";
 
 			App();
+			explicit App(HeadlessOptions headless);
 			~App();
 			App(const App&) = delete;
 			App& operator=(const App&) = delete;
@@ -29,16 +58,39 @@ namespace engine {
 			App&& operator=(const App&&) = delete;
 
 			void run();
+			// the path can also be switched while running with TOGGLE_RENDER_PATH_KEY
+			void setRenderPath(RenderPath path) { renderPath_ = path; }
+			// the CPU trace is written here on exit, and whenever DUMP_TRACE_KEY is pressed
+			void setTracePath(std::string path) { tracePath_ = std::move(path); }
+			// per pass and per system GPU timings, see GpuProfiler
+			[[nodiscard]] GpuProfiler& gpuProfiler() { return *gpuProfiler_; }
+			// frame and stage time percentiles and hitches, see FrameTimeStats
+			[[nodiscard]] FrameTimeStats& frameTimes() { return *frameTimes_; }
+			// starts exporting metrics of the device, renderer, model loader and frame loop, see Telemetry
+			void enableTelemetry(TelemetryOptions options);
 
 		private:
-			Window window_ { WIDTH, HEIGHT, "App" };
-			EngineDevice device_ { window_ };
-			/* std::vector<SceneObject> sceneObjects_; */
-			SceneObject::Map sceneObjects_;
-			Renderer renderer_ { window_, device_ };
+			std::optional<HeadlessOptions> headless_ {};
+			std::unique_ptr<Window> window_ { headless_ ? nullptr : std::make_unique<Window>(WIDTH, HEIGHT, "App") };
+			EngineDevice device_ { window_.get() };
+			Scene scene_;
+			std::unique_ptr<Renderer> renderer_ { window_ != nullptr
+				? std::make_unique<Renderer>(*window_, device_)
+				: std::make_unique<Renderer>(device_, VkExtent2D { headless_->width, headless_->height }) };
 			std::unique_ptr<DescriptorPool> globalPool_ {};
+			std::unique_ptr<BindlessHeap> bindlessHeap_ {};
+			std::unique_ptr<GpuProfiler> gpuProfiler_ {};
+			std::unique_ptr<PipelineStatistics> pipelineStatistics_ {};
+			std::unique_ptr<FrameTimeStats> frameTimes_ { std::make_unique<FrameTimeStats>() };
+			std::unique_ptr<Telemetry> telemetry_ {};
+			RenderPath renderPath_ = RenderPath::Forward;
+			std::string tracePath_ {};
 
+			void init();
 			void loadSceneObjects();
+			// the window decides when to stop, a headless run after its frame count
+			bool running(uint32_t frame);
+			void writeTrace(const std::string& path);
 	};
 
 }
@@ -0,0 +1,70 @@
+#ifndef BINDLESS_HEAP_HPP
+#define BINDLESS_HEAP_HPP
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "engine_device.hpp"
+#include "descriptor.hpp"
+#include "swap_chain.hpp"
+
+namespace engine {
+
+	// One update-after-bind descriptor set with large partially bound arrays of storage buffers and
+	// sampled images. Shaders index them with the handles returned here (see shader/bindless.glsl),
+	// so draws never have to rebind descriptor sets to switch resources.
+	//
+	// Pipeline layouts put the global set at 0, their own per-pass set at 1 and the heap at SET.
+	class BindlessHeap {
+		public:
+			using handle_t = uint32_t;
+
+			static constexpr uint32_t SET = 2;
+			static constexpr handle_t INVALID_HANDLE = UINT32_MAX;
+			static constexpr uint32_t STORAGE_BUFFER_BINDING = 0;
+			static constexpr uint32_t SAMPLED_IMAGE_BINDING = 1;
+			static constexpr uint32_t MAX_STORAGE_BUFFERS = 4096;
+			static constexpr uint32_t MAX_SAMPLED_IMAGES = 4096;
+
+			explicit BindlessHeap(EngineDevice& device);
+			~BindlessHeap();
+			BindlessHeap(const BindlessHeap&) = delete;
+			BindlessHeap& operator=(const BindlessHeap&) = delete;
+			BindlessHeap(const BindlessHeap&&) = delete;
+			BindlessHeap&& operator=(const BindlessHeap&&) = delete;
+
+			handle_t addStorageBuffer(VkDescriptorBufferInfo buffer_info);
+			handle_t addSampledImage(VkDescriptorImageInfo image_info);
+			void updateStorageBuffer(handle_t handle, VkDescriptorBufferInfo buffer_info);
+			void updateSampledImage(handle_t handle, VkDescriptorImageInfo image_info);
+			// handles are recycled only after the frame that released them has left the GPU
+			void removeStorageBuffer(handle_t handle, int frame_idx);
+			void removeSampledImage(handle_t handle, int frame_idx);
+			void collect(int frame_idx);
+
+			[[nodiscard]] VkDescriptorSetLayout descriptorSetLayout() const { return setLayout_->descriptorSetLayout(); }
+			[[nodiscard]] VkDescriptorSet descriptorSet() const { return descriptorSet_; }
+			[[nodiscard]] uint32_t storageBufferCapacity() const { return storageBuffers_.capacity; }
+			[[nodiscard]] uint32_t sampledImageCapacity() const { return sampledImages_.capacity; }
+
+		private:
+			struct Slots {
+				uint32_t capacity = 0;
+				handle_t next = 0;
+				std::vector<handle_t> freeList {};
+				std::array<std::vector<handle_t>, SwapChain::MAX_FRAMES> retired {};
+
+				handle_t allocate();
+			};
+
+			std::unique_ptr<DescriptorSetLayout> setLayout_;
+			std::unique_ptr<DescriptorPool> pool_;
+			VkDescriptorSet descriptorSet_ = VK_NULL_HANDLE;
+			Slots storageBuffers_ {};
+			Slots sampledImages_ {};
+	};
+
+}
+
+#endif // BINDLESS_HEAP_HPP
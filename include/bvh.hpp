@@ -0,0 +1,117 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "ecs.hpp"
+#include "geometry.hpp"
+
+namespace engine {
+
+	// Dynamic AABB tree over entity bounds. Leaves store bounds inflated by FAT_MARGIN, so an object
+	// that moves a little stays inside its leaf and move() is a no-op; otherwise the leaf is
+	// reinserted at the cheapest sibling by surface area and the tree is rebalanced with rotations
+	// on the way up.
+	class Bvh {
+		public:
+			using proxy_t = int32_t;
+			static constexpr proxy_t NULL_NODE = -1;
+			static constexpr float FAT_MARGIN = 0.1F;
+
+			Bvh() = default;
+			~Bvh() = default;
+			Bvh(const Bvh&) = delete;
+			Bvh& operator=(const Bvh&) = delete;
+			Bvh(Bvh&&) = default;
+			Bvh& operator=(Bvh&&) = default;
+
+			proxy_t insert(const Aabb& bounds, Entity entity);
+			void remove(proxy_t proxy);
+			// returns true if the leaf had to be reinserted
+			bool move(proxy_t proxy, const Aabb& bounds);
+
+			[[nodiscard]] const Aabb& fatBounds(proxy_t proxy) const { return nodes_[proxy].bounds; }
+			[[nodiscard]] Entity entity(proxy_t proxy) const { return nodes_[proxy].entity; }
+			[[nodiscard]] size_t size() const { return leafCount_; }
+			[[nodiscard]] int height() const { return root_ == NULL_NODE ? 0 : nodes_[root_].height; }
+
+			// func(entity) for every leaf whose fat bounds pass the test
+			template<typename Func>
+			void query(const Frustum& frustum, Func&& func) const {
+				traverse([&](const Aabb& bounds) { return frustum.intersects(bounds); }, func);
+			}
+
+			template<typename Func>
+			void query(const Sphere& sphere, Func&& func) const {
+				traverse([&](const Aabb& bounds) { return sphere.intersects(bounds); }, func);
+			}
+
+			template<typename Func>
+			void query(const Aabb& box, Func&& func) const {
+				traverse([&](const Aabb& bounds) { return box.intersects(bounds); }, func);
+			}
+
+			// func(entity, t) for every leaf hit closer than max_t
+			template<typename Func>
+			void query(const Ray& ray, float max_t, Func&& func) const {
+				float t = 0.0F;
+				traverse([&](const Aabb& bounds) { return ray.intersects(bounds, max_t, t); }, [&](Entity entity) { func(entity, t); });
+			}
+
+			// nearest leaf along the ray, or NULL_ENTITY
+			Entity raycast(const Ray& ray, float max_t, float& hit_t) const;
+
+		private:
+			struct Node {
+				Aabb bounds {};
+				proxy_t parent = NULL_NODE;
+				proxy_t left = NULL_NODE;
+				proxy_t right = NULL_NODE;
+				// leaves are 0, free nodes -1
+				int height = -1;
+				Entity entity = NULL_ENTITY;
+
+				[[nodiscard]] bool isLeaf() const { return left == NULL_NODE; }
+			};
+
+			std::vector<Node> nodes_ {};
+			std::vector<proxy_t> freeList_ {};
+			proxy_t root_ = NULL_NODE;
+			size_t leafCount_ = 0;
+			// reused by traversals so queries do not allocate once warmed up
+			mutable std::vector<proxy_t> stack_ {};
+
+			proxy_t allocateNode();
+			void freeNode(proxy_t node);
+			void insertLeaf(proxy_t leaf);
+			void removeLeaf(proxy_t leaf);
+			proxy_t balance(proxy_t node);
+			void refit(proxy_t node);
+
+			template<typename Test, typename Func>
+			void traverse(Test&& test, Func&& func) const {
+				if (root_ == NULL_NODE) {
+					return;
+				}
+				stack_.clear();
+				stack_.push_back(root_);
+				while (!stack_.empty()) {
+					const Node& node = nodes_[stack_.back()];
+					stack_.pop_back();
+					if (!test(node.bounds)) {
+						continue;
+					}
+					if (node.isLeaf()) {
+						func(node.entity);
+					} else {
+						stack_.push_back(node.left);
+						stack_.push_back(node.right);
+					}
+				}
+			}
+	};
+
+}
+
+#endif // BVH_HPP
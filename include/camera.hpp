@@ -5,6 +5,8 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include "geometry.hpp"
+
 namespace engine {
 
 	class Camera {
@@ -12,6 +14,9 @@ namespace engine {
 			[[nodiscard]] const glm::mat4& projection() const { return projectionMatrix_; }
 			[[nodiscard]] const glm::mat4& view() const { return viewMatrix_; }
 			[[nodiscard]] const glm::mat4& inverseView() const { return inverseViewMatrix_; }
+			[[nodiscard]] Frustum frustum() const { return Frustum::fromMatrix(projectionMatrix_ * viewMatrix_); }
+			[[nodiscard]] float nearPlane() const { return near_; }
+			[[nodiscard]] float farPlane() const { return far_; }
 
 			void orhographicProjection(float left, float right, float top, float bottom, float near, float far);
 			void perspectiveProjection(float fovy, float aspect, float near, float far);
@@ -23,6 +28,8 @@ namespace engine {
 			glm::mat4 projectionMatrix_ { 1.0F };
 			glm::mat4 viewMatrix_ { 1.0F };
 			glm::mat4 inverseViewMatrix_ { 1.0F };
+			float near_ = 0.1F;
+			float far_ = 10.0F;
 	};
 
 }
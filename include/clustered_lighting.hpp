@@ -0,0 +1,100 @@
+#ifndef CLUSTERED_LIGHTING_HPP
+#define CLUSTERED_LIGHTING_HPP
+
+#include <memory>
+#include <vector>
+
+#include "buffer.hpp"
+#include "engine_device.hpp"
+#include "frame_info.hpp"
+
+namespace engine {
+
+	// offset into the light index list and number of lights touching one cluster
+	struct ClusterRange {
+		uint32_t offset = 0;
+		uint32_t count = 0;
+	};
+
+	// CPU light assignment. The view frustum is cut into CLUSTERS_X * CLUSTERS_Y screen tiles and
+	// CLUSTERS_Z depth slices spaced exponentially between the near and far plane, so slices stay
+	// roughly cube shaped. Each light's range sphere is bounded in tile and slice space and its index is
+	// appended to every cluster of that box; clusters are laid out x fastest, then y, then z.
+	class LightClusters {
+		public:
+			static constexpr uint32_t CLUSTERS_X = 16;
+			static constexpr uint32_t CLUSTERS_Y = 9;
+			static constexpr uint32_t CLUSTERS_Z = 24;
+			static constexpr uint32_t CLUSTER_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+			// Fills CLUSTER_COUNT ranges and at most index_capacity light indices. Lights are PointLights
+			// in world space. Returns the number of indices written; clusters past the capacity are cut
+			// short rather than overflowing.
+			uint32_t build(
+				const glm::mat4& view,
+				const glm::mat4& projection,
+				float near,
+				float far,
+				const PointLight* lights,
+				uint32_t light_count,
+				ClusterRange* clusters,
+				uint32_t* indices,
+				uint32_t index_capacity
+			);
+
+			// x, y: tiles per pixel, z, w: scale and bias turning log(view depth) into a slice
+			static glm::vec4 shaderScale(float width, float height, float near, float far);
+
+		private:
+			struct LightBox {
+				uint32_t minX, maxX, minY, maxY, minZ, maxZ;
+			};
+
+			std::vector<LightBox> boxes_ {};
+			std::vector<uint32_t> lightOfBox_ {};
+			std::vector<uint32_t> cursor_ {};
+			std::vector<uint32_t> ends_ {};
+	};
+
+	// Owns the per frame light, cluster and light index storage buffers bound to the global set and
+	// refreshes them from the scene every frame.
+	class ClusteredLighting {
+		public:
+			static constexpr uint32_t MAX_LIGHTS = 4096;
+			static constexpr uint32_t MAX_LIGHT_INDICES = 1U << 20;
+
+			static constexpr uint32_t LIGHTS_BINDING = 1;
+			static constexpr uint32_t CLUSTERS_BINDING = 2;
+			static constexpr uint32_t LIGHT_INDICES_BINDING = 3;
+
+			explicit ClusteredLighting(EngineDevice& device);
+			~ClusteredLighting() = default;
+			ClusteredLighting(const ClusteredLighting&) = delete;
+			ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+			ClusteredLighting(const ClusteredLighting&&) = delete;
+			ClusteredLighting&& operator=(const ClusteredLighting&&) = delete;
+
+			[[nodiscard]] VkDescriptorBufferInfo lightsInfo(int frame_idx) const { return lightBuffers_[frame_idx]->decriptorInfo(); }
+			[[nodiscard]] VkDescriptorBufferInfo clustersInfo(int frame_idx) const { return clusterBuffers_[frame_idx]->decriptorInfo(); }
+			[[nodiscard]] VkDescriptorBufferInfo lightIndicesInfo(int frame_idx) const { return indexBuffers_[frame_idx]->decriptorInfo(); }
+
+			// Gathers the lights whose range reaches into the view, assigns them to clusters and fills the
+			// cluster fields of the ubo. Call after Scene::updateTransforms. Lights past MAX_LIGHTS are dropped.
+			void update(FrameInfo& frame_info, GlobalUbo& ubo, VkExtent2D extent);
+			// number of lights written by the last update, the first lightCount() entries of the light buffer
+			[[nodiscard]] uint32_t lightCount() const { return static_cast<uint32_t>(visible_.size()); }
+			// entity of each light buffer entry written by the last update
+			[[nodiscard]] const std::vector<Entity>& lightEntities() const { return visibleEntities_; }
+
+		private:
+			std::vector<std::unique_ptr<Buffer>> lightBuffers_ {};
+			std::vector<std::unique_ptr<Buffer>> clusterBuffers_ {};
+			std::vector<std::unique_ptr<Buffer>> indexBuffers_ {};
+			LightClusters clusters_ {};
+			std::vector<PointLight> visible_ {};
+			std::vector<Entity> visibleEntities_ {};
+	};
+
+}
+
+#endif // CLUSTERED_LIGHTING_HPP
@@ -0,0 +1,61 @@
+#ifndef CPU_PROFILER_HPP
+#define CPU_PROFILER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace engine {
+
+	// Records named CPU zones into per thread ring buffers and dumps them as Chrome trace_event JSON,
+	// which Perfetto and chrome://tracing open. Only the owning thread writes its ring and publishes each
+	// zone with a release store, so recording takes no lock; a dump may run while other threads record
+	// and skips the zones overwritten under it. Rings outlive their threads and are handed to the next
+	// thread that starts recording, so a dump still shows the work of workers that have exited.
+	//
+	// Zones are placed with ENGINE_ZONE, which compiles to nothing unless ENGINE_PROFILE is defined.
+	class CpuProfiler {
+		public:
+			// per thread, older zones are overwritten
+			static constexpr size_t ZONES_PER_THREAD = 16384;
+
+			// nanoseconds on the steady clock since the first call
+			static int64_t now();
+			// the name must outlive the profiler, as string literals do
+			static void record(const char* name, int64_t begin_ns, int64_t end_ns);
+			// shown as the thread's track name in the trace
+			static void setThreadName(const char* name);
+			// Writes the zones still held by every ring. Returns false when the file cannot be written.
+			static bool writeChromeTrace(const std::string& path);
+			[[nodiscard]] static bool compiledIn();
+	};
+
+	// Records the time between its construction and destruction as one zone
+	class CpuZone {
+		public:
+			explicit CpuZone(const char* name) : name_ { name }, beginNs_ { CpuProfiler::now() } {}
+			~CpuZone() { CpuProfiler::record(name_, beginNs_, CpuProfiler::now()); }
+			CpuZone(const CpuZone&) = delete;
+			CpuZone& operator=(const CpuZone&) = delete;
+			CpuZone(const CpuZone&&) = delete;
+			CpuZone&& operator=(const CpuZone&&) = delete;
+
+		private:
+			const char* name_;
+			int64_t beginNs_;
+	};
+
+}
+
+#define ENGINE_ZONE_CONCAT_INNER(a, b) a##b
+#define ENGINE_ZONE_CONCAT(a, b) ENGINE_ZONE_CONCAT_INNER(a, b)
+
+#ifdef ENGINE_PROFILE
+#define ENGINE_ZONE(name) const engine::CpuZone ENGINE_ZONE_CONCAT(engine_zone_, __COUNTER__) { name }
+#define ENGINE_THREAD_NAME(name) engine::CpuProfiler::setThreadName(name)
+#else
+#define ENGINE_ZONE(name) static_cast<void>(0)
+#define ENGINE_THREAD_NAME(name) static_cast<void>(0)
+#endif
+
+#endif // CPU_PROFILER_HPP
@@ -0,0 +1,45 @@
+#ifndef DEFERRED_RENDER_SYSTEM_HPP
+#define DEFERRED_RENDER_SYSTEM_HPP
+
+#include "engine_device.hpp"
+#include "descriptor.hpp"
+#include "frame_info.hpp"
+#include "pipeline_factory.hpp"
+#include "swap_chain.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace engine {
+
+	// Lighting subpass of the deferred path: one fullscreen triangle reads albedo, normal and depth as
+	// input attachments and shades each pixel with the lights of its cluster.
+	class DeferredRenderSystem {
+		public:
+			DeferredRenderSystem(EngineDevice& device, PipelineFactory& pipelines, VkRenderPass render_pass, VkDescriptorSetLayout global_set_layout);
+			~DeferredRenderSystem();
+
+			DeferredRenderSystem(const DeferredRenderSystem&) = delete;
+			DeferredRenderSystem &operator=(const DeferredRenderSystem&) = delete;
+			DeferredRenderSystem(const DeferredRenderSystem&&) = delete;
+			DeferredRenderSystem &&operator=(const DeferredRenderSystem&&) = delete;
+
+			// call inside the lighting subpass
+			void render(FrameInfo& frame_info, const GBufferViews& g_buffer);
+
+		private:
+			EngineDevice& device_;
+			PendingPipeline pipeline_;
+			VkPipelineLayout pipelineLayout_;
+			std::unique_ptr<DescriptorSetLayout> inputSetLayout_;
+			std::unique_ptr<DescriptorPool> inputPool_;
+			std::vector<VkDescriptorSet> inputDescriptorSets_;
+
+			void createInputSets();
+			void createPipelineLayout(VkDescriptorSetLayout global_set_layout);
+			void createPipeline(PipelineFactory& pipelines, VkRenderPass render_pass);
+	};
+
+}
+
+#endif // DEFERRED_RENDER_SYSTEM_HPP
@@ -2,6 +2,7 @@
 #define DESCRIPTOR_HPP
 
 #include <memory>
+#include <memory_resource>
 #include <unordered_map>
 #include <vector>
 
@@ -15,16 +16,23 @@ namespace engine {
 				public:
 					explicit Builder(EngineDevice& device) : device_ { device } {}
 
-					Builder& addBinding(uint32_t binding, VkDescriptorType desc_type, VkShaderStageFlags stage_flags, uint32_t count = 1);
+					Builder& addBinding(uint32_t binding, VkDescriptorType desc_type, VkShaderStageFlags stage_flags, uint32_t count = 1, VkDescriptorBindingFlags binding_flags = 0);
+					Builder& layoutFlags(VkDescriptorSetLayoutCreateFlags flags);
 					[[nodiscard]] std::unique_ptr<DescriptorSetLayout> build() const;
 
 				private:
 					EngineDevice& device_; // NOLINT
 					std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings_ {};
+					std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags_ {};
+					VkDescriptorSetLayoutCreateFlags layoutFlags_ = 0;
 
 			};
 
-			DescriptorSetLayout(EngineDevice& device, const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding>& bindings);
+			DescriptorSetLayout(
+				EngineDevice& device,
+				const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding>& bindings,
+				const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& binding_flags = {},
+				VkDescriptorSetLayoutCreateFlags layout_flags = 0);
 			~DescriptorSetLayout();
 			DescriptorSetLayout(const DescriptorSetLayout&) = delete;
 			DescriptorSetLayout& operator=(const DescriptorSetLayout&) = delete;
@@ -79,9 +87,10 @@ namespace engine {
 
 	class DescriptorWriter {
 		public:
-			DescriptorWriter(DescriptorSetLayout& set_layout, DescriptorPool& pool);
-			DescriptorWriter& writeBuffer(uint32_t binding, VkDescriptorBufferInfo* buffer_info);
-			DescriptorWriter& writeImage(uint32_t binding, VkDescriptorImageInfo* image_info);
+			// writes are collected in scratch, pass a FrameArena when writing from the frame loop
+			DescriptorWriter(DescriptorSetLayout& set_layout, DescriptorPool& pool, std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+			DescriptorWriter& writeBuffer(uint32_t binding, VkDescriptorBufferInfo* buffer_info, uint32_t array_element = 0);
+			DescriptorWriter& writeImage(uint32_t binding, VkDescriptorImageInfo* image_info, uint32_t array_element = 0);
 
 			bool build(VkDescriptorSet& set);
 			void overwrite(VkDescriptorSet& set);
@@ -89,7 +98,7 @@ namespace engine {
 		private:
 			DescriptorSetLayout& setLayout_;
 			DescriptorPool& pool_;
-			std::vector<VkWriteDescriptorSet> writes_;
+			std::pmr::vector<VkWriteDescriptorSet> writes_;
 	};
 
 }
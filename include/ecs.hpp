@@ -0,0 +1,294 @@
+#ifndef ECS_HPP
+#define ECS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "entity_allocator.hpp"
+
+namespace engine {
+
+	class ComponentPoolBase {
+		public:
+			ComponentPoolBase() = default;
+			virtual ~ComponentPoolBase() = default;
+			ComponentPoolBase(const ComponentPoolBase&) = delete;
+			ComponentPoolBase& operator=(const ComponentPoolBase&) = delete;
+			ComponentPoolBase(ComponentPoolBase&&) = delete;
+			ComponentPoolBase& operator=(ComponentPoolBase&&) = delete;
+
+			// the dense entry holds the full handle, so a stale generation does not match
+			[[nodiscard]] bool contains(Entity entity) const {
+				const uint32_t index = entityIndex(entity);
+				return index < sparse_.size() && sparse_[index] != NULL_INDEX && dense_[sparse_[index]] == entity;
+			}
+			[[nodiscard]] size_t size() const { return dense_.size(); }
+			[[nodiscard]] const std::vector<Entity>& entities() const { return dense_; }
+
+			virtual void remove(Entity entity) = 0;
+
+		protected:
+			static constexpr uint32_t NULL_INDEX = std::numeric_limits<uint32_t>::max();
+
+			// indexed by entityIndex(), holds the dense slot
+			std::vector<uint32_t> sparse_ {};
+			std::vector<Entity> dense_ {};
+
+			void growSparse(uint32_t index) {
+				if (index >= sparse_.size()) {
+					sparse_.resize(static_cast<size_t>(index) + 1, NULL_INDEX);
+				}
+			}
+
+			uint32_t insertEntity(Entity entity) {
+				const uint32_t index = entityIndex(entity);
+				growSparse(index);
+				assert(sparse_[index] == NULL_INDEX && "Entity already has this component"); // NOLINT
+				auto idx = static_cast<uint32_t>(dense_.size());
+				sparse_[index] = idx;
+				dense_.push_back(entity);
+				return idx;
+			}
+
+			// swap-and-pop keeps the dense arrays packed; returns the index that was vacated
+			uint32_t eraseEntity(Entity entity) {
+				assert(contains(entity) && "Entity does not have this component"); // NOLINT
+				const uint32_t idx = sparse_[entityIndex(entity)];
+				const Entity last = dense_.back();
+				dense_[idx] = last;
+				sparse_[entityIndex(last)] = idx;
+				dense_.pop_back();
+				sparse_[entityIndex(entity)] = NULL_INDEX;
+				return idx;
+			}
+	};
+
+	// Sparse set storage: components of one type live in a dense array parallel to the owning
+	// entities, and the sparse array maps an entity to its dense slot with a single indexed load.
+	template<typename T>
+	class ComponentPool final : public ComponentPoolBase {
+		public:
+			template<typename... Args>
+			T& emplace(Entity entity, Args&&... args) {
+				insertEntity(entity);
+				components_.push_back(T { std::forward<Args>(args)... });
+				return components_.back();
+			}
+
+			// Appends default constructed components for all entities at once and returns the first of
+			// them, laid out in the same order as entities, for the caller to fill in place
+			T* emplaceBatch(const Entity* entities, size_t count) {
+				const auto first = static_cast<uint32_t>(dense_.size());
+				uint32_t max_index = 0;
+				for (size_t i = 0; i < count; i++) {
+					max_index = std::max(max_index, entityIndex(entities[i]));
+				}
+				growSparse(max_index);
+				dense_.insert(dense_.end(), entities, entities + count);
+				for (size_t i = 0; i < count; i++) {
+					const uint32_t index = entityIndex(entities[i]);
+					assert(sparse_[index] == NULL_INDEX && "Entity already has this component"); // NOLINT
+					sparse_[index] = first + static_cast<uint32_t>(i);
+				}
+				components_.resize(components_.size() + count);
+				return components_.data() + first;
+			}
+
+			void remove(Entity entity) override {
+				const uint32_t idx = eraseEntity(entity);
+				if (idx + 1 != components_.size()) {
+					components_[idx] = std::move(components_.back());
+				}
+				components_.pop_back();
+			}
+
+			void reserve(size_t count) {
+				dense_.reserve(count);
+				components_.reserve(count);
+			}
+
+			T& get(Entity entity) {
+				assert(contains(entity) && "Entity does not have this component"); // NOLINT
+				return components_[sparse_[entityIndex(entity)]];
+			}
+
+			const T& get(Entity entity) const {
+				assert(contains(entity) && "Entity does not have this component"); // NOLINT
+				return components_[sparse_[entityIndex(entity)]];
+			}
+
+			T* tryGet(Entity entity) {
+				return contains(entity) ? &components_[sparse_[entityIndex(entity)]] : nullptr;
+			}
+
+			std::vector<T>& components() { return components_; }
+			[[nodiscard]] const std::vector<T>& components() const { return components_; }
+
+		private:
+			std::vector<T> components_ {};
+	};
+
+	// Entity handles come from an EntityAllocator, so create() and createBatch() are safe to call from
+	// worker threads. Component pools are not: attach components, and apply destroyQueued(), on the
+	// thread that owns the registry.
+	class Registry {
+		public:
+			Registry() = default;
+			virtual ~Registry() = default;
+			Registry(const Registry&) = delete;
+			Registry& operator=(const Registry&) = delete;
+			Registry(Registry&&) = default;
+			Registry& operator=(Registry&&) = default;
+
+			Entity create() { return entities_->create(); }
+
+			void createBatch(Entity* entities, size_t count) { entities_->create(entities, count); }
+
+			// stale handles are ignored, their index may already belong to another entity
+			virtual void destroy(Entity entity) {
+				if (!alive(entity)) {
+					return;
+				}
+				for (auto& pool : pools_) {
+					if (pool != nullptr && pool->contains(entity)) {
+						pool->remove(entity);
+					}
+				}
+				entities_->destroy(entity);
+			}
+
+			// thread-safe; the entity stays alive until destroyQueued() runs
+			void queueDestroy(Entity entity) {
+				const std::lock_guard<std::mutex> lock { *destroyMutex_ };
+				destroyQueue_.push_back(entity);
+			}
+
+			void destroyQueued() {
+				std::vector<Entity> queue {};
+				{
+					const std::lock_guard<std::mutex> lock { *destroyMutex_ };
+					queue.swap(destroyQueue_);
+				}
+				for (const Entity entity : queue) {
+					destroy(entity);
+				}
+			}
+
+			[[nodiscard]] bool alive(Entity entity) const { return entities_->alive(entity); }
+			[[nodiscard]] size_t size() const { return entities_->size(); }
+
+			template<typename T, typename... Args>
+			T& emplace(Entity entity, Args&&... args) {
+				return pool<T>().emplace(entity, std::forward<Args>(args)...);
+			}
+
+			template<typename T>
+			void remove(Entity entity) {
+				pool<T>().remove(entity);
+			}
+
+			template<typename T>
+			[[nodiscard]] bool has(Entity entity) const {
+				const auto* component_pool = findPool<T>();
+				return component_pool != nullptr && component_pool->contains(entity);
+			}
+
+			template<typename T>
+			T& get(Entity entity) {
+				return pool<T>().get(entity);
+			}
+
+			template<typename T>
+			T* tryGet(Entity entity) {
+				return pool<T>().tryGet(entity);
+			}
+
+			template<typename T>
+			ComponentPool<T>& pool() {
+				const size_t idx = typeIndex<T>();
+				if (idx >= pools_.size()) {
+					pools_.resize(idx + 1);
+				}
+				if (pools_[idx] == nullptr) {
+					pools_[idx] = std::make_unique<ComponentPool<T>>();
+				}
+				return static_cast<ComponentPool<T>&>(*pools_[idx]);
+			}
+
+			// Calls func(entity, components...) for every entity owning all of Ts. A single component
+			// is a linear walk over its dense arrays; otherwise the smallest pool drives the iteration.
+			// Components must not be added or removed from the visited pools inside func.
+			template<typename... Ts, typename Func>
+			void each(Func&& func) {
+				static_assert(sizeof...(Ts) > 0, "each needs at least one component type");
+				if constexpr (sizeof...(Ts) == 1) {
+					eachSingle<Ts...>(func);
+				} else {
+					std::array<ComponentPoolBase*, sizeof...(Ts)> pools { &pool<Ts>()... };
+					const ComponentPoolBase* driver = pools[0];
+					for (const auto* candidate : pools) {
+						if (candidate->size() < driver->size()) {
+							driver = candidate;
+						}
+					}
+					auto pool_refs = std::tuple<ComponentPool<Ts>&...> { pool<Ts>()... };
+					for (const Entity entity : driver->entities()) {
+						bool matches = true;
+						for (const auto* candidate : pools) {
+							matches = matches && candidate->contains(entity);
+						}
+						if (matches) {
+							func(entity, std::get<ComponentPool<Ts>&>(pool_refs).get(entity)...);
+						}
+					}
+				}
+			}
+
+		private:
+			std::vector<std::unique_ptr<ComponentPoolBase>> pools_ {};
+			// behind pointers so the registry stays movable
+			std::unique_ptr<EntityAllocator> entities_ = std::make_unique<EntityAllocator>();
+			std::unique_ptr<std::mutex> destroyMutex_ = std::make_unique<std::mutex>();
+			std::vector<Entity> destroyQueue_ {};
+
+			static size_t nextTypeIndex() {
+				static size_t counter = 0;
+				return counter++;
+			}
+
+			template<typename T>
+			static size_t typeIndex() {
+				static const size_t idx = nextTypeIndex();
+				return idx;
+			}
+
+			template<typename T>
+			const ComponentPool<T>* findPool() const {
+				const size_t idx = typeIndex<T>();
+				if (idx >= pools_.size()) {
+					return nullptr;
+				}
+				return static_cast<const ComponentPool<T>*>(pools_[idx].get());
+			}
+
+			template<typename T, typename Func>
+			void eachSingle(Func& func) {
+				auto& component_pool = pool<T>();
+				const auto& entities = component_pool.entities();
+				auto& components = component_pool.components();
+				for (size_t i = 0; i < entities.size(); i++) {
+					func(entities[i], components[i]);
+				}
+			}
+	};
+
+}
+
+#endif // ECS_HPP
@@ -1,9 +1,12 @@
 #ifndef ENGINE_DEVICE_HPP
 #define ENGINE_DEVICE_HPP
 
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "metrics_writer.hpp"
+#include "render_counters.hpp"
 #include "window.hpp"
 #include <vulkan/vulkan_beta.h>
 
@@ -15,6 +18,20 @@ namespace engine {
 		std::vector<VkPresentModeKHR> presentModes;
 	};
 
+	// the descriptor indexing features BindlessHeap needs; devices without them are not picked
+	struct BindlessSupport {
+		bool supported = false;
+		uint32_t maxStorageBuffers = 0;
+		uint32_t maxSampledImages = 0;
+	};
+
+	// pipelines created through the device's cache since startup
+	struct PipelineCacheStats {
+		bool warm = false; // the cache was loaded from a file written by the same device and driver
+		uint32_t pipelines = 0;
+		double creationMs = 0.0;
+	};
+
 	struct QueueFamilyIndices {
 		uint32_t graphicsFamily = { 0 };
 		uint32_t presentFamily = { 0 };
@@ -27,6 +44,8 @@ namespace engine {
 
 	class EngineDevice {
 		public:
+			static constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
 #ifdef NDEBUG
 			const bool enabledValidationLayers = false;
 #else
@@ -34,7 +53,9 @@ namespace engine {
 #endif
 			VkPhysicalDeviceProperties properties;
 
-			explicit EngineDevice(Window& window);
+			// Without a window the device is headless: no surface is created, the present queue is the
+			// graphics queue and the swap chain extension is not required.
+			explicit EngineDevice(Window* window);
 			~EngineDevice();
 
 			EngineDevice(const EngineDevice&) = delete;
@@ -45,32 +66,59 @@ namespace engine {
 			VkCommandPool commandPool() { return commandPool_; }
 			VkDevice device() { return device_; }
 			VkSurfaceKHR surface() { return surface_; }
+			[[nodiscard]] bool headless() const { return window_ == nullptr; }
 			VkQueue graphicsQueue() { return graphicsQueue_; }
 			VkQueue presentQueue() { return presentQueue_; }
+			[[nodiscard]] const BindlessSupport& bindlessSupport() const { return bindlessSupport_; }
+			// the pipelineStatisticsQuery feature, enabled when present
+			[[nodiscard]] bool pipelineStatisticsSupported() const { return pipelineStatisticsSupported_; }
+			// work issued through this device, see RenderCounters
+			RenderCounters& counters() { return counters_; }
+			// size of every memory heap, plus budget and usage where VK_EXT_memory_budget is available
+			void collectTelemetry(MetricsWriter& metrics);
+			VkPipelineCache pipelineCache() { return pipelineCache_; }
+			[[nodiscard]] PipelineCacheStats pipelineCacheStats() const;
+			// called by Pipeline after each creation, possibly from several threads
+			void recordPipelineCreation(double ms);
+			// writes the pipeline cache to PIPELINE_CACHE_PATH; also done on destruction
+			void savePipelineCache();
 			SwapChainSupportDetails swapChainSupport();
 			uint32_t findMemoryType(uint32_t type_filter, VkMemoryPropertyFlags properties);
+			bool hasMemoryType(uint32_t type_filter, VkMemoryPropertyFlags properties);
 			QueueFamilyIndices findPhysicalQueueFamilies();
+			// valid bits of timestamps written on the graphics queue, 0 when it cannot write them
+			uint32_t graphicsTimestampValidBits();
 			VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 			void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buf, VkDeviceMemory& buf_memory);
 			VkCommandBuffer beginSingleTimeCommands();
 			void endSingleTimeCommands(VkCommandBuffer command_buf);
 			void copyBuffer(VkBuffer src_buf, VkBuffer dst_buf, VkDeviceSize size);
 			void copyBufferToImage(VkBuffer buf, VkImage image, uint32_t width, uint32_t height, uint32_t layer_count);
-			void createImageWithInfo(const VkImageCreateInfo& image_info, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& image_memory);
+			// preferred properties are added to the required ones when the image can live in such memory
+			void createImageWithInfo(const VkImageCreateInfo& image_info, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& image_memory, VkMemoryPropertyFlags preferred_properties = 0);
 
 
 		private:
-			Window& window_;
+			Window* window_;
 			VkCommandPool commandPool_;
 			VkDevice device_;
-			VkSurfaceKHR surface_;
+			VkSurfaceKHR surface_ = VK_NULL_HANDLE;
 			VkQueue graphicsQueue_;
 			VkQueue presentQueue_;
 			VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
 			const std::vector<const char*> validationLayers_ = { "VK_LAYER_KHRONOS_validation" }; // NOLINT
 			const std::vector<const char*> deviceExtensions_ = { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME }; // NOLINT
+			// what is actually enabled: all of the above with a window, only portability subset where present without
+			std::vector<const char*> enabledDeviceExtensions_ {};
 			VkInstance instance_;
 			VkDebugUtilsMessengerEXT debugMessenger_;
+			BindlessSupport bindlessSupport_ {};
+			bool pipelineStatisticsSupported_ = false;
+			bool memoryBudgetSupported_ = false;
+			RenderCounters counters_ {};
+			VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+			PipelineCacheStats pipelineCacheStats_ {};
+			mutable std::mutex pipelineCacheStatsMutex_ {};
 
 
 			SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice physicalDevice);
@@ -80,6 +128,9 @@ namespace engine {
 			void pickPhysicalDevice();
 			void createLogicalDevice();
 			void createCommandPool();
+			void createPipelineCache();
+			std::vector<char> loadPipelineCacheData();
+			static BindlessSupport queryBindlessSupport(VkPhysicalDevice device);
 			bool isDeviceSuitable(VkPhysicalDevice device);
 			std::vector<const char*> getRequiredExtensions();
 			bool checkValidationLayerSupport();
@@ -87,6 +138,7 @@ namespace engine {
 			void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& create_info);
 			void hasGLFWRequiredInstanceExtensions();
 			bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+			std::vector<const char*> requiredDeviceExtensions(VkPhysicalDevice device);
 
 	};
 }
@@ -0,0 +1,136 @@
+#ifndef ENTITY_ALLOCATOR_HPP
+#define ENTITY_ALLOCATOR_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace engine {
+
+	// An entity is a generational handle: the low bits index a slot and the high bits hold the slot's
+	// generation when the handle was issued. Destroying an entity bumps the generation, so handles
+	// kept after destruction are detected as stale even once the slot is reused.
+	using Entity = uint32_t;
+	constexpr Entity NULL_ENTITY = std::numeric_limits<Entity>::max();
+
+	constexpr uint32_t ENTITY_INDEX_BITS = 24;
+	constexpr uint32_t ENTITY_INDEX_MASK = (1U << ENTITY_INDEX_BITS) - 1;
+
+	constexpr uint32_t entityIndex(Entity entity) { return entity & ENTITY_INDEX_MASK; }
+	constexpr uint32_t entityGeneration(Entity entity) { return entity >> ENTITY_INDEX_BITS; }
+	constexpr Entity makeEntity(uint32_t index, uint32_t generation) { return (generation << ENTITY_INDEX_BITS) | index; }
+
+	// Issues and recycles entity handles. create() and destroy() may be called from several threads;
+	// the batch versions take the lock once for the whole batch. alive() never locks: slot state lives
+	// in fixed pages that are never moved, published through atomic pointers, so checking a handle is
+	// two acquire loads.
+	class EntityAllocator {
+		public:
+			// the last index is reserved so that no handle equals NULL_ENTITY
+			static constexpr uint32_t MAX_ENTITIES = ENTITY_INDEX_MASK;
+
+			EntityAllocator() = default;
+			~EntityAllocator() = default;
+			EntityAllocator(const EntityAllocator&) = delete;
+			EntityAllocator& operator=(const EntityAllocator&) = delete;
+			EntityAllocator(const EntityAllocator&&) = delete;
+			EntityAllocator&& operator=(const EntityAllocator&&) = delete;
+
+			Entity create() {
+				Entity entity = NULL_ENTITY;
+				create(&entity, 1);
+				return entity;
+			}
+
+			// throws before creating any entity when the batch does not fit below MAX_ENTITIES
+			void create(Entity* entities, size_t count) {
+				const std::lock_guard<std::mutex> lock { mutex_ };
+				const size_t fresh = count > freeList_.size() ? count - freeList_.size() : 0;
+				if (fresh > MAX_ENTITIES - nextIndex_) {
+					throw std::runtime_error("failed to create entities, limit reached");
+				}
+				for (size_t i = 0; i < count; i++) {
+					uint32_t index = 0;
+					if (!freeList_.empty()) {
+						index = freeList_.back();
+						freeList_.pop_back();
+					} else {
+						index = nextIndex_++;
+						ensurePage(index);
+					}
+					auto& state = slot(index);
+					const uint32_t generation = state.load(std::memory_order_relaxed) & GENERATION_MASK;
+					state.store(ALIVE_BIT | generation, std::memory_order_release);
+					entities[i] = makeEntity(index, generation);
+				}
+				alive_.fetch_add(count, std::memory_order_relaxed);
+			}
+
+			void destroy(Entity entity) { destroy(&entity, 1); }
+
+			// stale and null handles are skipped, so a slot can never be freed twice
+			void destroy(const Entity* entities, size_t count) {
+				const std::lock_guard<std::mutex> lock { mutex_ };
+				size_t destroyed = 0;
+				for (size_t i = 0; i < count; i++) {
+					if (!alive(entities[i])) {
+						continue;
+					}
+					const uint32_t index = entityIndex(entities[i]);
+					// generations wrap after 256 reuses of a slot
+					slot(index).store((entityGeneration(entities[i]) + 1) & GENERATION_MASK, std::memory_order_release);
+					freeList_.push_back(index);
+					destroyed++;
+				}
+				alive_.fetch_sub(destroyed, std::memory_order_relaxed);
+			}
+
+			[[nodiscard]] bool alive(Entity entity) const {
+				if (entity == NULL_ENTITY) {
+					return false;
+				}
+				const uint32_t index = entityIndex(entity);
+				const std::atomic<uint16_t>* page = pages_[index / PAGE_SIZE].load(std::memory_order_acquire); // NOLINT
+				if (page == nullptr) {
+					return false;
+				}
+				return page[index % PAGE_SIZE].load(std::memory_order_acquire) == (ALIVE_BIT | entityGeneration(entity));
+			}
+
+			[[nodiscard]] size_t size() const { return alive_.load(std::memory_order_relaxed); }
+
+		private:
+			static constexpr uint32_t PAGE_SIZE = 4096;
+			static constexpr uint32_t PAGE_COUNT = (MAX_ENTITIES + PAGE_SIZE) / PAGE_SIZE;
+			static constexpr uint16_t GENERATION_MASK = 0xFF;
+			static constexpr uint16_t ALIVE_BIT = 0x100;
+
+			// per slot: ALIVE_BIT | current generation. Pages are owned by pageStorage_, which only the
+			// lock holder touches; pages_ publishes them to alive() with a release store.
+			std::array<std::unique_ptr<std::atomic<uint16_t>[]>, PAGE_COUNT> pageStorage_ {};
+			std::array<std::atomic<std::atomic<uint16_t>*>, PAGE_COUNT> pages_ {};
+			std::vector<uint32_t> freeList_ {};
+			uint32_t nextIndex_ = 0;
+			std::atomic<size_t> alive_ = 0;
+			std::mutex mutex_ {};
+
+			// only with the lock held
+			std::atomic<uint16_t>& slot(uint32_t index) { return pageStorage_[index / PAGE_SIZE][index % PAGE_SIZE]; } // NOLINT
+
+			void ensurePage(uint32_t index) {
+				auto& page = pageStorage_[index / PAGE_SIZE]; // NOLINT
+				if (page == nullptr) {
+					page = std::make_unique<std::atomic<uint16_t>[]>(PAGE_SIZE);
+					pages_[index / PAGE_SIZE].store(page.get(), std::memory_order_release); // NOLINT
+				}
+			}
+	};
+
+}
+
+#endif // ENTITY_ALLOCATOR_HPP
@@ -0,0 +1,52 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace engine {
+
+	// Linear allocator for temporaries that live until the end of the frame. Allocation bumps an
+	// offset, deallocation does nothing and reset() releases everything at once. A frame that needs
+	// more than the capacity gets its overflow from the heap; reset() then grows the block to the
+	// frame's peak, so only the first frames of a heavier workload allocate.
+	//
+	// As a memory_resource it backs std::pmr containers: std::pmr::vector<T> v { &arena };
+	class FrameArena : public std::pmr::memory_resource {
+		public:
+			static constexpr size_t DEFAULT_CAPACITY = 256 * 1024;
+
+			explicit FrameArena(size_t capacity = DEFAULT_CAPACITY);
+			~FrameArena() override = default;
+			FrameArena(const FrameArena&) = delete;
+			FrameArena& operator=(const FrameArena&) = delete;
+			FrameArena(const FrameArena&&) = delete;
+			FrameArena&& operator=(const FrameArena&&) = delete;
+
+			// invalidates everything allocated since the last reset
+			void reset();
+
+			[[nodiscard]] size_t capacity() const { return capacity_; }
+			// bytes handed out since the last reset, including overflow
+			[[nodiscard]] size_t used() const { return offset_ + overflowBytes_; }
+			// the most used by any frame so far
+			[[nodiscard]] size_t peak() const { return peak_; }
+
+		private:
+			std::unique_ptr<std::byte[]> block_; // NOLINT
+			size_t capacity_;
+			size_t offset_ = 0;
+			std::vector<std::unique_ptr<std::byte[]>> overflow_ {}; // NOLINT
+			size_t overflowBytes_ = 0;
+			size_t peak_ = 0;
+
+			void* do_allocate(size_t bytes, size_t alignment) override;
+			void do_deallocate(void* /*p*/, size_t /*bytes*/, size_t /*alignment*/) override {}
+			[[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+	};
+
+}
+
+#endif // FRAME_ARENA_HPP
@@ -2,6 +2,9 @@
 #define FRAME_INFO_HPP
 
 #include "camera.hpp"
+#include "frame_arena.hpp"
+#include "pipeline_statistics.hpp"
+#include "render_counters.hpp"
 #include <scene_object.hpp>
 
 #include <vulkan/vulkan.h>
@@ -14,14 +17,33 @@ namespace engine {
 		VkCommandBuffer cmdBuf;
 		Camera& camera;
 		VkDescriptorSet globalDescriptorSet;
-		SceneObject::Map& sceneObjects;
+		VkDescriptorSet bindlessDescriptorSet; // BindlessHeap, bound at BindlessHeap::SET
+		Scene& scene;
+		FrameArena& frameArena; // temporaries that only live until the frame is submitted
+	};
+
+	// where one iteration of the frame loop spent its time, in milliseconds
+	struct FrameStats {
+		uint32_t frame = 0;
+		double frameMs = 0.0;
+		double acquireMs = 0.0; // waiting for the frame slot's fence and the next image
+		double updateMs = 0.0; // lights, transforms, clusters and the uniform upload
+		double shadowMs = 0.0; // shadow atlas recording
+		double recordMs = 0.0; // main pass recording
+		double submitMs = 0.0; // submit and present
+		double fenceWaitMs = 0.0; // part of acquire and submit spent waiting for the GPU, see SwapChain::fenceWaitMs
+		uint32_t shadowViews = 0;
+		FrameCounters counters {};
+		GpuStatistics gpuStatistics {}; // of an earlier frame, see PipelineStatistics
+		uint64_t allocations = 0; // operator new calls on the frame loop's thread, see AllocationTracker
 	};
 
 	const float INTENSITY = 0.02F;
-	const int MAX_LIGHTS = 10;
 
+	// storage buffer layout shared with the lighting and billboard shaders; the range is not stored
+	// since it follows from the intensity, see PointLightComponent::range
 	struct PointLight {
-		glm::vec4 position {}; // ignore w
+		glm::vec4 position {}; // w is billboard radius
 		glm::vec4 color {}; // w is intensity
 	};
 
@@ -30,8 +52,8 @@ namespace engine {
 		glm::mat4 view { 1.F };
 		glm::mat4 inverseView { 1.0F };
 		glm::vec4 ambientLightColor { 1.F, 1.F, 1.F, INTENSITY };
-		std::array<PointLight, MAX_LIGHTS> pointLights;
-		int lightsNum;
+		glm::vec4 clusterScale {}; // see LightClusters::shaderScale
+		glm::uvec4 clusterDims {}; // cluster grid size, w is the light count
 	};
 
 }
@@ -0,0 +1,81 @@
+#ifndef FRAME_READBACK_HPP
+#define FRAME_READBACK_HPP
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer.hpp"
+#include "engine_device.hpp"
+
+namespace engine {
+
+	// Copies finished offscreen frames into host visible buffers and writes them to disk as binary PPM
+	// files. The copy is recorded into the frame's own command buffer and only read once that frame
+	// slot's fence has signaled again, so rendering never waits on the GPU for it; encoding and file
+	// writes happen on a background thread.
+	class FrameReadback {
+		public:
+			// frames queued for the writer before collect() starts waiting on it
+			static constexpr size_t MAX_QUEUED_FRAMES = 8;
+
+			FrameReadback(EngineDevice& device, VkExtent2D extent, std::string directory);
+			// writes every frame already collected; call collectAll() first to include those in flight
+			~FrameReadback();
+			FrameReadback(const FrameReadback&) = delete;
+			FrameReadback& operator=(const FrameReadback&) = delete;
+			FrameReadback(const FrameReadback&&) = delete;
+			FrameReadback&& operator=(const FrameReadback&&) = delete;
+
+			// Records the copy of an R8G8B8A8 image in TRANSFER_SRC layout, outside of a render pass
+			void record(VkCommandBuffer command_buf, int frame_idx, VkImage image, uint64_t frame_number);
+			// hands the slot's frame to the writer; call once the slot's fence has been waited on
+			void collect(int frame_idx);
+			// collect() for every slot, the device must be idle
+			void collectAll();
+
+			[[nodiscard]] uint64_t framesWritten() const { return framesWritten_.load(std::memory_order_relaxed); }
+			// collected frames the writer has not finished yet
+			[[nodiscard]] size_t queuedFrames() const { return queueSize_.load(std::memory_order_relaxed); }
+
+		private:
+			struct Slot {
+				std::unique_ptr<Buffer> buffer;
+				bool pending = false;
+				uint64_t frameNumber = 0;
+			};
+
+			struct Frame {
+				uint64_t number = 0;
+				std::vector<uint8_t> pixels;
+			};
+
+			EngineDevice& device_;
+			VkExtent2D extent_;
+			std::string directory_;
+			std::vector<Slot> slots_ {};
+
+			std::mutex mutex_ {};
+			std::condition_variable queueChanged_ {};
+			// ring of frames with presized pixels, so capturing does not allocate on the frame loop;
+			// collect() fills the entry past the tail and the writer reads the head, both outside the lock
+			std::array<Frame, MAX_QUEUED_FRAMES> queue_ {};
+			size_t queueHead_ = 0;
+			// changed under the lock, atomic so that the getters can read them without it
+			std::atomic<size_t> queueSize_ { 0 };
+			std::atomic<uint64_t> framesWritten_ { 0 };
+			bool stopping_ = false;
+			std::thread writer_ {};
+
+			void writerLoop();
+			void writeFrame(const Frame& frame) const;
+	};
+
+}
+
+#endif // FRAME_READBACK_HPP
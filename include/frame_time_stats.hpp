@@ -0,0 +1,88 @@
+#ifndef FRAME_TIME_STATS_HPP
+#define FRAME_TIME_STATS_HPP
+
+#include <array>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include "frame_info.hpp"
+#include "latency_histogram.hpp"
+#include "metrics_writer.hpp"
+
+namespace engine {
+
+	// the timed parts of FrameStats
+	enum class FrameStage { Frame, Acquire, Update, Shadow, Record, Submit };
+	constexpr size_t FRAME_STAGE_COUNT = 6;
+
+	enum class HitchCause {
+		SwapChainRecreation,
+		ModelUpload,
+		FenceWait, // the CPU waited on the GPU for most of the extra time
+		Unattributed
+	};
+
+	const char* frameStageName(FrameStage stage);
+	const char* hitchCauseName(HitchCause cause);
+
+	struct Hitch {
+		uint32_t frame = 0;
+		double frameMs = 0.0;
+		double expectedMs = 0.0; // running average of the frames before it
+		HitchCause cause = HitchCause::Unattributed;
+		FrameStage stage = FrameStage::Frame; // the stage that ran furthest over its own average
+	};
+
+	// Histograms of frame and stage times over the current interval and since the last resetTotals(),
+	// plus hitch detection. A frame is a hitch when it takes HITCH_FACTOR times the running average and
+	// at least HITCH_MIN_MS more; it is attributed to the swap chain recreation or model upload that
+	// happened during it, else to fence waits if they cover half the extra time.
+	class FrameTimeStats {
+		public:
+			static constexpr double DEFAULT_INTERVAL_MS = 5000.0;
+			static constexpr double HITCH_FACTOR = 2.0;
+			static constexpr double HITCH_MIN_MS = 4.0;
+			static constexpr size_t MAX_HITCHES = 64;
+
+			explicit FrameTimeStats(double interval_ms = DEFAULT_INTERVAL_MS);
+
+			// returns the hitch when the frame was one
+			std::optional<Hitch> record(const FrameStats& stats);
+			// true after the record() that closed an interval, interval() then covers all of it
+			[[nodiscard]] bool intervalComplete() const { return intervalComplete_; }
+			void resetTotals();
+
+			[[nodiscard]] const LatencyHistogram& interval(FrameStage stage) const { return interval_[static_cast<size_t>(stage)]; }
+			[[nodiscard]] const LatencyHistogram& total(FrameStage stage) const { return total_[static_cast<size_t>(stage)]; }
+			[[nodiscard]] uint64_t hitchCount() const { return hitchCount_; }
+			[[nodiscard]] uint64_t hitchCount(HitchCause cause) const { return hitchCauses_[static_cast<size_t>(cause)]; }
+			// the last MAX_HITCHES since resetTotals(), oldest first
+			[[nodiscard]] const std::vector<Hitch>& recentHitches() const { return recentHitches_; }
+
+			// one line of interval percentiles and hitches
+			void writeSummary(std::ostream& out) const;
+			static void writeHitch(std::ostream& out, const Hitch& hitch);
+			// hitches since resetTotals() by cause
+			void collectTelemetry(MetricsWriter& metrics) const;
+
+		private:
+			static constexpr double AVERAGE_FACTOR = 0.05; // weight of the newest frame in the running averages
+			static constexpr size_t CAUSE_COUNT = 4;
+
+			double intervalMs_;
+			double intervalElapsedMs_ = 0.0;
+			bool intervalComplete_ = false;
+			std::array<LatencyHistogram, FRAME_STAGE_COUNT> interval_ {};
+			std::array<LatencyHistogram, FRAME_STAGE_COUNT> total_ {};
+			std::array<double, FRAME_STAGE_COUNT> averageMs_ {};
+			bool averaged_ = false;
+			uint64_t hitchCount_ = 0;
+			uint64_t intervalHitches_ = 0;
+			std::array<uint64_t, CAUSE_COUNT> hitchCauses_ {};
+			std::vector<Hitch> recentHitches_ {};
+	};
+
+}
+
+#endif // FRAME_TIME_STATS_HPP
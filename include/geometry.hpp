@@ -0,0 +1,62 @@
+#ifndef GEOMETRY_HPP
+#define GEOMETRY_HPP
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <array>
+#include <limits>
+
+namespace engine {
+
+	struct Aabb {
+		glm::vec3 min { std::numeric_limits<float>::max() };
+		glm::vec3 max { std::numeric_limits<float>::lowest() };
+
+		[[nodiscard]] bool valid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+		[[nodiscard]] glm::vec3 center() const { return (min + max) * 0.5F; }
+		[[nodiscard]] glm::vec3 extent() const { return (max - min) * 0.5F; }
+		[[nodiscard]] float surfaceArea() const;
+
+		void expand(const glm::vec3& point);
+		[[nodiscard]] Aabb merged(const Aabb& other) const;
+		[[nodiscard]] Aabb inflated(float margin) const;
+		// bounds of the eight transformed corners
+		[[nodiscard]] Aabb transformed(const glm::mat4& matrix) const;
+
+		[[nodiscard]] bool contains(const Aabb& other) const;
+		[[nodiscard]] bool intersects(const Aabb& other) const;
+
+		static Aabb fromCenter(const glm::vec3& center, const glm::vec3& extent) { return { center - extent, center + extent }; }
+	};
+
+	struct Sphere {
+		glm::vec3 center {};
+		float radius = 0.0F;
+
+		[[nodiscard]] bool intersects(const Aabb& box) const;
+	};
+
+	struct Ray {
+		glm::vec3 origin {};
+		glm::vec3 direction { 0.0F, 0.0F, 1.0F };
+
+		// slab test; on a hit t is the entry distance, clamped to 0 when the origin is inside
+		[[nodiscard]] bool intersects(const Aabb& box, float max_t, float& t) const;
+	};
+
+	// Planes point inwards as (normal, distance) so a point p is inside when dot(normal, p) + distance >= 0
+	struct Frustum {
+		std::array<glm::vec4, 6> planes {};
+
+		// Gribb-Hartmann extraction for the 0..1 clip space depth used with Vulkan
+		static Frustum fromMatrix(const glm::mat4& view_projection);
+
+		[[nodiscard]] bool intersects(const Aabb& box) const;
+		[[nodiscard]] bool intersects(const Sphere& sphere) const;
+	};
+
+}
+
+#endif // GEOMETRY_HPP
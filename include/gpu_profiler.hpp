@@ -0,0 +1,94 @@
+#ifndef GPU_PROFILER_HPP
+#define GPU_PROFILER_HPP
+
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "engine_device.hpp"
+
+namespace engine {
+
+	// Times named scopes of the frame's command buffer with timestamp queries. Every frame slot owns its
+	// own range of the query pool, so a slot's results are read when it comes around again, after its
+	// fence, and the CPU never waits on them. Scopes may nest and repeat; repeated scopes of one frame
+	// are summed. When the graphics queue cannot write timestamps every call is a no-op.
+	class GpuProfiler {
+		public:
+			static constexpr uint32_t MAX_SCOPES_PER_FRAME = 32;
+			static constexpr uint32_t INVALID_SCOPE = std::numeric_limits<uint32_t>::max();
+
+			struct Scope {
+				std::string name;
+				double lastMs = 0.0;
+				double smoothedMs = 0.0; // exponential moving average
+				double totalMs = 0.0; // since the last resetTotals()
+				uint32_t samples = 0;
+
+				[[nodiscard]] double meanMs() const { return samples == 0 ? 0.0 : totalMs / samples; }
+			};
+
+			explicit GpuProfiler(EngineDevice& device);
+			~GpuProfiler();
+			GpuProfiler(const GpuProfiler&) = delete;
+			GpuProfiler& operator=(const GpuProfiler&) = delete;
+			GpuProfiler(const GpuProfiler&&) = delete;
+			GpuProfiler&& operator=(const GpuProfiler&&) = delete;
+
+			// Reads back the scopes recorded the last time this frame slot was used and resets its
+			// queries. Call once the slot's fence has been waited on, outside of a render pass.
+			void beginFrame(VkCommandBuffer command_buf, int frame_idx);
+			// returns INVALID_SCOPE when disabled or out of queries, end() ignores it
+			uint32_t begin(VkCommandBuffer command_buf, const char* name);
+			void end(VkCommandBuffer command_buf, uint32_t scope);
+
+			[[nodiscard]] bool enabled() const { return queryPool_ != VK_NULL_HANDLE; }
+			// in order of first use
+			[[nodiscard]] const std::vector<Scope>& scopes() const { return scopes_; }
+			[[nodiscard]] const Scope* find(const std::string& name) const;
+			void resetTotals();
+			// scope,last_ms,smoothed_ms,mean_ms,samples
+			void writeCsv(std::ostream& out) const;
+
+		private:
+			// one begin/end pair recorded into a frame slot
+			struct Recorded {
+				uint32_t scope = 0;
+				uint32_t query = 0;
+			};
+
+			EngineDevice& device_;
+			VkQueryPool queryPool_ = VK_NULL_HANDLE;
+			double nsPerTick_ = 0.0;
+			uint64_t timestampMask_ = 0;
+			std::vector<Scope> scopes_ {};
+			std::vector<std::vector<Recorded>> recorded_ {};
+			std::vector<uint64_t> timestamps_ {};
+			std::vector<double> frameMs_ {};
+			int frameIdx_ = 0;
+
+			uint32_t scopeIndex(const char* name);
+			[[nodiscard]] static uint32_t firstQuery(int frame_idx) { return static_cast<uint32_t>(frame_idx) * 2 * MAX_SCOPES_PER_FRAME; }
+	};
+
+	// Brackets the commands recorded during its lifetime
+	class GpuScope {
+		public:
+			GpuScope(GpuProfiler& profiler, VkCommandBuffer command_buf, const char* name)
+				: profiler_ { profiler }, commandBuf_ { command_buf }, scope_ { profiler.begin(command_buf, name) } {}
+			~GpuScope() { profiler_.end(commandBuf_, scope_); }
+			GpuScope(const GpuScope&) = delete;
+			GpuScope& operator=(const GpuScope&) = delete;
+			GpuScope(const GpuScope&&) = delete;
+			GpuScope&& operator=(const GpuScope&&) = delete;
+
+		private:
+			GpuProfiler& profiler_;
+			VkCommandBuffer commandBuf_;
+			uint32_t scope_;
+	};
+
+}
+
+#endif // GPU_PROFILER_HPP
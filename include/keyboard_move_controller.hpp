@@ -25,7 +25,7 @@ namespace engine {
 			float moveSpeed { 3.0f };
 			float lookSpeed { 1.5f };
 
-			void moveInPlayeXZ(GLFWwindow* window, float dt, SceneObject& scene_object);
+			void moveInPlayeXZ(GLFWwindow* window, float dt, TransformComponent& transform);
 	};
 
 }
@@ -0,0 +1,44 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace engine {
+
+	// Log-linear histogram of durations in the style of HdrHistogram. Values are kept in microseconds:
+	// below 2^SUB_BUCKET_BITS every microsecond has its own bucket, above that every power of two is
+	// split into 2^(SUB_BUCKET_BITS - 1) buckets, so a percentile is within 1/64 of the recorded value.
+	// The buckets are a fixed array, recording never allocates. Values from about 67 s up are clamped.
+	class LatencyHistogram {
+		public:
+			static constexpr uint32_t SUB_BUCKET_BITS = 7;
+			static constexpr uint32_t MAX_EXPONENT = 26; // values up to 2^26 us
+
+			void record(double ms);
+			void reset();
+
+			[[nodiscard]] uint64_t count() const { return count_; }
+			// highest value of the bucket holding the nearest rank, 0 when empty
+			[[nodiscard]] double percentileMs(double fraction) const;
+			[[nodiscard]] double maxMs() const { return static_cast<double>(maxUs_) / 1000.0; } // NOLINT
+			[[nodiscard]] double meanMs() const { return count_ == 0 ? 0.0 : sumMs_ / static_cast<double>(count_); }
+
+		private:
+			static constexpr size_t SUB_BUCKETS = size_t { 1 } << SUB_BUCKET_BITS;
+			static constexpr size_t HALF_BUCKETS = SUB_BUCKETS / 2;
+			static constexpr size_t BUCKETS = SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS) * HALF_BUCKETS;
+
+			std::array<uint64_t, BUCKETS> counts_ {};
+			uint64_t count_ = 0;
+			uint64_t maxUs_ = 0;
+			double sumMs_ = 0.0;
+
+			static size_t bucketOf(uint64_t us);
+			static uint64_t highestOf(size_t bucket);
+	};
+
+}
+
+#endif // LATENCY_HISTOGRAM_HPP
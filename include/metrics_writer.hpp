@@ -0,0 +1,66 @@
+#ifndef METRICS_WRITER_HPP
+#define METRICS_WRITER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace engine {
+
+	enum class MetricKind { Counter, Gauge };
+
+	// a single name="value" label, the value is either text or a number
+	struct MetricLabel {
+		const char* name = nullptr; // nullptr for no label
+		const char* text = nullptr;
+		uint64_t number = 0;
+
+		MetricLabel() = default;
+		MetricLabel(const char* label_name, const char* label_text) : name { label_name }, text { label_text } {}
+		MetricLabel(const char* label_name, uint64_t label_number) : name { label_name }, number { label_number } {}
+	};
+
+	// Names, help texts and label texts must be string literals, or outlive every snapshot holding
+	// them; snapshots are copied between threads without their strings.
+	struct Metric {
+		const char* name = nullptr;
+		const char* help = nullptr;
+		MetricKind kind = MetricKind::Gauge;
+		double value = 0.0;
+		MetricLabel label {};
+	};
+
+	// Fixed size list of metrics that sources fill on the render thread. Adding never allocates;
+	// metrics past MAX_METRICS are dropped and counted. Metrics of one name should be added together.
+	class MetricsWriter {
+		public:
+			static constexpr size_t MAX_METRICS = 128;
+
+			void counter(const char* name, const char* help, double value, MetricLabel label = {}) { add({ name, help, MetricKind::Counter, value, label }); }
+			void gauge(const char* name, const char* help, double value, MetricLabel label = {}) { add({ name, help, MetricKind::Gauge, value, label }); }
+			void clear() {
+				count_ = 0;
+				dropped_ = 0;
+			}
+
+			[[nodiscard]] size_t size() const { return count_; }
+			[[nodiscard]] const Metric& operator[](size_t i) const { return metrics_[i]; }
+			[[nodiscard]] size_t dropped() const { return dropped_; }
+
+		private:
+			std::array<Metric, MAX_METRICS> metrics_ {};
+			size_t count_ = 0;
+			size_t dropped_ = 0;
+
+			void add(const Metric& metric) {
+				if (count_ == MAX_METRICS) {
+					dropped_++;
+					return;
+				}
+				metrics_[count_++] = metric;
+			}
+	};
+
+}
+
+#endif // METRICS_WRITER_HPP
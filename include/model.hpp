@@ -5,10 +5,12 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include <string>
 #include <vector>
 
 #include "engine_device.hpp"
 #include "buffer.hpp"
+#include "geometry.hpp"
 
 namespace engine {
 
@@ -31,6 +33,8 @@ namespace engine {
 			struct Builder {
 				std::vector<Vertex> vertices {};
 				std::vector<uint32_t> indices {};
+				// file the model was loaded from, empty for generated geometry
+				std::string path {};
 
 				void loadModel(const std::string &filepath);
 			};
@@ -44,7 +48,13 @@ namespace engine {
 			void bind(VkCommandBuffer command_buf);
 			void draw(VkCommandBuffer command_buf) const;
 
+			// object space bounds of the vertex positions
+			[[nodiscard]] const Aabb& bounds() const { return bounds_; }
+			[[nodiscard]] const std::string& path() const { return path_; }
+
 			static std::unique_ptr<Model> createModelFromFile(EngineDevice& device, const std::string& filepath);
+			// loads and uploads of every model so far; loads may run on several threads
+			static void collectTelemetry(MetricsWriter& metrics);
 
 		private:
 			EngineDevice& device_;
@@ -56,6 +66,9 @@ namespace engine {
 			std::unique_ptr<Buffer> indexBuffer_;
 			uint32_t indexCount_;
 
+			Aabb bounds_ {};
+			std::string path_;
+
 			void createVertexBuffers(const std::vector<Vertex>& vertices);
 			void createIndexBuffers(const std::vector<uint32_t>& indices);
 
@@ -22,11 +22,18 @@ namespace engine {
 		VkPipelineDynamicStateCreateInfo dynamamicStateInfo;
 		std::vector<VkVertexInputBindingDescription> bindingDescriptions {};
 		std::vector<VkVertexInputAttributeDescription> attributeDescriptions {};
+		// value of constant_id i for both stages; every constant is 32 bit (int, uint, float or bool)
+		std::vector<uint32_t> specializationConstants {};
+		// VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT / DERIVATIVE_BIT with basePipeline as the parent
+		VkPipelineCreateFlags createFlags = 0;
+		VkPipeline basePipeline = VK_NULL_HANDLE;
 	};
 
 	class Pipeline {
 		public:
 			Pipeline(EngineDevice& device, const std::string& vert_path, const std::string& frag_path, const PipelineConfigInfo& config_info);
+			// the modules stay owned by the caller and may be destroyed once the constructor returns
+			Pipeline(EngineDevice& device, VkShaderModule vert_module, VkShaderModule frag_module, const PipelineConfigInfo& config_info);
 			~Pipeline();
 			Pipeline(const Pipeline&) = delete;
 			Pipeline& operator=(const Pipeline&) = delete;
@@ -35,16 +42,16 @@ namespace engine {
 
 			static PipelineConfigInfo defaultPipelineConfigInfo();
 			void bind(VkCommandBuffer command_buffer);
+			[[nodiscard]] VkPipeline handle() const { return graphicsPipeline_; }
+
+			static std::vector<char> readFile(const std::string& filepath);
+			static VkShaderModule createShaderModule(EngineDevice& device, const std::vector<char>& code);
 
 		private:
 			EngineDevice& device_;
 			VkPipeline graphicsPipeline_;
-			VkShaderModule vertShaderModule_;
-			VkShaderModule fragShaderModule_;
 
-			static std::vector<char> readFile(const std::string& filepath);
-			void createGraphicsPipeline(const std::string& vert_path, const std::string& frag_path, const PipelineConfigInfo& config_info);
-			void createShaderModule(const std::vector<char>& code, VkShaderModule* shader_module);
+			void createGraphicsPipeline(VkShaderModule vert_module, VkShaderModule frag_module, const PipelineConfigInfo& config_info);
 	};
 }
 
@@ -0,0 +1,107 @@
+#ifndef PIPELINE_FACTORY_HPP
+#define PIPELINE_FACTORY_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "engine_device.hpp"
+#include "pipeline.hpp"
+
+namespace engine {
+
+	using SharedPipeline = std::shared_future<std::shared_ptr<Pipeline>>;
+
+	// A pipeline that may still be compiling on a PipelineFactory worker, possibly shared with other
+	// systems. The first access blocks until it is built and rethrows a failed creation; later accesses
+	// are free.
+	class PendingPipeline {
+		public:
+			PendingPipeline() = default;
+			explicit PendingPipeline(SharedPipeline future) : future_ { std::move(future) } {}
+
+			Pipeline& get();
+			Pipeline* operator->() { return &get(); }
+
+		private:
+			SharedPipeline future_ {};
+			std::shared_ptr<Pipeline> pipeline_ {};
+	};
+
+	// Builds pipelines on worker threads. Shader modules are shared between pipelines by SPIR-V content
+	// hash, so a vertex shader used by several systems is read and created once per batch.
+	//
+	// Pipelines are also registered by their full state: shader paths, every fixed function field of the
+	// config including the arrays it points to, the layout and the render pass and subpass. Asking for
+	// the same state again returns the existing pipeline. Render passes only count as compatible when
+	// they are the same handle. The first pipeline built for a layout and subpass allows derivatives
+	// and later ones derive from it, which lets drivers that support it share compiled state.
+	class PipelineFactory {
+		public:
+			explicit PipelineFactory(EngineDevice& device, uint32_t worker_count = std::thread::hardware_concurrency());
+			~PipelineFactory();
+			PipelineFactory(const PipelineFactory&) = delete;
+			PipelineFactory& operator=(const PipelineFactory&) = delete;
+			PipelineFactory(const PipelineFactory&&) = delete;
+			PipelineFactory&& operator=(const PipelineFactory&&) = delete;
+
+			// Queues a pipeline. The config is copied along with the blend attachments it points to, so
+			// it may go out of scope right away.
+			PendingPipeline create(const std::string& vert_path, const std::string& frag_path, const PipelineConfigInfo& config_info);
+
+			// Destroys the cached shader modules if nothing is queued and returns whether it did; modules
+			// are recreated by later create() calls.
+			bool trimShaderModules();
+
+			// wall time from the first queued pipeline of the last batch until the queue ran empty
+			[[nodiscard]] double lastBatchMs() const;
+			// create() calls and distinct pipelines they produced
+			[[nodiscard]] uint32_t requestedPipelines() const;
+			[[nodiscard]] uint32_t uniquePipelines() const;
+
+		private:
+			struct Job {
+				std::string vertPath;
+				std::string fragPath;
+				PipelineConfigInfo config;
+				std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+				SharedPipeline base; // pipeline to derive from, invalid for a family's first pipeline
+				std::promise<std::shared_ptr<Pipeline>> promise;
+			};
+
+			EngineDevice& device_;
+			std::vector<std::thread> workers_ {};
+
+			mutable std::mutex mutex_ {};
+			std::condition_variable jobReady_ {};
+			std::deque<std::unique_ptr<Job>> jobs_ {};
+			size_t unfinished_ = 0;
+			bool stopping_ = false;
+			std::chrono::steady_clock::time_point batchStart_ {};
+			double lastBatchMs_ = 0.0;
+			uint32_t requested_ = 0;
+			// keyed by the serialized pipeline state, and by layout, render pass and subpass
+			std::unordered_map<std::string, SharedPipeline> registry_ {};
+			std::unordered_map<std::string, SharedPipeline> families_ {};
+
+			std::mutex moduleMutex_ {};
+			std::unordered_map<uint64_t, std::shared_future<VkShaderModule>> modules_ {};
+
+			void workerLoop();
+			void build(Job& job);
+			VkShaderModule shaderModule(const std::string& path);
+			// only when no job is in flight
+			void destroyShaderModules();
+	};
+
+}
+
+#endif // PIPELINE_FACTORY_HPP
@@ -0,0 +1,54 @@
+#ifndef PIPELINE_STATISTICS_HPP
+#define PIPELINE_STATISTICS_HPP
+
+#include <vector>
+
+#include "engine_device.hpp"
+
+namespace engine {
+
+	// what the fixed function stages and shaders of one frame processed, summed over every pass
+	struct GpuStatistics {
+		bool valid = false; // false until the first result has been read back, and without device support
+		uint64_t inputVertices = 0;
+		uint64_t inputPrimitives = 0;
+		uint64_t vertexInvocations = 0;
+		uint64_t clippingInvocations = 0;
+		uint64_t clippingPrimitives = 0; // primitives that survived clipping
+		uint64_t fragmentInvocations = 0;
+	};
+
+	// Wraps each frame's command buffer in a pipeline statistics query. Like GpuProfiler every frame
+	// slot has its own query, read back without waiting when the slot comes around again, so results
+	// trail the recorded frame by SwapChain::MAX_FRAMES. Does nothing when the device lacks the
+	// pipelineStatisticsQuery feature.
+	class PipelineStatistics {
+		public:
+			explicit PipelineStatistics(EngineDevice& device);
+			~PipelineStatistics();
+			PipelineStatistics(const PipelineStatistics&) = delete;
+			PipelineStatistics& operator=(const PipelineStatistics&) = delete;
+			PipelineStatistics(const PipelineStatistics&&) = delete;
+			PipelineStatistics&& operator=(const PipelineStatistics&&) = delete;
+
+			// Reads the slot's previous result, resets its query and begins it. Call once the slot's
+			// fence has been waited on, outside of a render pass.
+			void beginFrame(VkCommandBuffer command_buf, int frame_idx);
+			// outside of a render pass
+			void endFrame(VkCommandBuffer command_buf);
+
+			[[nodiscard]] bool enabled() const { return queryPool_ != VK_NULL_HANDLE; }
+			// the most recent frame read back
+			[[nodiscard]] const GpuStatistics& latest() const { return latest_; }
+
+		private:
+			EngineDevice& device_;
+			VkQueryPool queryPool_ = VK_NULL_HANDLE;
+			std::vector<bool> pending_ {};
+			int frameIdx_ = 0;
+			GpuStatistics latest_ {};
+	};
+
+}
+
+#endif // PIPELINE_STATISTICS_HPP
@@ -0,0 +1,65 @@
+#ifndef PIPELINE_VARIANTS_HPP
+#define PIPELINE_VARIANTS_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "engine_device.hpp"
+#include "pipeline_factory.hpp"
+
+namespace engine {
+
+	// Specialized variants of one shader pair, keyed by their specialization constant values. A variant
+	// is queued on the factory the first time it is asked for and bind() waits for it, so only the
+	// combinations actually used get compiled. Each variant's draws can be timed on the GPU.
+	class PipelineVariants {
+		public:
+			static constexpr uint32_t MAX_VARIANTS = 16;
+
+			struct Variant {
+				std::vector<uint32_t> constants;
+				PendingPipeline pipeline;
+				double gpuMs = 0.0; // moving average of the timed range, 0 until measured
+			};
+
+			PipelineVariants(EngineDevice& device, PipelineFactory& factory, std::string vert_path, std::string frag_path, const PipelineConfigInfo& config_info);
+			~PipelineVariants();
+			PipelineVariants(const PipelineVariants&) = delete;
+			PipelineVariants& operator=(const PipelineVariants&) = delete;
+			PipelineVariants(const PipelineVariants&&) = delete;
+			PipelineVariants&& operator=(const PipelineVariants&&) = delete;
+
+			// index of the variant for the constants, queueing its compilation if it is new
+			uint32_t variant(const std::vector<uint32_t>& constants);
+			void bind(VkCommandBuffer command_buf, uint32_t variant) { variants_[variant].pipeline->bind(command_buf); }
+
+			// Reads back the timings recorded the last time this frame slot was used and resets its
+			// queries. Call outside of a render pass once the frame's fence has been waited on.
+			void beginFrame(VkCommandBuffer command_buf, int frame_idx);
+			// bracket the draws of one variant, at most once per variant and frame
+			void beginTimed(VkCommandBuffer command_buf, int frame_idx, uint32_t variant);
+			void endTimed(VkCommandBuffer command_buf, int frame_idx, uint32_t variant);
+
+			[[nodiscard]] const std::vector<std::unique_ptr<Variant>>& variants() const { return variants_; }
+
+		private:
+			EngineDevice& device_;
+			PipelineFactory& factory_;
+			std::string vertPath_;
+			std::string fragPath_;
+			PipelineConfigInfo config_;
+			std::vector<VkPipelineColorBlendAttachmentState> blendAttachments_;
+			std::vector<std::unique_ptr<Variant>> variants_ {};
+
+			VkQueryPool queryPool_ = VK_NULL_HANDLE;
+			float timestampPeriod_ = 0.0F;
+			// per frame slot, whether each variant wrote its timestamp pair
+			std::vector<std::vector<bool>> timed_ {};
+
+			[[nodiscard]] uint32_t query(int frame_idx, uint32_t variant) const { return 2 * (static_cast<uint32_t>(frame_idx) * MAX_VARIANTS + variant); }
+	};
+
+}
+
+#endif // PIPELINE_VARIANTS_HPP
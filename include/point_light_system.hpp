@@ -5,7 +5,8 @@
 #include "engine_device.hpp"
 #include "frame_info.hpp"
 #include "scene_object.hpp"
-#include "pipeline.hpp"
+#include "pipeline_factory.hpp"
+#include "swap_chain.hpp"
 
 #include <memory>
 #include <vector>
@@ -14,7 +15,8 @@ namespace engine {
 
 	class PointLightSystem {
 		public:
-			PointLightSystem(EngineDevice& device, VkRenderPass render_pass, VkDescriptorSetLayout global_set_layout);
+			// Deferred draws in the lighting subpass of the deferred render pass, where depth is read only
+			PointLightSystem(EngineDevice& device, PipelineFactory& pipelines, VkRenderPass render_pass, VkDescriptorSetLayout global_set_layout, RenderPath path = RenderPath::Forward);
 			~PointLightSystem();
 
 			PointLightSystem(const PointLightSystem&) = delete;
@@ -22,15 +24,17 @@ namespace engine {
 			PointLightSystem(const PointLightSystem&&) = delete;
 			PointLightSystem &&operator=(const PointLightSystem&&) = delete;
 
-			void render(FrameInfo& frame_info);
-			void update(FrameInfo& frame_info, GlobalUbo& ubo);
+			// Draws one billboard instance per entry of the frame's light buffer, see ClusteredLighting.
+			// The buffer holds the lights whose range reaches into the view.
+			void render(FrameInfo& frame_info, uint32_t light_count);
+			void update(FrameInfo& frame_info);
 
 		private:
 			void createPipelineLayout(VkDescriptorSetLayout global_set_layout);
-			void createPipeline(VkRenderPass render_pass);
+			void createPipeline(PipelineFactory& pipelines, VkRenderPass render_pass, RenderPath path);
 
 			EngineDevice& device_;
-			std::unique_ptr<Pipeline> pipeline_;
+			PendingPipeline pipeline_;
 			VkPipelineLayout pipelineLayout_;
 	};
 
@@ -0,0 +1,72 @@
+#ifndef RENDER_COUNTERS_HPP
+#define RENDER_COUNTERS_HPP
+
+#include <atomic>
+#include <cstdint>
+
+namespace engine {
+
+	// CPU side work issued since the last RenderCounters::takeFrame()
+	struct FrameCounters {
+		uint64_t drawCalls = 0;
+		uint64_t triangles = 0;
+		uint64_t pipelineBinds = 0;
+		uint64_t bufferWrites = 0;
+		uint64_t bytesWritten = 0; // host writes into mapped buffers
+		uint64_t bufferCopies = 0;
+		uint64_t bytesCopied = 0; // buffer to buffer copies on the graphics queue, mostly staging uploads
+		uint64_t modelUploads = 0;
+		uint64_t swapChainRecreations = 0;
+	};
+
+	// Counted by Model, Pipeline::bind, Buffer::writeToBuffer, EngineDevice::copyBuffer and
+	// Renderer::recreateSwapChain, and by systems that record draws directly. Uploads may come from other threads than the recording
+	// one, so every counter is a relaxed atomic; nothing orders them with respect to each other.
+	class RenderCounters {
+		public:
+			void countDraw(uint32_t vertex_count, uint32_t instance_count) {
+				drawCalls_.fetch_add(1, std::memory_order_relaxed);
+				triangles_.fetch_add(static_cast<uint64_t>(vertex_count / 3) * instance_count, std::memory_order_relaxed);
+			}
+			void countPipelineBind() { pipelineBinds_.fetch_add(1, std::memory_order_relaxed); }
+			void countBufferWrite(uint64_t bytes) {
+				bufferWrites_.fetch_add(1, std::memory_order_relaxed);
+				bytesWritten_.fetch_add(bytes, std::memory_order_relaxed);
+			}
+			void countBufferCopy(uint64_t bytes) {
+				bufferCopies_.fetch_add(1, std::memory_order_relaxed);
+				bytesCopied_.fetch_add(bytes, std::memory_order_relaxed);
+			}
+			void countModelUpload() { modelUploads_.fetch_add(1, std::memory_order_relaxed); }
+			void countSwapChainRecreation() { swapChainRecreations_.fetch_add(1, std::memory_order_relaxed); }
+
+			// returns the counts since the previous call and starts the next frame at zero
+			FrameCounters takeFrame() {
+				FrameCounters frame {};
+				frame.drawCalls = drawCalls_.exchange(0, std::memory_order_relaxed);
+				frame.triangles = triangles_.exchange(0, std::memory_order_relaxed);
+				frame.pipelineBinds = pipelineBinds_.exchange(0, std::memory_order_relaxed);
+				frame.bufferWrites = bufferWrites_.exchange(0, std::memory_order_relaxed);
+				frame.bytesWritten = bytesWritten_.exchange(0, std::memory_order_relaxed);
+				frame.bufferCopies = bufferCopies_.exchange(0, std::memory_order_relaxed);
+				frame.bytesCopied = bytesCopied_.exchange(0, std::memory_order_relaxed);
+				frame.modelUploads = modelUploads_.exchange(0, std::memory_order_relaxed);
+				frame.swapChainRecreations = swapChainRecreations_.exchange(0, std::memory_order_relaxed);
+				return frame;
+			}
+
+		private:
+			std::atomic<uint64_t> drawCalls_ { 0 };
+			std::atomic<uint64_t> triangles_ { 0 };
+			std::atomic<uint64_t> pipelineBinds_ { 0 };
+			std::atomic<uint64_t> bufferWrites_ { 0 };
+			std::atomic<uint64_t> bytesWritten_ { 0 };
+			std::atomic<uint64_t> bufferCopies_ { 0 };
+			std::atomic<uint64_t> bytesCopied_ { 0 };
+			std::atomic<uint64_t> modelUploads_ { 0 };
+			std::atomic<uint64_t> swapChainRecreations_ { 0 };
+	};
+
+}
+
+#endif // RENDER_COUNTERS_HPP
@@ -6,19 +6,46 @@
 #include <glm/glm.hpp>
 
 #include "engine_device.hpp"
+#include "bindless_heap.hpp"
+#include "buffer.hpp"
+#include "descriptor.hpp"
 #include "scene_object.hpp"
-#include "pipeline.hpp"
+#include "pipeline_factory.hpp"
+#include "pipeline_variants.hpp"
 #include "camera.hpp"
 #include "frame_info.hpp"
+#include "swap_chain.hpp"
 
 #include <memory>
 #include <vector>
 
 namespace engine {
 
+	enum class ShadingModel : uint32_t {
+		Lambert = 0,
+		HalfLambert = 1
+	};
+
+	// Lighting features compiled into the scene pipeline as specialization constants, in constant_id
+	// order; see clustered_lighting.glsl
+	struct ShadingFeatures {
+		uint32_t maxClusterLights = 256;
+		bool specular = true;
+		ShadingModel model = ShadingModel::Lambert;
+		bool shadows = true;
+
+		[[nodiscard]] std::vector<uint32_t> specializationConstants() const {
+			return { maxClusterLights, specular ? 1U : 0U, static_cast<uint32_t>(model), shadows ? 1U : 0U };
+		}
+	};
+
 	class RenderSystem {
 		public:
-			RenderSystem(EngineDevice& device, VkRenderPass render_pass, VkDescriptorSetLayout global_set_layout);
+			static constexpr uint32_t MAX_OBJECTS = 10000;
+
+			// Deferred draws into the geometry subpass of the deferred render pass and writes the G-buffer.
+			// The per-frame object buffers are registered in the heap, which must outlive the system.
+			RenderSystem(EngineDevice& device, PipelineFactory& pipelines, VkRenderPass render_pass, VkDescriptorSetLayout global_set_layout, BindlessHeap& heap, RenderPath path = RenderPath::Forward);
 			~RenderSystem();
 
 			RenderSystem(const RenderSystem&) = delete;
@@ -26,15 +53,42 @@ namespace engine {
 			RenderSystem(const RenderSystem&&) = delete;
 			RenderSystem &&operator=(const RenderSystem&&) = delete;
 
+			// reads back last use of this frame slot's variant timings; call before the render pass
+			void beginFrame(FrameInfo& frame_info) { variants_->beginFrame(frame_info.cmdBuf, frame_info.frameIdx); }
 			void renderSceneObjects(FrameInfo& frame_info);
 
+			// switches the scene pipeline variant; a new combination compiles on first use
+			void setShadingFeatures(const ShadingFeatures& features);
+			[[nodiscard]] const ShadingFeatures& shadingFeatures() const { return features_; }
+			[[nodiscard]] const PipelineVariants& pipelineVariants() const { return *variants_; }
+			[[nodiscard]] uint32_t currentVariant() const { return variant_; }
+			// visible objects past MAX_OBJECTS that the last renderSceneObjects() did not draw
+			[[nodiscard]] uint32_t skippedObjects() const { return skippedObjects_; }
+
 		private:
+			// what each object slot of a frame's buffer currently holds, so unchanged transforms are not re-uploaded
+			struct UploadedObject {
+				Entity entity = NULL_ENTITY;
+				uint32_t version = 0;
+			};
+
 			EngineDevice& device_;
-			std::unique_ptr<Pipeline> pipeline_;
+			BindlessHeap& heap_;
+			std::unique_ptr<PipelineVariants> variants_;
+			ShadingFeatures features_ {};
+			uint32_t variant_ = 0;
 			VkPipelineLayout pipelineLayout_;
+			// set 1, the scene pass has no per-pass resources
+			std::unique_ptr<DescriptorSetLayout> passSetLayout_;
+			std::vector<std::unique_ptr<Buffer>> objectBuffers_;
+			// heap handles of objectBuffers_
+			std::vector<BindlessHeap::handle_t> objectHandles_;
+			std::vector<std::vector<UploadedObject>> uploadedObjects_;
+			uint32_t skippedObjects_ = 0;
 
+			void createObjectBuffers();
 			void createPipelineLayout(VkDescriptorSetLayout global_set_layout);
-			void createPipeline(VkRenderPass render_pass);
+			void createPipeline(PipelineFactory& pipelines, VkRenderPass render_pass, RenderPath path);
 	};
 
 }
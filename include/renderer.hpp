@@ -2,6 +2,8 @@
 #define RENDERER_HPP
 
 #include "engine_device.hpp"
+#include "frame_arena.hpp"
+#include "frame_readback.hpp"
 #include "swap_chain.hpp"
 #include "window.hpp"
 
@@ -14,6 +16,8 @@ namespace engine {
 	class Renderer {
 		public:
 			Renderer(Window& window, EngineDevice& device);
+			// headless: renders into offscreen images of a fixed extent, the device must be headless too
+			Renderer(EngineDevice& device, VkExtent2D extent);
 			~Renderer();
 
 			Renderer(const Renderer&) = delete;
@@ -21,10 +25,18 @@ namespace engine {
 
 			VkCommandBuffer beginFrame();
 			void endFrame();
-			void beginSwapChainRenderPass(VkCommandBuffer cmd_buf);
+			void beginSwapChainRenderPass(VkCommandBuffer cmd_buf, RenderPath path = RenderPath::Forward);
+			// moves the deferred pass from the geometry to the lighting subpass
+			void nextSubpass(VkCommandBuffer cmd_buf);
 			void endSwapChainRenderPass(VkCommandBuffer cmd_buf);
 
 			bool isFrameInProgress() { return isFrameStarted_; }
+			[[nodiscard]] bool isHeadless() const { return window_ == nullptr; }
+
+			// Writes every following frame into the directory, headless only. Frames reach the disk a
+			// frame or two late and are flushed when the renderer is destroyed.
+			void captureFrames(const std::string& directory);
+			[[nodiscard]] uint64_t capturedFrames() const { return readback_ != nullptr ? readback_->framesWritten() : 0; }
 
 			VkCommandBuffer currentCmdbuffer() const {
 				assert(isFrameStarted_ && "Cannot get command buffer when frame not in progress");
@@ -35,21 +47,43 @@ namespace engine {
 				return swapChain_->getRenderPass();
 			}
 
+			VkRenderPass deferredRenderPass() const {
+				return swapChain_->getDeferredRenderPass();
+			}
+
+			// G-buffer attachments of the image being rendered
+			GBufferViews gBuffer() const {
+				assert(isFrameStarted_ && "Cannot get G-buffer when frame not in progress");
+				return swapChain_->getGBuffer(static_cast<int>(curImageIdx_));
+			}
+
 			int frameIdx() const {
 				assert(isFrameStarted_ && "Cannot get frame index when frame not in progress");
 				return curFrameIdx_;
 			}
 
+			// scratch memory for the frame being recorded, reset by endFrame()
+			FrameArena& frameArena() { return frameArena_; }
+
 			float aspectRatio() const { return swapChain_->extentAspectRatio(); }
+			VkExtent2D swapChainExtent() const { return swapChain_->getSwapChainExtent(); }
+			// of the current or last submitted frame
+			[[nodiscard]] double fenceWaitMs() const { return swapChain_->fenceWaitMs(); }
+			// swap chain, frame arena and capture queue state
+			void collectTelemetry(MetricsWriter& metrics) const;
 
 		private:
-			Window& window_;
+			Window* window_ = nullptr;
 			EngineDevice& device_;
+			VkExtent2D offscreenExtent_ {};
 			std::unique_ptr<SwapChain> swapChain_;
 			std::vector<VkCommandBuffer> cmdBuffers_;
 			uint32_t curImageIdx_;
 			bool isFrameStarted_;
 			int curFrameIdx_;
+			std::unique_ptr<FrameReadback> readback_ {};
+			uint64_t frameNumber_ = 0;
+			FrameArena frameArena_ {};
 
 			void createCmdBuffers();
 			void freeCmdBuffers();
@@ -0,0 +1,34 @@
+#ifndef SCENE_FILE_HPP
+#define SCENE_FILE_HPP
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "scene_object.hpp"
+
+namespace engine {
+
+	// Binary scene snapshot: a header followed by fixed size entity and light records and a string
+	// table of model paths. Entities are stored by index, so a file loads as one batch of entities
+	// whose components are written straight into the scene's dense arrays.
+	class SceneFile {
+		public:
+			// resolves a model path to a loaded model; returning nullptr leaves the entity without a model
+			using ModelLoader = std::function<std::shared_ptr<Model>(const std::string& path)>;
+
+			static constexpr uint32_t VERSION = 1;
+
+			// Writes every entity with a transform. Models without a path() are saved as no model. Throws
+			// without writing when an entity has both a saved model and a light, as load() rejects those.
+			static void save(const std::string& filepath, Scene& scene);
+			// Appends the file's entities to the scene and returns them in file order. Throws before
+			// loading any model when the file has bad indices, parent cycles or an entity with more than
+			// one light or with both a model and a light.
+			static std::vector<Entity> load(const std::string& filepath, Scene& scene, const ModelLoader& loader);
+	};
+
+}
+
+#endif // SCENE_FILE_HPP
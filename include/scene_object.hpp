@@ -1,61 +1,170 @@
 #ifndef SCENE_OBJECT_HPP
 #define SCENE_OBJECT_HPP
 
+#include <cmath>
 #include <memory>
+#include <vector>
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "bvh.hpp"
+#include "ecs.hpp"
 #include "model.hpp"
+#include "transform_hierarchy.hpp"
+#include "transform_kernel.hpp"
 
 namespace engine {
 
-	struct TransformComponent {
-		glm::vec3 translation {};
-		glm::vec3 scale { 1.0F, 1.0F, 1.0F };
-		glm::vec3 rotation {};
+	// Where a scene-owned transform reports its first change since the scene's last update. Copies and
+	// moves carry the link along with the component, except that assigning an unlinked transform over
+	// a linked one keeps the link and counts as a change, so `transform = TransformComponent { ... }`
+	// is tracked like the setters.
+	class TransformChangeLink {
+		public:
+			TransformChangeLink() = default;
+			TransformChangeLink(std::vector<Entity>* changes, Entity entity) : changes_ { changes }, entity_ { entity } {}
+			~TransformChangeLink() = default;
+			TransformChangeLink(const TransformChangeLink&) = default;
+			TransformChangeLink(TransformChangeLink&&) noexcept = default;
+			TransformChangeLink& operator=(const TransformChangeLink& other) { assign(other); return *this; }
+			TransformChangeLink& operator=(TransformChangeLink&& other) { assign(other); return *this; } // NOLINT
+
+			void queue() {
+				if (changes_ != nullptr && !queued_) {
+					queued_ = true;
+					changes_->push_back(entity_);
+				}
+			}
+			// the scene took the queued entity off its list
+			void clear() { queued_ = false; }
+
+		private:
+			std::vector<Entity>* changes_ = nullptr;
+			Entity entity_ = NULL_ENTITY;
+			bool queued_ = false;
+
+			void assign(const TransformChangeLink& other) {
+				if (other.changes_ == nullptr) {
+					queue();
+					return;
+				}
+				changes_ = other.changes_;
+				entity_ = other.entity_;
+				queued_ = other.queued_;
+			}
+	};
+
+	// Local TRS transform with cached model and normal matrices. Setters invalidate the cache, bump
+	// version() and queue the entity on its scene's change list, so the scene only visits transforms
+	// that changed; a pure translation patches the cached matrix without recomputing the rotation.
+	class TransformComponent {
+		public:
+			TransformComponent() = default;
+			TransformComponent(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale)
+				: translation_ { translation }, scale_ { scale }, rotation_ { rotation } {}
+
+			[[nodiscard]] const glm::vec3& translation() const { return translation_; }
+			[[nodiscard]] const glm::vec3& scale() const { return scale_; }
+			[[nodiscard]] const glm::vec3& rotation() const { return rotation_; }
+			[[nodiscard]] uint32_t version() const { return version_; }
+
+			void setTranslation(const glm::vec3& translation);
+			void setScale(const glm::vec3& scale);
+			void setRotation(const glm::vec3& rotation);
+
+			// https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
+			// Tait-Bryan angles YXZ
+			[[nodiscard]] const glm::mat4& mat4() const;
+			[[nodiscard]] const glm::mat3& normalMatrix() const;
 
-		// https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
-		// Tait-Bryan angles YXZ
-		[[nodiscard]] glm::mat4 mat4() const;
-		glm::mat3 normalMatrix();
+		private:
+			glm::vec3 translation_ {};
+			glm::vec3 scale_ { 1.0F, 1.0F, 1.0F };
+			glm::vec3 rotation_ {};
+			uint32_t version_ = 0;
+			mutable bool dirty_ = true;
+			// the scene's batch update fills only matrix_, normalMatrix() computes this on first use
+			mutable bool normalDirty_ = true;
+			mutable glm::mat4 matrix_ { 1.0F };
+			mutable glm::mat3 normalMatrix_ { 1.0F };
+			TransformChangeLink link_ {};
+
+			void updateMatrices() const;
+
+			friend class Scene;
 	};
 
 	struct PointLightComponent {
+		// attenuated intensity below which a light no longer contributes
+		static constexpr float CUTOFF = 0.01F;
+
+		// change it through Scene::setLightIntensity(), which refits the light's bounds to range()
 		float lightIntensity = 1.0F;
-	};
+		glm::vec3 color { 1.0F };
 
-	class SceneObject {
-		public:
-			using id_t = unsigned int;
-			using Map = std::unordered_map<id_t, SceneObject>;
-
-			SceneObject(const SceneObject&) = delete;
-			SceneObject &operator=(const SceneObject&) = delete;
-			SceneObject(SceneObject&&) = default;
-			SceneObject &operator=(SceneObject&&) = default;
-			~SceneObject() = default;
-
-			static SceneObject createObject() {
-				static id_t current_id = 0;
-				return SceneObject { current_id++ };
-			}
+		[[nodiscard]] float range() const { return std::sqrt(lightIntensity / CUTOFF); }
+	};
 
-			static SceneObject createPointLight(float intensity = 10.F, float radius = 0.1F, glm::vec3 color = glm::vec3(1.0F));
+	struct ModelComponent {
+		std::shared_ptr<Model> model {};
+	};
 
-			[[nodiscard]] id_t id() const {
-				return id_;
-			}
+	// Marks a model that moves every frame. Shadows never cache it: it is drawn over the cached static
+	// depth each frame instead of invalidating the cache whenever it moves.
+	struct DynamicComponent {};
 
-			std::shared_ptr<Model> model {};
-			glm::vec3 color {};
-			TransformComponent transform {};
+	// Puts an entity in the scene's spatial index. The bounds are either a local box that follows the
+	// world transform or, when radius is set, a sphere around the world position that ignores scale.
+	struct BoundsComponent {
+		Aabb local {};
+		float radius = 0.0F;
+		Bvh::proxy_t proxy = Bvh::NULL_NODE;
+	};
 
-			std::unique_ptr<PointLightComponent> pointLight = nullptr;
+	// The scene is an entity registry: every object is an Entity and its data lives in per-component
+	// dense arrays, so systems iterate only the components they need instead of walking every object.
+	class Scene : public Registry {
+		public:
+			Entity createObject();
+			// count objects with default transforms; their transforms are contiguous in the same order
+			std::vector<Entity> createObjects(size_t count);
+			Entity createModelObject(std::shared_ptr<Model> model);
+			Entity createPointLight(float intensity = 10.F, float radius = 0.1F, glm::vec3 color = glm::vec3(1.0F));
+			void destroy(Entity entity) override;
+			void setLightIntensity(Entity light, float intensity);
+
+			// The child's transform becomes relative to the parent; NULL_ENTITY detaches it
+			void setParent(Entity child, Entity parent) { hierarchy_.setParent(child, parent); }
+			[[nodiscard]] Entity parent(Entity entity) const { return hierarchy_.parent(entity); }
+
+			// Recomputes the stale caches of the transforms changed since the last call with the batch kernel
+			// instead of one mat4() at a time, propagates world matrices down the changed subtrees and moves the bounds of the entities
+			// whose world matrix changed, so static entities cost nothing here
+			void updateTransforms();
+
+			// valid after updateTransforms()
+			[[nodiscard]] const glm::mat4& worldMatrix(Entity entity) const { return hierarchy_.world(entity); }
+			[[nodiscard]] uint32_t worldVersion(Entity entity) const { return hierarchy_.worldVersion(entity); }
+
+			// entities with a BoundsComponent, refreshed by updateTransforms()
+			[[nodiscard]] const Bvh& spatialIndex() const { return spatialIndex_; }
 
 		private:
-			id_t id_;
-
-			explicit SceneObject(id_t id) : id_(id) {} // NOLINT
+			TransformHierarchy hierarchy_ {};
+			Bvh spatialIndex_ {};
+			// entities whose transform changed since the last update, filled by the transforms' links;
+			// behind a pointer so the links stay valid when the scene is moved
+			std::unique_ptr<std::vector<Entity>> changedTransforms_ = std::make_unique<std::vector<Entity>>();
+			// components of changedTransforms_ whose cached matrix is stale
+			std::vector<uint32_t> dirtyTransforms_ {};
+			// bounds to refit although the world matrix did not change
+			std::vector<Entity> refitBounds_ {};
+			TransformArrays transformBatch_ {};
+			std::vector<glm::mat4> batchMatrices_ {};
+
+			void updateTransformCaches(std::vector<TransformComponent>& transforms);
+			void updateBounds();
+			void refit(Entity entity, BoundsComponent& bounds);
 	};
 
 }
@@ -0,0 +1,118 @@
+#ifndef SHADOW_SYSTEM_HPP
+#define SHADOW_SYSTEM_HPP
+
+#include "buffer.hpp"
+#include "clustered_lighting.hpp"
+#include "engine_device.hpp"
+#include "frame_info.hpp"
+#include "pipeline_factory.hpp"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace engine {
+
+	// Omnidirectional point light shadows. Each shadowed light owns six square tiles of a depth atlas,
+	// one per cube face. Static casters are rendered into a cached atlas and a face is re-rendered only
+	// when its light or the static casters inside its frustum change. Every frame the cached tiles of
+	// faces with DynamicComponent casters are copied into the sampled atlas and the dynamic casters
+	// are drawn on top.
+	class ShadowSystem {
+		public:
+			static constexpr uint32_t ATLAS_SIZE = 4096;
+			static constexpr uint32_t TILE_SIZE = 256;
+			static constexpr uint32_t TILES_PER_ROW = ATLAS_SIZE / TILE_SIZE;
+			static constexpr uint32_t FACES = 6;
+			static constexpr uint32_t MAX_SHADOW_LIGHTS = 32;
+			static constexpr float NEAR_PLANE = 0.05F;
+
+			static constexpr uint32_t SHADOW_DATA_BINDING = 4;
+			static constexpr uint32_t SHADOW_ATLAS_BINDING = 5;
+
+			// per frame storage buffer read by shadows.glsl
+			struct ShadowData {
+				std::array<glm::mat4, MAX_SHADOW_LIGHTS * FACES> faceViewProjection;
+				// shadow slot of each entry of the light buffer, -1 when the light has no shadow
+				std::array<int32_t, ClusteredLighting::MAX_LIGHTS> lightSlot;
+			};
+
+			ShadowSystem(EngineDevice& device, PipelineFactory& pipelines);
+			~ShadowSystem();
+			ShadowSystem(const ShadowSystem&) = delete;
+			ShadowSystem& operator=(const ShadowSystem&) = delete;
+			ShadowSystem(const ShadowSystem&&) = delete;
+			ShadowSystem&& operator=(const ShadowSystem&&) = delete;
+
+			[[nodiscard]] VkDescriptorBufferInfo shadowDataInfo(int frame_idx) const { return shadowDataBuffers_[frame_idx]->decriptorInfo(); }
+			[[nodiscard]] VkDescriptorImageInfo atlasInfo() const { return { sampler_, atlases_[SAMPLED].view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL }; }
+
+			// Picks the lights closest to the camera out of the frame's light buffer, decides which faces
+			// need drawing and writes the frame's shadow data. lights are the entities of the light buffer.
+			void update(FrameInfo& frame_info, const std::vector<Entity>& lights);
+			// records the atlas updates planned by update(); call outside of a render pass
+			void render(FrameInfo& frame_info);
+
+			// cube faces drawn by the last render(), static re-renders plus dynamic composites
+			[[nodiscard]] uint32_t renderedViews() const { return renderedViews_; }
+
+		private:
+			enum Atlas { CACHED = 0, SAMPLED = 1 };
+
+			struct AtlasImage {
+				VkImage image = VK_NULL_HANDLE;
+				VkDeviceMemory memory = VK_NULL_HANDLE;
+				VkImageView view = VK_NULL_HANDLE;
+				VkFramebuffer frameBuffer = VK_NULL_HANDLE;
+			};
+
+			struct Slot {
+				Entity light = NULL_ENTITY;
+				uint64_t lastUsedFrame = 0;
+				// combines the light and the static casters of each face; 0 means never rendered
+				std::array<uint64_t, FACES> staticSignature {};
+				std::array<bool, FACES> hadDynamic {};
+			};
+
+			struct FaceWork {
+				uint32_t tile;
+				glm::mat4 viewProjection;
+				bool renderStatic;
+				uint32_t staticBegin, staticEnd;
+				uint32_t dynamicBegin, dynamicEnd;
+			};
+
+			EngineDevice& device_;
+			VkFormat depthFormat_;
+			std::array<AtlasImage, 2> atlases_ {};
+			VkRenderPass renderPass_ = VK_NULL_HANDLE;
+			VkSampler sampler_ = VK_NULL_HANDLE;
+			VkPipelineLayout pipelineLayout_ = VK_NULL_HANDLE;
+			PendingPipeline pipeline_;
+			std::vector<std::unique_ptr<Buffer>> shadowDataBuffers_;
+
+			// looked up by a scan, which for this few slots beats hashing and never allocates
+			std::array<Slot, MAX_SHADOW_LIGHTS> slots_ {};
+			uint64_t frame_ = 0;
+
+			std::vector<uint32_t> candidates_ {};
+			std::vector<float> distances_ {};
+			std::vector<FaceWork> faces_ {};
+			std::vector<Entity> staticCasters_ {};
+			std::vector<Entity> dynamicCasters_ {};
+			std::vector<VkImageCopy> copyRegions_ {};
+			uint32_t renderedViews_ = 0;
+
+			void createAtlases();
+			void createRenderPass();
+			void createSampler();
+			void createPipelineLayout();
+			void createPipeline(PipelineFactory& pipelines);
+
+			uint32_t acquireSlot(Entity light);
+			void drawCasters(FrameInfo& frame_info, const FaceWork& face, const std::vector<Entity>& casters, uint32_t begin, uint32_t end);
+	};
+
+}
+
+#endif // SHADOW_SYSTEM_HPP
@@ -11,9 +11,30 @@
 
 namespace engine {
 
+	// Forward shades in the single subpass of the swap chain render pass. Deferred writes albedo and
+	// normals in a first subpass and lights them from input attachments in a second one, so the
+	// G-buffer never has to leave tile memory.
+	enum class RenderPath {
+		Forward,
+		Deferred
+	};
+
+	struct GBufferViews {
+		VkImageView albedo;
+		VkImageView normal;
+		VkImageView depth;
+	};
+
+	// On a headless device there is nothing to present to, so the chain owns MAX_FRAMES offscreen color
+	// images instead, one per frame in flight. Frames end in TRANSFER_SRC layout ready to be read back.
 	class SwapChain {
 		public:
 			static constexpr int MAX_FRAMES = 2;
+			static constexpr VkFormat OFFSCREEN_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+			static constexpr VkFormat ALBEDO_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+			static constexpr VkFormat NORMAL_FORMAT = VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+			static constexpr uint32_t GEOMETRY_SUBPASS = 0;
+			static constexpr uint32_t LIGHTING_SUBPASS = 1;
 
 			SwapChain(EngineDevice& engine_device, VkExtent2D window_extent);
 			SwapChain(EngineDevice& engine_device, VkExtent2D window_extent, std::shared_ptr<SwapChain> previous);
@@ -24,6 +45,8 @@ namespace engine {
 			VkFormat findDepthFormat();
 			VkResult acquireNextImage(uint32_t* image_idx);
 			VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* image_idx);
+			// time blocked on fences since the last acquireNextImage
+			[[nodiscard]] double fenceWaitMs() const { return fenceWaitMs_; }
 
 			VkFramebuffer getFrameBuffer(int index) {
 				return swapChainFrameBuffers_[index];
@@ -31,9 +54,24 @@ namespace engine {
 			VkRenderPass getRenderPass() {
 				return renderPass_;
 			}
+			VkFramebuffer getDeferredFrameBuffer(int index) {
+				return deferredFrameBuffers_[index];
+			}
+			VkRenderPass getDeferredRenderPass() {
+				return deferredRenderPass_;
+			}
+			GBufferViews getGBuffer(int index) {
+				return { albedoImageViews_[index], normalImageViews_[index], depthImageViews_[index] };
+			}
 			VkImageView getImageView(int index) {
 				return swapChainImageViews_[index];
 			}
+			VkImage getImage(int index) {
+				return swapChainImages_[index];
+			}
+			[[nodiscard]] bool isOffscreen() const {
+				return device_.headless();
+			}
 			size_t imageCount() {
 				return swapChainImages_.size();
 			}
@@ -67,22 +105,38 @@ namespace engine {
 			std::vector<VkImage> depthImages_;
 			std::vector<VkDeviceMemory> depthImageMemories_;
 			std::vector<VkImageView> depthImageViews_;
+			VkRenderPass deferredRenderPass_;
+			std::vector<VkFramebuffer> deferredFrameBuffers_;
+			std::vector<VkImage> albedoImages_;
+			std::vector<VkDeviceMemory> albedoImageMemories_;
+			std::vector<VkImageView> albedoImageViews_;
+			std::vector<VkImage> normalImages_;
+			std::vector<VkDeviceMemory> normalImageMemories_;
+			std::vector<VkImageView> normalImageViews_;
 			std::vector<VkImage> swapChainImages_;
 			std::vector<VkImageView> swapChainImageViews_;
+			std::vector<VkDeviceMemory> offscreenImageMemories_;
 			EngineDevice& device_;
 			VkExtent2D windowExtent_;
-			VkSwapchainKHR swapChain_;
+			VkSwapchainKHR swapChain_ = VK_NULL_HANDLE;
 			std::vector<VkSemaphore> imageAvailableSemaphores_;
 			std::vector<VkSemaphore> renderFinishedSemaphores_;
 			std::vector<VkFence> inFlightFences_;
 			std::vector<VkFence> imagesInFlight_;
 			size_t currentFrame_ = 0;
+			double fenceWaitMs_ = 0.0;
 			std::shared_ptr<SwapChain> oldSwapChain_;
 
 			void createSwapChain();
+			void createOffscreenImages();
+			// layout the color attachment is left in for presenting or reading back
+			[[nodiscard]] VkImageLayout finalColorLayout() const;
 			void createImageViews();
 			void createDepthResources();
 			void createRenderPass();
+			void createDeferredRenderPass();
+			void createGBufferResources();
+			void createGBufferAttachment(VkFormat format, VkImage& image, VkDeviceMemory& memory, VkImageView& view);
 			void createFrameBuffers();
 			void createSyncObjects();
 
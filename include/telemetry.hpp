@@ -0,0 +1,108 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_info.hpp"
+#include "latency_histogram.hpp"
+#include "metrics_writer.hpp"
+
+namespace engine {
+
+	enum class TelemetryFormat {
+		Prometheus, // text exposition format
+		Json
+	};
+
+	struct TelemetryOptions {
+		TelemetryFormat format = TelemetryFormat::Prometheus;
+		// every connection gets the latest snapshot; an HTTP GET is answered as HTTP, so this works
+		// with curl --unix-socket and scrapers that speak HTTP over Unix sockets
+		std::string socketPath {};
+		// every snapshot is appended here; past maxFileBytes the file moves to path.1, path.1 to path.2 and so on
+		std::string filePath {};
+		double intervalMs = 1000.0; // NOLINT
+		size_t maxFileBytes = size_t { 1 } << 20; // NOLINT
+		uint32_t rotatedFiles = 3; // NOLINT
+	};
+
+	// Publishes engine metrics for scraping. The render thread calls recordFrame() every frame; once
+	// per interval it runs the sources into a fixed size snapshot and hands it to the export thread
+	// through a triple buffer, so it never locks, allocates or waits on the exporter. The export
+	// thread serves the latest snapshot on a Unix domain socket and appends it to a rotated file.
+	class Telemetry {
+		public:
+			// fills metrics on the render thread; names and help texts must be string literals
+			using Source = std::function<void(MetricsWriter&)>;
+
+			// starts the export thread, throws when the socket cannot be bound
+			explicit Telemetry(TelemetryOptions options);
+			~Telemetry();
+			Telemetry(const Telemetry&) = delete;
+			Telemetry& operator=(const Telemetry&) = delete;
+			Telemetry(const Telemetry&&) = delete;
+			Telemetry&& operator=(const Telemetry&&) = delete;
+
+			// before the first recordFrame()
+			void addSource(Source source);
+			// totals and frame time percentiles come from here, the rest from the sources
+			void recordFrame(const FrameStats& stats);
+
+			[[nodiscard]] const TelemetryOptions& options() const { return options_; }
+
+		private:
+			struct Snapshot {
+				uint64_t sequence = 0; // 0 until the first publish
+				int64_t timestampMs = 0; // since the Unix epoch
+				MetricsWriter metrics {};
+			};
+
+			// a triple buffer slot index, with FRESH_BIT when it holds a snapshot the exporter has not taken
+			static constexpr uint32_t FRESH_BIT = 4;
+			static constexpr uint32_t INDEX_MASK = 3;
+
+			TelemetryOptions options_;
+			std::vector<Source> sources_ {};
+
+			// render thread
+			FrameCounters totals_ {};
+			uint64_t frames_ = 0;
+			uint64_t allocations_ = 0;
+			uint64_t intervalUploadBytes_ = 0;
+			LatencyHistogram intervalFrameTimes_ {};
+			std::chrono::steady_clock::time_point lastPublish_ { std::chrono::steady_clock::now() };
+			uint64_t sequence_ = 0;
+			uint32_t back_ = 0;
+
+			std::array<Snapshot, 3> snapshots_ {};
+			std::atomic<uint32_t> shared_ { 1 };
+
+			// export thread
+			uint32_t front_ = 2;
+			int listenFd_ = -1;
+			uint64_t fileBytes_ = 0;
+			std::atomic<bool> stopping_ { false };
+			std::thread exporter_ {};
+
+			void publish(std::chrono::steady_clock::time_point now);
+			void exportLoop();
+			// the newest published snapshot, nullptr before the first
+			const Snapshot* takeLatest();
+			void openSocket();
+			void serve(int client);
+			void appendToFile(const Snapshot& snapshot);
+			void write(std::ostream& out, const Snapshot& snapshot) const;
+			static void writePrometheus(std::ostream& out, const Snapshot& snapshot);
+			static void writeJson(std::ostream& out, const Snapshot& snapshot);
+	};
+
+}
+
+#endif // TELEMETRY_HPP
@@ -0,0 +1,104 @@
+#ifndef TRANSFORM_HIERARCHY_HPP
+#define TRANSFORM_HIERARCHY_HPP
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "ecs.hpp"
+
+namespace engine {
+
+	class TransformComponent;
+
+	// Parent/child relationships between transforms. Nodes are kept in depth-first order with the end of
+	// every subtree, so a parent always precedes its children and a subtree is one contiguous range.
+	// markDirty(), setParent() and remove() record the nodes whose world matrix went stale; update()
+	// recomputes only their subtrees, which are disjoint ranges that can be updated on separate threads.
+	// The worker threads start with the first update() over PARALLEL_THRESHOLD stale nodes and are kept
+	// until the hierarchy is destroyed.
+	class TransformHierarchy {
+		public:
+			// below this many stale nodes handing chunks to the workers costs more than it saves
+			static constexpr size_t PARALLEL_THRESHOLD = 16384;
+
+			TransformHierarchy();
+			~TransformHierarchy();
+			TransformHierarchy(const TransformHierarchy&) = delete;
+			TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+			TransformHierarchy(TransformHierarchy&&) noexcept;
+			TransformHierarchy& operator=(TransformHierarchy&&) noexcept;
+
+			void add(Entity entity);
+			// room for count more nodes
+			void reserve(size_t count);
+			// children of a removed node are attached to its parent
+			void remove(Entity entity);
+			// NULL_ENTITY makes the child a root
+			void setParent(Entity child, Entity parent);
+			// the entity's local transform changed, the next update() recomputes its subtree
+			void markDirty(Entity entity);
+
+			[[nodiscard]] bool contains(Entity entity) const {
+				const uint32_t index = entityIndex(entity);
+				return index < indexOf_.size() && indexOf_[index] != NULL_INDEX && order_[indexOf_[index]] == entity;
+			}
+			[[nodiscard]] Entity parent(Entity entity) const;
+			[[nodiscard]] size_t size() const { return order_.size(); }
+
+			// Recomputes world matrices of every subtree with a node marked since the last update
+			void update(const ComponentPool<TransformComponent>& transforms);
+			// entities whose world matrix the last update() recomputed, in depth-first order
+			[[nodiscard]] const std::vector<Entity>& changed() const { return changed_; }
+
+			[[nodiscard]] const glm::mat4& world(Entity entity) const;
+			// bumped whenever world(entity) is recomputed
+			[[nodiscard]] uint32_t worldVersion(Entity entity) const;
+
+		private:
+			static constexpr uint32_t NULL_INDEX = std::numeric_limits<uint32_t>::max();
+
+			struct Workers;
+
+			// indexed by entityIndex(); the child lists keep children in the order they were attached
+			std::vector<uint32_t> indexOf_ {};
+			std::vector<Entity> parentOf_ {};
+			std::vector<Entity> firstChild_ {};
+			std::vector<Entity> lastChild_ {};
+			std::vector<Entity> nextSibling_ {};
+			std::vector<Entity> prevSibling_ {};
+
+			// indexed by depth-first position
+			std::vector<Entity> order_ {};
+			std::vector<uint32_t> parentIdx_ {};
+			std::vector<uint32_t> subtreeEnd_ {};
+			std::vector<glm::mat4> world_ {};
+			std::vector<uint32_t> worldVersion_ {};
+
+			bool structureDirty_ = false;
+			// nodes marked since the last update, possibly repeated or removed since
+			std::vector<Entity> dirtyNodes_ {};
+			// positions of the stale subtrees update() recomputes, sorted and disjoint
+			std::vector<uint32_t> dirtyRoots_ {};
+			std::vector<Entity> changed_ {};
+			// dirtyRoots_ ranges of the parallel chunks, chunk i is [chunkBounds_[i], chunkBounds_[i + 1])
+			std::vector<size_t> chunkBounds_ {};
+			// changed entities of each parallel chunk, merged into changed_ in chunk order
+			std::vector<std::vector<Entity>> chunkChanged_ {};
+			std::unique_ptr<Workers> workers_;
+
+			[[nodiscard]] bool isAncestor(Entity ancestor, Entity entity) const;
+			// appends the child to the parent's child list, a NULL_ENTITY parent leaves it unlinked
+			void link(Entity child, Entity parent);
+			void unlink(Entity child);
+			void rebuild();
+			// recomputes the subtrees of dirtyRoots_[first, last)
+			void updateSubtrees(const ComponentPool<TransformComponent>& transforms, size_t first, size_t last, std::vector<Entity>& changed);
+	};
+
+}
+
+#endif // TRANSFORM_HIERARCHY_HPP
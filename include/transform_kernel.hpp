@@ -0,0 +1,47 @@
+#ifndef TRANSFORM_KERNEL_HPP
+#define TRANSFORM_KERNEL_HPP
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace engine {
+
+	// Structure-of-arrays transforms, one array per component so the kernel can load 8 objects at once.
+	struct TransformArrays {
+		std::vector<float> translationX {};
+		std::vector<float> translationY {};
+		std::vector<float> translationZ {};
+		std::vector<float> rotationX {};
+		std::vector<float> rotationY {};
+		std::vector<float> rotationZ {};
+		std::vector<float> scaleX {};
+		std::vector<float> scaleY {};
+		std::vector<float> scaleZ {};
+
+		void resize(size_t count);
+		void set(size_t idx, const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale);
+		[[nodiscard]] size_t size() const { return translationX.size(); }
+	};
+
+	enum class TransformKernel {
+		Scalar,
+		Avx2
+	};
+
+	[[nodiscard]] TransformKernel bestTransformKernel();
+
+	// Batch version of TransformComponent::mat4() and normalMatrix(). normal_matrices may be null.
+	// Requesting Avx2 on a CPU or build without it falls back to the scalar kernel.
+	void computeTransforms(
+		const TransformArrays& transforms,
+		glm::mat4* model_matrices,
+		glm::mat3* normal_matrices,
+		TransformKernel kernel = bestTransformKernel());
+
+}
+
+#endif // TRANSFORM_KERNEL_HPP
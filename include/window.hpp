@@ -4,6 +4,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 #include <string>
+#include <string_view>
 
 namespace engine {
 
@@ -26,6 +27,9 @@ namespace engine {
 
 			void resetWindowResize() { frameBufferResized_ = false; }
 
+			// reuses the stored title's capacity, so a title of steady length does not allocate
+			void setTitle(std::string_view title);
+
 		private:
 			static void frameBufferResizedCallback(GLFWwindow* window, int width, int height);
 			int width_;
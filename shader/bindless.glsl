@@ -0,0 +1,24 @@
+// Bindless resource declarations shared by shaders that use BindlessHeap.
+// Include with GL_GOOGLE_include_directive; the heap is bound at BINDLESS_SET, which matches
+// BindlessHeap::SET. A shader that needs typed storage buffers declares its own block array at
+// BINDLESS_STORAGE_BUFFER_BINDING, aliasing bindlessBuffers.
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+#define BINDLESS_SET 2
+#define BINDLESS_STORAGE_BUFFER_BINDING 0
+#define BINDLESS_SAMPLED_IMAGE_BINDING 1
+
+layout (set = BINDLESS_SET, binding = BINDLESS_STORAGE_BUFFER_BINDING) readonly buffer BindlessStorageBuffer {
+	uint words[];
+} bindlessBuffers[];
+
+layout (set = BINDLESS_SET, binding = BINDLESS_SAMPLED_IMAGE_BINDING) uniform sampler2D bindlessTextures[];
+
+vec4 bindlessTexture(uint handle, vec2 uv) {
+	return texture(bindlessTextures[nonuniformEXT(handle)], uv);
+}
+
+uint bindlessLoad(uint handle, uint word) {
+	return bindlessBuffers[nonuniformEXT(handle)].words[word];
+}
@@ -0,0 +1,73 @@
+// Clustered point light shading shared by the forward and deferred lighting shaders.
+// Include with GL_GOOGLE_include_directive after declaring the GlobalUbo as `ubo`.
+
+#include "lights.glsl"
+#include "shadows.glsl"
+
+// specialization constants, see ShadingFeatures; the defaults are what the deferred path uses
+layout (constant_id = 0) const uint MAX_CLUSTER_LIGHTS = 256u;
+layout (constant_id = 1) const bool SPECULAR = true;
+layout (constant_id = 2) const int SHADING_MODEL = 0; // 0 Lambert, 1 half Lambert
+layout (constant_id = 3) const bool SHADOWS = true;
+
+// offset into lightIndices and light count per cluster
+layout (std430, set = 0, binding = 2) readonly buffer ClusterBuffer {
+	uvec2 clusters[];
+} clusterBuffer;
+
+layout (std430, set = 0, binding = 3) readonly buffer LightIndexBuffer {
+	uint lightIndices[];
+} lightIndexBuffer;
+
+// ambient plus the lights of the fragment's cluster; view depth is the view space z of the surface
+vec3 shadeClustered(vec3 posWorld, vec3 surfaceNormal, float viewDepth, vec3 albedo) {
+	vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
+	vec3 specularLight = vec3(0.0);
+
+	vec3 cameraPosWorld = ubo.inverseView[3].xyz;
+	vec3 viewDirection = normalize(cameraPosWorld - posWorld);
+
+	// exponential depth slices: slice = log(z) * scale + bias
+	uvec3 cluster = uvec3(
+		uvec2(gl_FragCoord.xy * ubo.clusterScale.xy),
+		uint(max(log(viewDepth) * ubo.clusterScale.z + ubo.clusterScale.w, 0.0))
+	);
+	cluster = min(cluster, ubo.clusterDims.xyz - 1);
+	uvec2 range = clusterBuffer.clusters[cluster.x + ubo.clusterDims.x * (cluster.y + ubo.clusterDims.y * cluster.z)];
+
+	// the loop bound is the MAX_CLUSTER_LIGHTS specialization constant, so the driver sees a constant
+	// trip count and can unroll; the cluster's own count only breaks out early
+	for (uint i = 0; i < MAX_CLUSTER_LIGHTS; i++) {
+		if (i >= range.y) {
+			break;
+		}
+		uint lightIdx = lightIndexBuffer.lightIndices[range.x + i];
+		PointLight light = lightBuffer.lights[lightIdx];
+		vec3 directionToLight = light.position.xyz - posWorld;
+		float distanceSquared = dot(directionToLight, directionToLight);
+		// windowed inverse square falloff reaching zero at the light's range so cluster edges do not show
+		float rangeSquared = light.color.w / LIGHT_CUTOFF;
+		float window = clamp(1.0 - pow(distanceSquared / rangeSquared, 2.0), 0.0, 1.0);
+		float attenuation = window * window / distanceSquared;
+		if (SHADOWS) {
+			attenuation *= pointShadow(lightIdx, light.position.xyz, posWorld);
+		}
+		directionToLight = normalize(directionToLight);
+
+		float cosAngleIncidence = dot(surfaceNormal, directionToLight);
+		// half Lambert wraps the falloff past the terminator for a softer look
+		float diffuseTerm = SHADING_MODEL == 1 ? pow(cosAngleIncidence * 0.5 + 0.5, 2.0) : max(cosAngleIncidence, 0);
+		vec3 intensity = light.color.xyz * light.color.w * attenuation;
+		diffuseLight += intensity * diffuseTerm;
+
+		if (!SPECULAR) {
+			continue;
+		}
+		vec3 halfAngle = normalize(directionToLight + viewDirection);
+		float blinnTerm = dot(surfaceNormal, halfAngle);
+		blinnTerm = clamp(blinnTerm, 0, 1);
+		blinnTerm = pow(blinnTerm, 512.0); // the more the degree the more specular contribution is etc. metals have more degree than some matte material
+		specularLight += intensity * blinnTerm;
+	}
+	return diffuseLight * albedo + specularLight * albedo;
+}
@@ -0,0 +1,38 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+layout (location = 0) out vec4 outColor;
+
+layout (set = 0, binding = 0) uniform GlobalUbo {
+	mat4 projection;
+	mat4 view;
+	mat4 inverseView;
+	vec4 ambientLightColor;
+	vec4 clusterScale;
+	uvec4 clusterDims;
+} ubo;
+
+#include "clustered_lighting.glsl"
+
+layout (input_attachment_index = 0, set = 1, binding = 0) uniform subpassInput gAlbedo;
+layout (input_attachment_index = 1, set = 1, binding = 1) uniform subpassInput gNormal;
+layout (input_attachment_index = 2, set = 1, binding = 2) uniform subpassInput gDepth;
+
+void main() {
+	float depth = subpassLoad(gDepth).r;
+	if (depth >= 1.0) {
+		discard; // keep the clear color where nothing was drawn
+	}
+
+	// invert the perspective projection: depth = p22 + p32 / z
+	float viewDepth = ubo.projection[3][2] / (depth - ubo.projection[2][2]);
+	// clusterScale.xy is clusters per pixel, so this is the pixel's position in 0..1
+	vec2 screen = gl_FragCoord.xy * ubo.clusterScale.xy / vec2(ubo.clusterDims.xy);
+	vec2 ndc = screen * 2.0 - 1.0;
+	vec3 posView = vec3(ndc.x * viewDepth / ubo.projection[0][0], ndc.y * viewDepth / ubo.projection[1][1], viewDepth);
+	vec3 posWorld = (ubo.inverseView * vec4(posView, 1.0)).xyz;
+
+	vec3 albedo = subpassLoad(gAlbedo).rgb;
+	vec3 normal = normalize(subpassLoad(gNormal).xyz * 2.0 - 1.0);
+	outColor = vec4(shadeClustered(posWorld, normal, viewDepth, albedo), 1.0);
+}
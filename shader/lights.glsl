@@ -0,0 +1,13 @@
+// Point light storage buffer filled by ClusteredLighting, shared by lighting and light billboards.
+
+// must match PointLightComponent::CUTOFF: a light's range is where intensity / d^2 drops to it
+const float LIGHT_CUTOFF = 0.01;
+
+struct PointLight {
+	vec4 position; // w is billboard radius
+	vec4 color; // w is intensity
+};
+
+layout (std430, set = 0, binding = 1) readonly buffer LightBuffer {
+	PointLight lights[];
+} lightBuffer;
@@ -1,4 +1,5 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 const vec2 OFFSETS[6] = vec2[](
   vec2(-1.0, -1.0),
@@ -10,31 +11,27 @@ const vec2 OFFSETS[6] = vec2[](
 );
 
 layout (location = 0) out vec2 fragOffset;
-
-struct PointLight {
-	vec4 position;
-	vec4 color;
-};
+layout (location = 1) flat out vec3 fragColor;
 
 layout (set = 0, binding = 0) uniform GlobalUbo {
 	mat4 projection;
 	mat4 view;
 	mat4 inverseView;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
-	int lightsNum;
+	vec4 clusterScale;
+	uvec4 clusterDims;
 } ubo;
 
-layout (push_constant) uniform Push {
-	vec4 position;
-	vec4 color;
-	float radius;
-} push;
+#include "lights.glsl"
 
+// one instance per light of the frame's light buffer
 void main() {
+	PointLight light = lightBuffer.lights[gl_InstanceIndex];
 	fragOffset = OFFSETS[gl_VertexIndex];
+	fragColor = light.color.xyz;
+	float radius = light.position.w;
 	vec3 cameraRightWorld = { ubo.view[0][0], ubo.view[1][0], ubo.view[2][0] };
 	vec3 cameraUpWorld = { ubo.view[0][1], ubo.view[1][1], ubo.view[2][1] };
-	vec3 positionWorld = push.position.xyz + push.radius * fragOffset.x * cameraRightWorld + push.radius * fragOffset.y * cameraUpWorld;
+	vec3 positionWorld = light.position.xyz + radius * fragOffset.x * cameraRightWorld + radius * fragOffset.y * cameraUpWorld;
 	gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0);
 }
@@ -0,0 +1,5 @@
+#version 450
+
+// depth only pass, the shadow atlas has no color attachment
+void main() {
+}
@@ -0,0 +1,11 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+
+layout (push_constant) uniform Push {
+	mat4 modelViewProjection;
+} push;
+
+void main() {
+	gl_Position = push.modelViewProjection * vec4(position, 1.0);
+}
@@ -0,0 +1,43 @@
+// Point light cube shadows sampled from the atlas written by ShadowSystem.
+
+// must match ShadowSystem
+const uint SHADOW_FACES = 6u;
+const uint MAX_SHADOW_LIGHTS = 32u;
+const float SHADOW_TILE_SIZE = 256.0;
+const float SHADOW_ATLAS_SIZE = 4096.0;
+const uint SHADOW_TILES_PER_ROW = 16u;
+
+layout (std430, set = 0, binding = 4) readonly buffer ShadowBuffer {
+	mat4 faceViewProjection[MAX_SHADOW_LIGHTS * SHADOW_FACES];
+	int lightSlot[]; // per light buffer entry, -1 without a shadow
+} shadowBuffer;
+
+layout (set = 0, binding = 5) uniform sampler2DShadow shadowAtlas;
+
+// 1 when posWorld is lit by the light, 0 when occluded
+float pointShadow(uint lightIdx, vec3 lightPosWorld, vec3 posWorld) {
+	int slot = shadowBuffer.lightSlot[lightIdx];
+	if (slot < 0) {
+		return 1.0;
+	}
+
+	// the cube face is the major axis of the light to surface direction, +X, -X, +Y, -Y, +Z, -Z
+	vec3 direction = posWorld - lightPosWorld;
+	vec3 absDirection = abs(direction);
+	uint face;
+	if (absDirection.x >= absDirection.y && absDirection.x >= absDirection.z) {
+		face = direction.x > 0.0 ? 0u : 1u;
+	} else if (absDirection.y >= absDirection.z) {
+		face = direction.y > 0.0 ? 2u : 3u;
+	} else {
+		face = direction.z > 0.0 ? 4u : 5u;
+	}
+
+	uint tile = uint(slot) * SHADOW_FACES + face;
+	vec4 clip = shadowBuffer.faceViewProjection[tile] * vec4(posWorld, 1.0);
+	vec3 ndc = clip.xyz / clip.w;
+	// keep the bilinear footprint inside the tile so neighbouring faces do not bleed in
+	vec2 texel = clamp((ndc.xy * 0.5 + 0.5) * SHADOW_TILE_SIZE, vec2(0.5), vec2(SHADOW_TILE_SIZE - 0.5));
+	vec2 origin = vec2(tile % SHADOW_TILES_PER_ROW, tile / SHADOW_TILES_PER_ROW) * SHADOW_TILE_SIZE;
+	return texture(shadowAtlas, vec3((origin + texel) / SHADOW_ATLAS_SIZE, ndc.z));
+}
@@ -1,4 +1,5 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 layout (location = 0) in vec3 fragColor;
 layout (location = 1) in vec3 fragPosWorld;
@@ -6,49 +7,18 @@ layout (location = 2) in vec3 fragNormalWorld;
 
 layout (location = 0) out vec4 outColor;
 
-layout(push_constant) uniform Push {
-	mat4 modelMatrix;
-	mat4 normalMatrix;
-} push;
-
-struct PointLight {
-	vec4 position;
-	vec4 color;
-};
-
 layout (set = 0, binding = 0) uniform GlobalUbo {
 	mat4 projection;
 	mat4 view;
 	mat4 inverseView;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
-	int lightsNum;
+	vec4 clusterScale;
+	uvec4 clusterDims;
 } ubo;
 
-void main() {
-	vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
-	vec3 specularLight = vec3(0.0);
-
-	vec3 surfaceNormal = normalize(fragNormalWorld);
-	vec3 cameraPosWorld = ubo.inverseView[3].xyz;
-	vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld);
+#include "clustered_lighting.glsl"
 
-	for (int i = 0; i < ubo.lightsNum; i++) {
-		PointLight light = ubo.pointLights[i];
-		vec3 directionToLight = light.position.xyz - fragPosWorld;
-		float attenuation = 1.0 / dot(directionToLight, directionToLight);
-		directionToLight = normalize(directionToLight);
-
-		float cosAngleIncidence = max(dot(surfaceNormal, directionToLight), 0);
-		vec3 intensity = light.color.xyz * light.color.w * attenuation;
-		diffuseLight += intensity * cosAngleIncidence;
-
-		// specular
-		vec3 halfAngle = normalize(directionToLight + viewDirection);
-		float blinnTerm = dot(surfaceNormal, halfAngle);
-		blinnTerm = clamp(blinnTerm, 0, 1);
-		blinnTerm = pow(blinnTerm, 512.0); // the more the degree the more specular contribution is etc. metals have more degree than some matte material
-		specularLight += intensity * blinnTerm;
-	}
-	outColor = vec4(diffuseLight * fragColor + specularLight * fragColor, 1.0);
+void main() {
+	float viewDepth = (ubo.view * vec4(fragPosWorld, 1.0)).z;
+	outColor = vec4(shadeClustered(fragPosWorld, normalize(fragNormalWorld), viewDepth, fragColor), 1.0);
 }
@@ -1,4 +1,7 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "bindless.glsl"
 
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 color;
@@ -9,30 +12,39 @@ layout (location = 0) out vec3 fragColor;
 layout (location = 1) out vec3 fragPosWorld;
 layout (location = 2) out vec3 fragNormalWorld;
 
-struct PointLight {
-	vec4 position;
-	vec4 color;
-};
-
 layout (set = 0, binding = 0) uniform GlobalUbo {
 	mat4 projection;
 	mat4 view;
 	mat4 inverseView;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
-	int lightsNum;
+	vec4 clusterScale;
+	uvec4 clusterDims;
 } ubo;
 
-layout (push_constant) uniform Push {
+struct ObjectData {
 	mat4 modelMatrix;
-	mat4 normalMatrix;
+	mat3x4 normalMatrix; // inverse transpose of the model matrix, w unused
+};
+
+// typed view of the heap's storage buffers
+layout (std430, set = BINDLESS_SET, binding = BINDLESS_STORAGE_BUFFER_BINDING) readonly buffer ObjectBuffer {
+	ObjectData objects[];
+} objectBuffers[];
+
+layout (push_constant) uniform Push {
+	uint objectIdx;
+	uint objectBuffer; // heap handle of this frame's object buffer
 } push;
 
 void main() {
-	vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+	ObjectData object = objectBuffers[push.objectBuffer].objects[push.objectIdx];
+	mat4 modelMatrix = object.modelMatrix;
+	vec4 positionWorld = modelMatrix * vec4(position, 1.0);
 	gl_Position = ubo.projection * ubo.view * positionWorld;
 
-	fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
+	// the world matrix may shear, so the CPU uploads the full inverse transpose
+	mat3 normalMatrix = mat3(object.normalMatrix);
+	fragNormalWorld = normalize(normalMatrix * normal);
 	fragPosWorld = positionWorld.xyz;
 	fragColor = color;
 }
@@ -0,0 +1,85 @@
+#include "allocation_tracker.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace engine {
+
+	namespace {
+
+		std::atomic<uint64_t> total_allocations { 0 };
+		thread_local uint64_t thread_allocations = 0;
+
+	}
+
+	bool AllocationTracker::enabled() {
+#ifdef ENGINE_TRACK_ALLOCATIONS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	uint64_t AllocationTracker::allocations() {
+		return total_allocations.load(std::memory_order_relaxed);
+	}
+
+	uint64_t AllocationTracker::threadAllocations() {
+		return thread_allocations;
+	}
+
+}
+
+#ifdef ENGINE_TRACK_ALLOCATIONS
+
+namespace {
+
+	void* countedAllocation(std::size_t size) noexcept {
+		engine::total_allocations.fetch_add(1, std::memory_order_relaxed);
+		engine::thread_allocations++;
+		return std::malloc(size == 0 ? 1 : size); // NOLINT
+	}
+
+	void* countedAlignedAllocation(std::size_t size, std::align_val_t alignment) noexcept {
+		engine::total_allocations.fetch_add(1, std::memory_order_relaxed);
+		engine::thread_allocations++;
+		// aligned_alloc wants the size to be a multiple of the alignment
+		const auto align = static_cast<std::size_t>(alignment);
+		return std::aligned_alloc(align, (size + align - 1) / align * align); // NOLINT
+	}
+
+	void* checked(void* memory) {
+		if (memory == nullptr) {
+			throw std::bad_alloc();
+		}
+		return memory;
+	}
+
+}
+
+// NOLINTBEGIN
+void* operator new(std::size_t size) { return checked(countedAllocation(size)); }
+void* operator new[](std::size_t size) { return checked(countedAllocation(size)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAllocation(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAllocation(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return checked(countedAlignedAllocation(size, alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return checked(countedAlignedAllocation(size, alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return countedAlignedAllocation(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return countedAlignedAllocation(size, alignment); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { std::free(memory); }
+// NOLINTEND
+
+#endif
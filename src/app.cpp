@@ -1,8 +1,10 @@
 #include "app.hpp"
 
+#include <array>
 #include <stdexcept>
 #include <iostream>
 #include <chrono>
+#include <cstdio>
 
 #include <glm/gtc/constants.hpp>
 
@@ -11,20 +13,63 @@
 #include "keyboard_move_controller.hpp"
 #include "buffer.hpp"
 #include "point_light_system.hpp"
+#include "clustered_lighting.hpp"
+#include "deferred_render_system.hpp"
+#include "shadow_system.hpp"
+#include "pipeline_factory.hpp"
+#include "cpu_profiler.hpp"
+#include "allocation_tracker.hpp"
 
 namespace engine {
 
 	App::App() {
+		init();
+	}
+
+	App::App(HeadlessOptions headless) : headless_ { std::move(headless) } {
+		init();
+		if (!headless_->captureDirectory.empty()) {
+			renderer_->captureFrames(headless_->captureDirectory);
+		}
+	}
+
+	void App::init() {
+		ENGINE_ZONE("App::init");
 		globalPool_ = DescriptorPool::Builder(device_)
 			.maxSets(SwapChain::MAX_FRAMES)
 			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * SwapChain::MAX_FRAMES)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, SwapChain::MAX_FRAMES)
 			.build();
-		loadSceneObjects();
+		bindlessHeap_ = std::make_unique<BindlessHeap>(device_);
+		gpuProfiler_ = std::make_unique<GpuProfiler>(device_);
+		pipelineStatistics_ = std::make_unique<PipelineStatistics>(device_);
+		if (headless_ && headless_->loadScene) {
+			headless_->loadScene(device_, scene_);
+		} else {
+			loadSceneObjects();
+		}
 	}
 
 	App::~App() = default;
 
+	void App::enableTelemetry(TelemetryOptions options) {
+		telemetry_ = std::make_unique<Telemetry>(std::move(options));
+		telemetry_->addSource([this](MetricsWriter& metrics) { device_.collectTelemetry(metrics); });
+		telemetry_->addSource([this](MetricsWriter& metrics) { renderer_->collectTelemetry(metrics); });
+		telemetry_->addSource([](MetricsWriter& metrics) { Model::collectTelemetry(metrics); });
+		telemetry_->addSource([this](MetricsWriter& metrics) { frameTimes_->collectTelemetry(metrics); });
+	}
+
+	bool App::running(uint32_t frame) {
+		if (headless_) {
+			return frame < headless_->frames;
+		}
+		return !window_->shouldClose();
+	}
+
 	void App::run() {
+		ENGINE_THREAD_NAME("main");
 		std::vector<std::unique_ptr<Buffer>> ubo_buffers { SwapChain::MAX_FRAMES };
 		for (size_t i = 0; i < ubo_buffers.size(); i++) {
 			ubo_buffers[i] = std::make_unique<Buffer>(
@@ -37,86 +82,263 @@ namespace engine {
 			ubo_buffers[i]->map();
 		}
 
+		// declared before the systems so that it outlives their pending pipelines
+		PipelineFactory pipelines { device_ };
+		ClusteredLighting lighting { device_ };
+		ShadowSystem shadows { device_, pipelines };
+
 		auto global_set_layout = DescriptorSetLayout::Builder(device_)
 			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(ClusteredLighting::LIGHTS_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(ClusteredLighting::CLUSTERS_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(ClusteredLighting::LIGHT_INDICES_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(ShadowSystem::SHADOW_DATA_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(ShadowSystem::SHADOW_ATLAS_BINDING, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
 			.build();
 
 		std::vector<VkDescriptorSet> global_descriptors_sets { SwapChain::MAX_FRAMES };
 
 		for (size_t i = 0; i < global_descriptors_sets.size(); i++) {
 			auto buffer_info = ubo_buffers[i]->decriptorInfo();
+			auto lights_info = lighting.lightsInfo(static_cast<int>(i));
+			auto clusters_info = lighting.clustersInfo(static_cast<int>(i));
+			auto light_indices_info = lighting.lightIndicesInfo(static_cast<int>(i));
+			auto shadow_data_info = shadows.shadowDataInfo(static_cast<int>(i));
+			auto shadow_atlas_info = shadows.atlasInfo();
 			DescriptorWriter(*global_set_layout, *globalPool_)
 				.writeBuffer(0, &buffer_info)
+				.writeBuffer(ClusteredLighting::LIGHTS_BINDING, &lights_info)
+				.writeBuffer(ClusteredLighting::CLUSTERS_BINDING, &clusters_info)
+				.writeBuffer(ClusteredLighting::LIGHT_INDICES_BINDING, &light_indices_info)
+				.writeBuffer(ShadowSystem::SHADOW_DATA_BINDING, &shadow_data_info)
+				.writeImage(ShadowSystem::SHADOW_ATLAS_BINDING, &shadow_atlas_info)
 				.build(global_descriptors_sets[i]);
 		}
 
-		RenderSystem render { device_, renderer_.swapChainRenderPass(), global_set_layout->descriptorSetLayout() };
-		PointLightSystem light_system { device_, renderer_.swapChainRenderPass(), global_set_layout->descriptorSetLayout() };
+		RenderSystem render { device_, pipelines, renderer_->swapChainRenderPass(), global_set_layout->descriptorSetLayout(), *bindlessHeap_ };
+		PointLightSystem light_system { device_, pipelines, renderer_->swapChainRenderPass(), global_set_layout->descriptorSetLayout() };
+		RenderSystem g_buffer_render { device_, pipelines, renderer_->deferredRenderPass(), global_set_layout->descriptorSetLayout(), *bindlessHeap_, RenderPath::Deferred };
+		PointLightSystem deferred_light_system { device_, pipelines, renderer_->deferredRenderPass(), global_set_layout->descriptorSetLayout(), RenderPath::Deferred };
+		DeferredRenderSystem deferred_lighting { device_, pipelines, renderer_->deferredRenderPass(), global_set_layout->descriptorSetLayout() };
+		bool pipelines_reported = false;
+		std::array<bool, 4> keys_held {};
+		auto key_pressed = [&](int key, bool& held) {
+			if (window_ == nullptr) {
+				return false;
+			}
+			const bool down = glfwGetKey(window_->glfwWindow(), key) == GLFW_PRESS;
+			const bool pressed = down && !held;
+			held = down;
+			return pressed;
+		};
 		Camera camera {};
 		auto current_time = std::chrono::high_resolution_clock::now();
-		auto viewer_obj = SceneObject::createObject();
+		TransformComponent viewer_transform {};
 		KeyboardMoveController camera_controller {};
+		float title_time = 0.0F;
+		std::array<char, 128> title {}; // NOLINT
+		const bool log_frame_times = window_ != nullptr || headless_->logFrameTimes;
+		using StageClock = std::chrono::steady_clock;
+		auto stage_ms = [](StageClock::time_point& since) {
+			const auto now = StageClock::now();
+			const double ms = std::chrono::duration<double, std::milli>(now - since).count();
+			since = now;
+			return ms;
+		};
 
-		while (!window_.shouldClose()) {
-			glfwPollEvents();
+		// uploads of the startup scene are not part of the first frame
+		device_.counters().takeFrame();
+		for (uint32_t frame = 0; running(frame); frame++) {
+			ENGINE_ZONE("frame");
+			const uint64_t allocations_start = AllocationTracker::threadAllocations();
+			const auto frame_start = StageClock::now();
+			auto stage_start = frame_start;
+			FrameStats stats {};
+			stats.frame = frame;
+			if (window_ != nullptr) {
+				glfwPollEvents();
+			}
+
+			if (key_pressed(TOGGLE_RENDER_PATH_KEY, keys_held[0])) {
+				renderPath_ = renderPath_ == RenderPath::Forward ? RenderPath::Deferred : RenderPath::Forward;
+			}
+			if (key_pressed(TOGGLE_SPECULAR_KEY, keys_held[1])) {
+				ShadingFeatures features = render.shadingFeatures();
+				features.specular = !features.specular;
+				render.setShadingFeatures(features);
+			}
+			if (key_pressed(TOGGLE_SHADING_MODEL_KEY, keys_held[2])) {
+				ShadingFeatures features = render.shadingFeatures();
+				features.model = features.model == ShadingModel::Lambert ? ShadingModel::HalfLambert : ShadingModel::Lambert;
+				render.setShadingFeatures(features);
+			}
+			if (key_pressed(DUMP_TRACE_KEY, keys_held[3])) {
+				writeTrace(tracePath_.empty() ? DEFAULT_TRACE_PATH : tracePath_);
+			}
 
 			auto new_time = std::chrono::high_resolution_clock::now();
-			const float frame_time = std::chrono::duration<float, std::chrono::seconds::period>(new_time - current_time).count();
+			float frame_time = std::chrono::duration<float, std::chrono::seconds::period>(new_time - current_time).count();
 			current_time = new_time;
+			if (headless_ && headless_->fixedFrameTime > 0.0F) {
+				frame_time = headless_->fixedFrameTime;
+			}
 
-			camera_controller.moveInPlayeXZ(window_.glfwWindow(), frame_time, viewer_obj);
-			camera.viewYXZ(viewer_obj.transform.translation, viewer_obj.transform.rotation);
+			if (window_ != nullptr) {
+				camera_controller.moveInPlayeXZ(window_->glfwWindow(), frame_time, viewer_transform);
+			} else if (headless_->cameraPath) {
+				headless_->cameraPath(frame, viewer_transform);
+			}
+			camera.viewYXZ(viewer_transform.translation(), viewer_transform.rotation());
 
-			const float aspect = renderer_.aspectRatio();
+			const float aspect = renderer_->aspectRatio();
 			camera.perspectiveProjection(glm::radians(50.0F), aspect, 0.1F, 10.0F); // NOLINT
-			if (auto* cmd_buf = renderer_.beginFrame()) {
+			stage_start = StageClock::now();
+			if (auto* cmd_buf = renderer_->beginFrame()) {
+				stats.acquireMs = stage_ms(stage_start);
 
-				const int frame_idx = renderer_.frameIdx();
+				const int frame_idx = renderer_->frameIdx();
+				gpuProfiler_->beginFrame(cmd_buf, frame_idx);
+				pipelineStatistics_->beginFrame(cmd_buf, frame_idx);
+				bindlessHeap_->collect(frame_idx);
 				FrameInfo frame_info {
 					frame_idx,
 					frame_time,
 					cmd_buf,
 					camera,
 					global_descriptors_sets[frame_idx],
-					sceneObjects_
+					bindlessHeap_->descriptorSet(),
+					scene_,
+					renderer_->frameArena()
 				};
 				GlobalUbo ubo {};
 
 				ubo.projection = camera.projection();
 				ubo.view = camera.view();
 				ubo.inverseView = camera.inverseView();
-				light_system.update(frame_info, ubo);
-				ubo_buffers[frame_idx]->writeToBuffer(&ubo);
-				ubo_buffers[frame_idx]->flush();
-
-				renderer_.beginSwapChainRenderPass(cmd_buf);
-				render.renderSceneObjects(frame_info);
-				light_system.render(frame_info);
-				renderer_.endSwapChainRenderPass(cmd_buf);
-				renderer_.endFrame();
+				light_system.update(frame_info);
+				scene_.updateTransforms();
+				lighting.update(frame_info, ubo, renderer_->swapChainExtent());
+				shadows.update(frame_info, lighting.lightEntities());
+				{
+					ENGINE_ZONE("write global ubo");
+					ubo_buffers[frame_idx]->writeToBuffer(&ubo);
+					ubo_buffers[frame_idx]->flush();
+				}
+				stats.updateMs = stage_ms(stage_start);
+
+				// the frame scope closes before endFrame ends the command buffer
+				{
+					const GpuScope frame_scope { *gpuProfiler_, cmd_buf, "frame" };
+					{
+						const GpuScope shadow_scope { *gpuProfiler_, cmd_buf, "shadows" };
+						shadows.render(frame_info);
+					}
+					stats.shadowMs = stage_ms(stage_start);
+					render.beginFrame(frame_info);
+					g_buffer_render.beginFrame(frame_info);
+					title_time += frame_time;
+					if (title_time >= 1.0F && window_ != nullptr) {
+						const auto& variant = *render.pipelineVariants().variants()[render.currentVariant()];
+						std::snprintf(title.data(), title.size(), "App | shadow views re-rendered: %u | shading variant %u: %f ms",
+							shadows.renderedViews(), render.currentVariant(), variant.gpuMs);
+						window_->setTitle(title.data());
+						title_time = 0.0F;
+					}
+
+					renderer_->beginSwapChainRenderPass(cmd_buf, renderPath_);
+					if (renderPath_ == RenderPath::Forward) {
+						{
+							const GpuScope scene_scope { *gpuProfiler_, cmd_buf, "scene" };
+							render.renderSceneObjects(frame_info);
+						}
+						const GpuScope lights_scope { *gpuProfiler_, cmd_buf, "light_billboards" };
+						light_system.render(frame_info, lighting.lightCount());
+					} else {
+						{
+							const GpuScope scene_scope { *gpuProfiler_, cmd_buf, "scene" };
+							g_buffer_render.renderSceneObjects(frame_info);
+						}
+						renderer_->nextSubpass(cmd_buf);
+						{
+							const GpuScope lighting_scope { *gpuProfiler_, cmd_buf, "deferred_lighting" };
+							deferred_lighting.render(frame_info, renderer_->gBuffer());
+						}
+						const GpuScope lights_scope { *gpuProfiler_, cmd_buf, "light_billboards" };
+						deferred_light_system.render(frame_info, lighting.lightCount());
+					}
+					renderer_->endSwapChainRenderPass(cmd_buf);
+				}
+				pipelineStatistics_->endFrame(cmd_buf);
+				stats.recordMs = stage_ms(stage_start);
+				renderer_->endFrame();
+				stats.submitMs = stage_ms(stage_start);
+				stats.fenceWaitMs = renderer_->fenceWaitMs();
+
+				stats.shadowViews = shadows.renderedViews();
+				stats.gpuStatistics = pipelineStatistics_->latest();
+			}
+			stats.counters = device_.counters().takeFrame();
+			stats.frameMs = std::chrono::duration<double, std::milli>(StageClock::now() - frame_start).count();
+			stats.allocations = AllocationTracker::threadAllocations() - allocations_start;
+			const auto hitch = frameTimes_->record(stats);
+			if (log_frame_times && hitch) {
+				FrameTimeStats::writeHitch(std::cout, *hitch);
+			}
+			if (log_frame_times && frameTimes_->intervalComplete()) {
+				frameTimes_->writeSummary(std::cout);
+			}
+			if (telemetry_ != nullptr) {
+				telemetry_->recordFrame(stats);
+			}
+			if (headless_ && headless_->onFrame) {
+				headless_->onFrame(stats);
+			}
+
+			// once every startup pipeline is built its shader modules can go
+			if (!pipelines_reported && pipelines.trimShaderModules()) {
+				const auto cache_stats = device_.pipelineCacheStats();
+				std::cout << "pipelines: " << cache_stats.pipelines << " created in " << pipelines.lastBatchMs() << " ms wall, "
+					<< cache_stats.creationMs << " ms summed over workers (" << (cache_stats.warm ? "warm" : "cold") << " cache), "
+					<< pipelines.uniquePipelines() << " unique of " << pipelines.requestedPipelines() << " requested" << "\n";
+				device_.savePipelineCache();
+				pipelines_reported = true;
 			}
 		}
 		vkDeviceWaitIdle(device_.device());
+		if (window_ != nullptr && gpuProfiler_->enabled()) {
+			gpuProfiler_->writeCsv(std::cout);
+		}
+		if (!tracePath_.empty()) {
+			writeTrace(tracePath_);
+		}
+	}
+
+	void App::writeTrace(const std::string& path) {
+		if (!CpuProfiler::compiledIn()) {
+			std::cout << "no CPU trace, the engine was built without ENGINE_PROFILE" << "\n";
+		} else if (CpuProfiler::writeChromeTrace(path)) {
+			std::cout << "CPU trace written to " << path << "\n";
+		} else {
+			std::cerr << "failed to write CPU trace " << path << "\n";
+		}
 	}
 
 	void App::loadSceneObjects() {
+		ENGINE_ZONE("App::loadSceneObjects");
 		const std::shared_ptr<Model> model = Model::createModelFromFile(device_, "../assets/models/flat_vase.obj");
-		auto obj = SceneObject::createObject();
-		obj.model = model;
-		obj.transform.translation = { 0.0F, 0.5F, 1.5F }; // NOLINT
-		obj.transform.scale = { 2.5F, 2.5F, 2.5F }; // NOLINT
-		sceneObjects_.emplace(obj.id(), std::move(obj));
+		auto obj = scene_.createModelObject(model);
+		auto& obj_transform = scene_.get<TransformComponent>(obj);
+		obj_transform.setTranslation({ 0.0F, 0.5F, 1.5F }); // NOLINT
+		obj_transform.setScale({ 2.5F, 2.5F, 2.5F }); // NOLINT
 
 		const std::shared_ptr<Model> floor = Model::createModelFromFile(device_, "../assets/models/floor.obj");
-		auto floor_obj = SceneObject::createObject();
-		floor_obj.model = floor;
-		floor_obj.transform.translation = { 0.0F, 0.5F, 0.0F }; // NOLINT
-		floor_obj.transform.scale = { 2.5F, 2.5F, 2.5F }; // NOLINT
-		sceneObjects_.emplace(floor_obj.id(), std::move(floor_obj));
-
-		auto pointLight = SceneObject::createPointLight(0.2F);
-		pointLight.transform.translation = glm::vec4(-1.F, -1.F, -1.F, 1.F);
-		sceneObjects_.emplace(pointLight.id(), std::move(pointLight));
+		auto floor_obj = scene_.createModelObject(floor);
+		auto& floor_transform = scene_.get<TransformComponent>(floor_obj);
+		floor_transform.setTranslation({ 0.0F, 0.5F, 0.0F }); // NOLINT
+		floor_transform.setScale({ 2.5F, 2.5F, 2.5F }); // NOLINT
+
+		auto point_light = scene_.createPointLight(0.2F);
+		scene_.get<TransformComponent>(point_light).setTranslation({ -1.F, -1.F, -1.F });
 	}
 
 }
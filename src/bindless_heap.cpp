@@ -0,0 +1,102 @@
+#include "bindless_heap.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include "cpu_profiler.hpp"
+
+namespace engine {
+
+	namespace {
+
+		const VkDescriptorBindingFlags BINDLESS_BINDING_FLAGS =
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+	}
+
+	BindlessHeap::BindlessHeap(EngineDevice& device) { // NOLINT
+		const auto& support = device.bindlessSupport();
+		storageBuffers_.capacity = std::min(MAX_STORAGE_BUFFERS, support.maxStorageBuffers);
+		sampledImages_.capacity = std::min(MAX_SAMPLED_IMAGES, support.maxSampledImages);
+
+		setLayout_ = DescriptorSetLayout::Builder(device)
+			.addBinding(STORAGE_BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS, storageBuffers_.capacity, BINDLESS_BINDING_FLAGS)
+			.addBinding(SAMPLED_IMAGE_BINDING, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS, sampledImages_.capacity, BINDLESS_BINDING_FLAGS)
+			.layoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
+			.build();
+
+		pool_ = DescriptorPool::Builder(device)
+			.maxSets(1)
+			.poolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBuffers_.capacity)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampledImages_.capacity)
+			.build();
+
+		if (!pool_->allocateDescriptor(setLayout_->descriptorSetLayout(), descriptorSet_)) {
+			throw std::runtime_error("failed to allocate bindless descriptor set");
+		}
+	}
+
+	BindlessHeap::~BindlessHeap() = default;
+
+	BindlessHeap::handle_t BindlessHeap::Slots::allocate() {
+		if (!freeList.empty()) {
+			auto handle = freeList.back();
+			freeList.pop_back();
+			return handle;
+		}
+		if (next >= capacity) {
+			throw std::runtime_error("bindless heap is full");
+		}
+		return next++;
+	}
+
+	BindlessHeap::handle_t BindlessHeap::addStorageBuffer(VkDescriptorBufferInfo buffer_info) {
+		auto handle = storageBuffers_.allocate();
+		updateStorageBuffer(handle, buffer_info);
+		return handle;
+	}
+
+	BindlessHeap::handle_t BindlessHeap::addSampledImage(VkDescriptorImageInfo image_info) {
+		auto handle = sampledImages_.allocate();
+		updateSampledImage(handle, image_info);
+		return handle;
+	}
+
+	void BindlessHeap::updateStorageBuffer(handle_t handle, VkDescriptorBufferInfo buffer_info) {
+		assert(handle < storageBuffers_.next && "Invalid bindless storage buffer handle"); // NOLINT
+		DescriptorWriter(*setLayout_, *pool_)
+			.writeBuffer(STORAGE_BUFFER_BINDING, &buffer_info, handle)
+			.overwrite(descriptorSet_);
+	}
+
+	void BindlessHeap::updateSampledImage(handle_t handle, VkDescriptorImageInfo image_info) {
+		assert(handle < sampledImages_.next && "Invalid bindless sampled image handle"); // NOLINT
+		DescriptorWriter(*setLayout_, *pool_)
+			.writeImage(SAMPLED_IMAGE_BINDING, &image_info, handle)
+			.overwrite(descriptorSet_);
+	}
+
+	void BindlessHeap::removeStorageBuffer(handle_t handle, int frame_idx) {
+		assert(handle < storageBuffers_.next && "Invalid bindless storage buffer handle"); // NOLINT
+		storageBuffers_.retired[frame_idx].push_back(handle);
+	}
+
+	void BindlessHeap::removeSampledImage(handle_t handle, int frame_idx) {
+		assert(handle < sampledImages_.next && "Invalid bindless sampled image handle"); // NOLINT
+		sampledImages_.retired[frame_idx].push_back(handle);
+	}
+
+	void BindlessHeap::collect(int frame_idx) {
+		ENGINE_ZONE("BindlessHeap::collect");
+		for (auto* slots : { &storageBuffers_, &sampledImages_ }) {
+			auto& retired = slots->retired[frame_idx];
+			slots->freeList.insert(slots->freeList.end(), retired.begin(), retired.end());
+			retired.clear();
+		}
+	}
+
+}
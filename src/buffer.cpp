@@ -53,10 +53,12 @@ namespace engine {
 		assert(mapped_ && "Cannot copy to unmapped buffer"); // NOLINT
 		if (size == VK_WHOLE_SIZE) {
 			memcpy(mapped_, data, bufferSize_);
+			device_.counters().countBufferWrite(bufferSize_);
 		} else {
 			char* mem_offset = static_cast<char*>(mapped_);
 			mem_offset += offset;
 			memcpy(mem_offset, data, size);
+			device_.counters().countBufferWrite(size);
 		}
 	}
 
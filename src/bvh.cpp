@@ -0,0 +1,230 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine {
+
+	Bvh::proxy_t Bvh::insert(const Aabb& bounds, Entity entity) {
+		const proxy_t leaf = allocateNode();
+		nodes_[leaf].bounds = bounds.inflated(FAT_MARGIN);
+		nodes_[leaf].entity = entity;
+		nodes_[leaf].height = 0;
+		insertLeaf(leaf);
+		leafCount_++;
+		return leaf;
+	}
+
+	void Bvh::remove(proxy_t proxy) {
+		assert(proxy >= 0 && proxy < static_cast<proxy_t>(nodes_.size()) && nodes_[proxy].isLeaf() && "Invalid BVH proxy"); // NOLINT
+		removeLeaf(proxy);
+		freeNode(proxy);
+		leafCount_--;
+	}
+
+	bool Bvh::move(proxy_t proxy, const Aabb& bounds) {
+		assert(proxy >= 0 && proxy < static_cast<proxy_t>(nodes_.size()) && nodes_[proxy].isLeaf() && "Invalid BVH proxy"); // NOLINT
+		if (nodes_[proxy].bounds.contains(bounds)) {
+			return false;
+		}
+		removeLeaf(proxy);
+		nodes_[proxy].bounds = bounds.inflated(FAT_MARGIN);
+		insertLeaf(proxy);
+		return true;
+	}
+
+	Entity Bvh::raycast(const Ray& ray, float max_t, float& hit_t) const {
+		Entity hit = NULL_ENTITY;
+		hit_t = max_t;
+		if (root_ == NULL_NODE) {
+			return hit;
+		}
+		stack_.clear();
+		stack_.push_back(root_);
+		while (!stack_.empty()) {
+			const Node& node = nodes_[stack_.back()];
+			stack_.pop_back();
+			// shrinking the limit to the closest hit so far prunes everything behind it
+			float t = 0.0F;
+			if (!ray.intersects(node.bounds, hit_t, t)) {
+				continue;
+			}
+			if (node.isLeaf()) {
+				hit = node.entity;
+				hit_t = t;
+			} else {
+				stack_.push_back(node.left);
+				stack_.push_back(node.right);
+			}
+		}
+		return hit;
+	}
+
+	Bvh::proxy_t Bvh::allocateNode() {
+		if (!freeList_.empty()) {
+			const proxy_t node = freeList_.back();
+			freeList_.pop_back();
+			nodes_[node] = Node {};
+			return node;
+		}
+		nodes_.emplace_back();
+		return static_cast<proxy_t>(nodes_.size() - 1);
+	}
+
+	void Bvh::freeNode(proxy_t node) {
+		nodes_[node].height = -1;
+		freeList_.push_back(node);
+	}
+
+	// NOLINTBEGIN
+	// Branch and bound descent from Box2D's b2DynamicTree: go down the child whose enlargement costs
+	// least until making the leaf a sibling of the current node is cheaper than descending.
+	void Bvh::insertLeaf(proxy_t leaf) {
+		if (root_ == NULL_NODE) {
+			root_ = leaf;
+			nodes_[leaf].parent = NULL_NODE;
+			return;
+		}
+
+		const Aabb leaf_bounds = nodes_[leaf].bounds;
+		proxy_t index = root_;
+		while (!nodes_[index].isLeaf()) {
+			const Node& node = nodes_[index];
+			const float area = node.bounds.surfaceArea();
+			const float combined_area = node.bounds.merged(leaf_bounds).surfaceArea();
+			const float cost = 2.0F * combined_area;
+			const float inheritance_cost = 2.0F * (combined_area - area);
+
+			auto child_cost = [&](proxy_t child) {
+				const Aabb merged = leaf_bounds.merged(nodes_[child].bounds);
+				if (nodes_[child].isLeaf()) {
+					return merged.surfaceArea() + inheritance_cost;
+				}
+				return merged.surfaceArea() - nodes_[child].bounds.surfaceArea() + inheritance_cost;
+			};
+			const float cost_left = child_cost(node.left);
+			const float cost_right = child_cost(node.right);
+			if (cost < cost_left && cost < cost_right) {
+				break;
+			}
+			index = cost_left < cost_right ? node.left : node.right;
+		}
+
+		const proxy_t sibling = index;
+		const proxy_t old_parent = nodes_[sibling].parent;
+		const proxy_t new_parent = allocateNode();
+		nodes_[new_parent].parent = old_parent;
+		nodes_[new_parent].bounds = leaf_bounds.merged(nodes_[sibling].bounds);
+		nodes_[new_parent].height = nodes_[sibling].height + 1;
+		nodes_[new_parent].left = sibling;
+		nodes_[new_parent].right = leaf;
+		nodes_[sibling].parent = new_parent;
+		nodes_[leaf].parent = new_parent;
+		if (old_parent == NULL_NODE) {
+			root_ = new_parent;
+		} else if (nodes_[old_parent].left == sibling) {
+			nodes_[old_parent].left = new_parent;
+		} else {
+			nodes_[old_parent].right = new_parent;
+		}
+
+		refit(nodes_[leaf].parent);
+	}
+
+	void Bvh::removeLeaf(proxy_t leaf) {
+		if (leaf == root_) {
+			root_ = NULL_NODE;
+			return;
+		}
+
+		const proxy_t parent = nodes_[leaf].parent;
+		const proxy_t grand_parent = nodes_[parent].parent;
+		const proxy_t sibling = nodes_[parent].left == leaf ? nodes_[parent].right : nodes_[parent].left;
+
+		if (grand_parent == NULL_NODE) {
+			root_ = sibling;
+			nodes_[sibling].parent = NULL_NODE;
+			freeNode(parent);
+			return;
+		}
+
+		if (nodes_[grand_parent].left == parent) {
+			nodes_[grand_parent].left = sibling;
+		} else {
+			nodes_[grand_parent].right = sibling;
+		}
+		nodes_[sibling].parent = grand_parent;
+		freeNode(parent);
+		refit(grand_parent);
+	}
+
+	// walks to the root restoring bounds and heights, rotating wherever the children are unbalanced
+	void Bvh::refit(proxy_t node) {
+		while (node != NULL_NODE) {
+			node = balance(node);
+			const Node& left = nodes_[nodes_[node].left];
+			const Node& right = nodes_[nodes_[node].right];
+			nodes_[node].height = 1 + std::max(left.height, right.height);
+			nodes_[node].bounds = left.bounds.merged(right.bounds);
+			node = nodes_[node].parent;
+		}
+	}
+
+	// Rotates the taller grandchild up when the subtree heights differ by more than one. Returns the
+	// node now at a's position.
+	Bvh::proxy_t Bvh::balance(proxy_t a) {
+		Node& node_a = nodes_[a];
+		if (node_a.isLeaf() || node_a.height < 2) {
+			return a;
+		}
+
+		const proxy_t b = node_a.left;
+		const proxy_t c = node_a.right;
+		const int height_diff = nodes_[c].height - nodes_[b].height;
+
+		auto rotate_up = [&](proxy_t up, proxy_t other) {
+			// `up` replaces a; a takes up's shorter child and keeps `other`
+			Node& node_up = nodes_[up];
+			const proxy_t f = node_up.left;
+			const proxy_t g = node_up.right;
+
+			node_up.left = a;
+			node_up.parent = nodes_[a].parent;
+			nodes_[a].parent = up;
+			if (node_up.parent == NULL_NODE) {
+				root_ = up;
+			} else if (nodes_[node_up.parent].left == a) {
+				nodes_[node_up.parent].left = up;
+			} else {
+				nodes_[node_up.parent].right = up;
+			}
+
+			const bool keep_f = nodes_[f].height > nodes_[g].height;
+			const proxy_t kept = keep_f ? f : g;
+			const proxy_t moved = keep_f ? g : f;
+			node_up.right = kept;
+			if (nodes_[a].left == up) {
+				nodes_[a].left = moved;
+			} else {
+				nodes_[a].right = moved;
+			}
+			nodes_[moved].parent = a;
+
+			nodes_[a].bounds = nodes_[other].bounds.merged(nodes_[moved].bounds);
+			nodes_[a].height = 1 + std::max(nodes_[other].height, nodes_[moved].height);
+			node_up.bounds = nodes_[a].bounds.merged(nodes_[kept].bounds);
+			node_up.height = 1 + std::max(nodes_[a].height, nodes_[kept].height);
+			return up;
+		};
+
+		if (height_diff > 1) {
+			return rotate_up(c, b);
+		}
+		if (height_diff < -1) {
+			return rotate_up(b, c);
+		}
+		return a;
+	}
+	// NOLINTEND
+
+}
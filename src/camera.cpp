@@ -15,6 +15,8 @@ namespace engine {
 		projectionMatrix_[3][0] = -(right + left) / (right - left);
 		projectionMatrix_[3][1] = -(bottom + top) / (bottom - top);
 		projectionMatrix_[3][2] = -near / (far - near);
+		near_ = near;
+		far_ = far;
 	}
 
 	void Camera::perspectiveProjection(float fovy, float aspect, float near, float far) {
@@ -26,6 +28,8 @@ namespace engine {
 		projectionMatrix_[2][2] = far / (far - near);
 		projectionMatrix_[2][3] = 1.F;
 		projectionMatrix_[3][2] = -(far * near) / (far - near);
+		near_ = near;
+		far_ = far;
 	}
 
 	void Camera::viewDirection(glm::vec3 position, glm::vec3 direction, glm::vec3 up) {
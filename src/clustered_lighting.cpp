@@ -0,0 +1,194 @@
+#include "clustered_lighting.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "swap_chain.hpp"
+#include "cpu_profiler.hpp"
+
+namespace engine {
+
+	namespace {
+
+		uint32_t tile(float ndc, uint32_t tiles) {
+			const float t = std::floor((ndc * 0.5F + 0.5F) * static_cast<float>(tiles)); // NOLINT
+			return static_cast<uint32_t>(std::clamp(t, 0.0F, static_cast<float>(tiles - 1)));
+		}
+
+		// conservative projected extent of [center - radius, center + radius] on one axis: the most
+		// negative edge divides by the nearest depth when left of the axis and the farthest when right
+		void projectedRange(float center, float radius, float scale, float near_z, float far_z, float& lo, float& hi) {
+			const float min_edge = center - radius;
+			const float max_edge = center + radius;
+			lo = scale * min_edge / (min_edge < 0.0F ? near_z : far_z);
+			hi = scale * max_edge / (max_edge > 0.0F ? near_z : far_z);
+		}
+
+	}
+
+	glm::vec4 LightClusters::shaderScale(float width, float height, float near, float far) {
+		const float log_depth = std::log(far / near);
+		const auto slices = static_cast<float>(CLUSTERS_Z);
+		return {
+			static_cast<float>(CLUSTERS_X) / width,
+			static_cast<float>(CLUSTERS_Y) / height,
+			slices / log_depth,
+			-slices * std::log(near) / log_depth
+		};
+	}
+
+	// NOLINTBEGIN
+	uint32_t LightClusters::build(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		float near,
+		float far,
+		const PointLight* lights,
+		uint32_t light_count,
+		ClusterRange* clusters,
+		uint32_t* indices,
+		uint32_t index_capacity
+	) {
+		const glm::vec4 scale = shaderScale(1.0F, 1.0F, near, far);
+		auto slice = [&](float z) {
+			const float s = std::floor(std::log(z) * scale.z + scale.w);
+			return static_cast<uint32_t>(std::clamp(s, 0.0F, static_cast<float>(CLUSTERS_Z - 1)));
+		};
+
+		boxes_.clear();
+		lightOfBox_.clear();
+		for (uint32_t i = 0; i < light_count; i++) {
+			const glm::vec4 center = view * glm::vec4(glm::vec3(lights[i].position), 1.0F);
+			const float radius = std::sqrt(lights[i].color.w / PointLightComponent::CUTOFF);
+			const float near_z = center.z - radius;
+			const float far_z = center.z + radius;
+			if (far_z < near || near_z > far) {
+				continue;
+			}
+
+			LightBox box { 0, CLUSTERS_X - 1, 0, CLUSTERS_Y - 1, slice(std::max(near_z, near)), slice(std::min(far_z, far)) };
+			// a sphere crossing the near plane can cover any tile
+			if (near_z > near) {
+				float lo_x = 0.0F;
+				float hi_x = 0.0F;
+				float lo_y = 0.0F;
+				float hi_y = 0.0F;
+				projectedRange(center.x, radius, projection[0][0], near_z, far_z, lo_x, hi_x);
+				projectedRange(center.y, radius, projection[1][1], near_z, far_z, lo_y, hi_y);
+				if (hi_x < -1.0F || lo_x > 1.0F || hi_y < -1.0F || lo_y > 1.0F) {
+					continue;
+				}
+				box.minX = tile(lo_x, CLUSTERS_X);
+				box.maxX = tile(hi_x, CLUSTERS_X);
+				box.minY = tile(lo_y, CLUSTERS_Y);
+				box.maxY = tile(hi_y, CLUSTERS_Y);
+			}
+			boxes_.push_back(box);
+			lightOfBox_.push_back(i);
+		}
+
+		// counting pass, prefix sum, then scatter; the output may be write combined memory, so it is only
+		// ever written
+		cursor_.assign(CLUSTER_COUNT, 0);
+		for (const auto& box : boxes_) {
+			for (uint32_t z = box.minZ; z <= box.maxZ; z++) {
+				for (uint32_t y = box.minY; y <= box.maxY; y++) {
+					const uint32_t row = CLUSTERS_X * (y + CLUSTERS_Y * z);
+					for (uint32_t x = box.minX; x <= box.maxX; x++) {
+						cursor_[row + x]++;
+					}
+				}
+			}
+		}
+		ends_.resize(CLUSTER_COUNT);
+		uint32_t offset = 0;
+		for (uint32_t i = 0; i < CLUSTER_COUNT; i++) {
+			const uint32_t count = std::min(cursor_[i], index_capacity - offset);
+			clusters[i] = ClusterRange { offset, count };
+			cursor_[i] = offset;
+			offset += count;
+			ends_[i] = offset;
+		}
+		for (size_t b = 0; b < boxes_.size(); b++) {
+			const auto& box = boxes_[b];
+			for (uint32_t z = box.minZ; z <= box.maxZ; z++) {
+				for (uint32_t y = box.minY; y <= box.maxY; y++) {
+					const uint32_t row = CLUSTERS_X * (y + CLUSTERS_Y * z);
+					for (uint32_t x = box.minX; x <= box.maxX; x++) {
+						if (cursor_[row + x] < ends_[row + x]) {
+							indices[cursor_[row + x]++] = lightOfBox_[b];
+						}
+					}
+				}
+			}
+		}
+		return offset;
+	}
+	// NOLINTEND
+
+	ClusteredLighting::ClusteredLighting(EngineDevice& device) {
+		auto create_buffers = [&](std::vector<std::unique_ptr<Buffer>>& buffers, VkDeviceSize instance_size, uint32_t count) {
+			buffers.resize(SwapChain::MAX_FRAMES);
+			for (auto& buffer : buffers) {
+				buffer = std::make_unique<Buffer>(
+					device,
+					instance_size,
+					count,
+					VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+				);
+				buffer->map();
+			}
+		};
+		create_buffers(lightBuffers_, sizeof(PointLight), MAX_LIGHTS);
+		create_buffers(clusterBuffers_, sizeof(ClusterRange), LightClusters::CLUSTER_COUNT);
+		create_buffers(indexBuffers_, sizeof(uint32_t), MAX_LIGHT_INDICES);
+		visible_.reserve(MAX_LIGHTS);
+		visibleEntities_.reserve(MAX_LIGHTS);
+	}
+
+	void ClusteredLighting::update(FrameInfo& frame_info, GlobalUbo& ubo, VkExtent2D extent) {
+		ENGINE_ZONE("ClusteredLighting::update");
+		const Camera& camera = frame_info.camera;
+		auto& scene = frame_info.scene;
+
+		visible_.clear();
+		visibleEntities_.clear();
+		scene.spatialIndex().query(camera.frustum(), [&](Entity entity) {
+			const auto* light = scene.tryGet<PointLightComponent>(entity);
+			if (light == nullptr || visible_.size() == MAX_LIGHTS) {
+				return;
+			}
+			const glm::vec3 position = scene.worldMatrix(entity)[3];
+			const float billboard_radius = scene.get<TransformComponent>(entity).scale().x;
+			visible_.push_back({ glm::vec4(position, billboard_radius), glm::vec4(light->color, light->lightIntensity) });
+			visibleEntities_.push_back(entity);
+		});
+		const auto light_count = static_cast<uint32_t>(visible_.size());
+
+		auto& light_buffer = *lightBuffers_[frame_info.frameIdx];
+		auto& cluster_buffer = *clusterBuffers_[frame_info.frameIdx];
+		auto& index_buffer = *indexBuffers_[frame_info.frameIdx];
+		if (light_count > 0) {
+			light_buffer.writeToBuffer(visible_.data(), light_count * sizeof(PointLight));
+		}
+		clusters_.build(
+			camera.view(),
+			camera.projection(),
+			camera.nearPlane(),
+			camera.farPlane(),
+			visible_.data(),
+			light_count,
+			static_cast<ClusterRange*>(cluster_buffer.mappedMemory()),
+			static_cast<uint32_t*>(index_buffer.mappedMemory()),
+			MAX_LIGHT_INDICES
+		);
+		light_buffer.flush();
+		cluster_buffer.flush();
+		index_buffer.flush();
+
+		ubo.clusterScale = LightClusters::shaderScale(static_cast<float>(extent.width), static_cast<float>(extent.height), camera.nearPlane(), camera.farPlane());
+		ubo.clusterDims = glm::uvec4(LightClusters::CLUSTERS_X, LightClusters::CLUSTERS_Y, LightClusters::CLUSTERS_Z, light_count);
+	}
+
+}
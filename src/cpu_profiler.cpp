@@ -0,0 +1,179 @@
+#include "cpu_profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace engine {
+
+	namespace {
+
+		const double NS_PER_US = 1000.0;
+		const int TIME_PRECISION = 3;
+
+		// fields are atomics so that a concurrent dump is not a data race, see readRing for the ordering
+		struct ZoneSlot {
+			std::atomic<const char*> name { nullptr };
+			std::atomic<int64_t> beginNs { 0 };
+			std::atomic<int64_t> endNs { 0 };
+		};
+
+		struct Zone {
+			const char* name;
+			int64_t beginNs;
+			int64_t endNs;
+		};
+
+		struct ThreadRing {
+			std::array<ZoneSlot, CpuProfiler::ZONES_PER_THREAD> zones {};
+			// zones ever recorded, the ring holds the last ZONES_PER_THREAD of them
+			std::atomic<uint64_t> head { 0 };
+			std::atomic<const char*> name { nullptr };
+			std::atomic<bool> inUse { true };
+			uint32_t lane = 0;
+		};
+
+		struct Registry {
+			std::mutex mutex;
+			std::vector<std::unique_ptr<ThreadRing>> rings;
+		};
+
+		// never destroyed, threads still running during static destruction may record
+		Registry& registry() {
+			static auto* instance = new Registry {}; // NOLINT
+			return *instance;
+		}
+
+		ThreadRing* acquireRing() {
+			auto& reg = registry();
+			const std::lock_guard<std::mutex> lock { reg.mutex };
+			for (auto& ring : reg.rings) {
+				bool in_use = false;
+				if (ring->inUse.compare_exchange_strong(in_use, true, std::memory_order_acquire)) {
+					ring->name.store(nullptr, std::memory_order_relaxed);
+					return ring.get();
+				}
+			}
+			reg.rings.push_back(std::make_unique<ThreadRing>());
+			reg.rings.back()->lane = static_cast<uint32_t>(reg.rings.size() - 1);
+			return reg.rings.back().get();
+		}
+
+		// hands the ring back when its thread exits
+		struct RingOwner {
+			ThreadRing* ring = acquireRing();
+
+			RingOwner() = default;
+			~RingOwner() { ring->inUse.store(false, std::memory_order_release); }
+			RingOwner(const RingOwner&) = delete;
+			RingOwner& operator=(const RingOwner&) = delete;
+			RingOwner(const RingOwner&&) = delete;
+			RingOwner&& operator=(const RingOwner&&) = delete;
+		};
+
+		ThreadRing& threadRing() {
+			thread_local RingOwner owner {};
+			return *owner.ring;
+		}
+
+		// Copies the zones a ring still holds. Zones the owner overwrote while they were copied are
+		// dropped: they are the ones below the head read afterwards, plus the one being written. Slot
+		// stores are releases and slot loads acquires, so a load that sees an overwrite also sees the
+		// head published before it.
+		void readRing(const ThreadRing& ring, std::vector<Zone>& out) {
+			const uint64_t head = ring.head.load(std::memory_order_acquire);
+			const uint64_t first = head > CpuProfiler::ZONES_PER_THREAD ? head - CpuProfiler::ZONES_PER_THREAD : 0;
+			const size_t start = out.size();
+			for (uint64_t i = first; i < head; i++) {
+				const auto& slot = ring.zones[i % CpuProfiler::ZONES_PER_THREAD];
+				out.push_back({
+					slot.name.load(std::memory_order_acquire),
+					slot.beginNs.load(std::memory_order_acquire),
+					slot.endNs.load(std::memory_order_acquire)
+				});
+			}
+			const uint64_t head_after = ring.head.load(std::memory_order_acquire) + 1;
+			const uint64_t valid_from = head_after > CpuProfiler::ZONES_PER_THREAD ? head_after - CpuProfiler::ZONES_PER_THREAD : 0;
+			if (valid_from > first) {
+				const auto stale = static_cast<size_t>(std::min(valid_from - first, head - first));
+				out.erase(out.begin() + static_cast<std::ptrdiff_t>(start), out.begin() + static_cast<std::ptrdiff_t>(start + stale));
+			}
+		}
+
+	}
+
+	int64_t CpuProfiler::now() {
+		using Clock = std::chrono::steady_clock;
+		static const Clock::time_point start = Clock::now();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+	}
+
+	void CpuProfiler::record(const char* name, int64_t begin_ns, int64_t end_ns) {
+		auto& ring = threadRing();
+		const uint64_t head = ring.head.load(std::memory_order_relaxed);
+		auto& slot = ring.zones[head % ZONES_PER_THREAD];
+		// plain moves on x86, the ordering only matters to a concurrent dump
+		slot.name.store(name, std::memory_order_release);
+		slot.beginNs.store(begin_ns, std::memory_order_release);
+		slot.endNs.store(end_ns, std::memory_order_release);
+		ring.head.store(head + 1, std::memory_order_release);
+	}
+
+	void CpuProfiler::setThreadName(const char* name) {
+		threadRing().name.store(name, std::memory_order_relaxed);
+	}
+
+	bool CpuProfiler::writeChromeTrace(const std::string& path) {
+		std::vector<const ThreadRing*> rings {};
+		{
+			auto& reg = registry();
+			const std::lock_guard<std::mutex> lock { reg.mutex };
+			for (const auto& ring : reg.rings) {
+				rings.push_back(ring.get());
+			}
+		}
+
+		std::ofstream file(path, std::ios::trunc);
+		if (!file.is_open()) {
+			return false;
+		}
+		// names come from string literals in the engine and need no escaping
+		file << std::fixed << std::setprecision(TIME_PRECISION) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		bool first_event = true;
+		auto separator = [&]() -> const char* {
+			const char* sep = first_event ? "\n" : ",\n";
+			first_event = false;
+			return sep;
+		};
+		std::vector<Zone> zones {};
+		for (const auto* ring : rings) {
+			const char* thread_name = ring->name.load(std::memory_order_relaxed);
+			file << separator() << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << ring->lane
+				<< R"(,"args":{"name":")" << (thread_name != nullptr ? thread_name : "thread") << "\"}}";
+			zones.clear();
+			readRing(*ring, zones);
+			for (const auto& zone : zones) {
+				file << separator() << R"({"name":")" << zone.name << R"(","ph":"X","pid":1,"tid":)" << ring->lane
+					<< ",\"ts\":" << static_cast<double>(zone.beginNs) / NS_PER_US
+					<< ",\"dur\":" << static_cast<double>(zone.endNs - zone.beginNs) / NS_PER_US << "}";
+			}
+		}
+		file << "\n]}\n";
+		return file.good();
+	}
+
+	bool CpuProfiler::compiledIn() {
+#ifdef ENGINE_PROFILE
+		return true;
+#else
+		return false;
+#endif
+	}
+
+}
@@ -0,0 +1,98 @@
+#include "deferred_render_system.hpp"
+
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+#include "cpu_profiler.hpp"
+
+namespace engine {
+
+	namespace {
+
+		const uint32_t INPUT_COUNT = 3;
+
+	}
+
+	DeferredRenderSystem::DeferredRenderSystem(EngineDevice& device, PipelineFactory& pipelines, VkRenderPass render_pass, VkDescriptorSetLayout global_set_layout) : device_{ device }  { // NOLINT
+		createInputSets();
+		createPipelineLayout(global_set_layout);
+		createPipeline(pipelines, render_pass);
+	}
+
+	DeferredRenderSystem::~DeferredRenderSystem() {
+		vkDestroyPipelineLayout(device_.device(), pipelineLayout_, nullptr);
+	}
+
+	void DeferredRenderSystem::createInputSets() {
+		inputSetLayout_ = DescriptorSetLayout::Builder(device_)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.build();
+		inputPool_ = DescriptorPool::Builder(device_)
+			.maxSets(SwapChain::MAX_FRAMES)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, INPUT_COUNT * SwapChain::MAX_FRAMES)
+			.build();
+
+		inputDescriptorSets_.resize(SwapChain::MAX_FRAMES);
+		for (auto& set : inputDescriptorSets_) {
+			if (!inputPool_->allocateDescriptor(inputSetLayout_->descriptorSetLayout(), set)) {
+				throw std::runtime_error("failed to allocate G-buffer descriptor set");
+			}
+		}
+	}
+
+	void DeferredRenderSystem::render(FrameInfo& frame_info, const GBufferViews& g_buffer) {
+		ENGINE_ZONE("DeferredRenderSystem::render");
+		// The frame's set is idle once its fence has been waited on, and rewriting it every frame
+		// follows the swap chain's attachments across recreation. Binding order matches
+		// input_attachment_index in deferred_lighting.frag.
+		std::array<VkDescriptorImageInfo, INPUT_COUNT> inputs {{
+			{ VK_NULL_HANDLE, g_buffer.albedo, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+			{ VK_NULL_HANDLE, g_buffer.normal, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+			{ VK_NULL_HANDLE, g_buffer.depth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL }
+		}};
+		auto& input_set = inputDescriptorSets_[frame_info.frameIdx];
+		DescriptorWriter(*inputSetLayout_, *inputPool_, &frame_info.frameArena)
+			.writeImage(0, &inputs[0])
+			.writeImage(1, &inputs[1])
+			.writeImage(2, &inputs[2])
+			.overwrite(input_set);
+
+		pipeline_->bind(frame_info.cmdBuf);
+		const std::array<VkDescriptorSet, 2> descriptor_sets { frame_info.globalDescriptorSet, input_set };
+		vkCmdBindDescriptorSets(frame_info.cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, static_cast<uint32_t>(descriptor_sets.size()), descriptor_sets.data(), 0, nullptr);
+		vkCmdDraw(frame_info.cmdBuf, 3, 1, 0, 0);
+		device_.counters().countDraw(3, 1);
+	}
+
+	void DeferredRenderSystem::createPipelineLayout(VkDescriptorSetLayout global_set_layout) {
+		std::vector<VkDescriptorSetLayout> descriptor_set_layouts { global_set_layout, inputSetLayout_->descriptorSetLayout() };
+
+		VkPipelineLayoutCreateInfo layout_create_info {};
+		layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layout_create_info.setLayoutCount = static_cast<uint32_t>(descriptor_set_layouts.size());
+		layout_create_info.pSetLayouts = descriptor_set_layouts.data();
+		layout_create_info.pushConstantRangeCount = 0;
+		layout_create_info.pPushConstantRanges = nullptr;
+		if (vkCreatePipelineLayout(device_.device(), &layout_create_info, nullptr, &pipelineLayout_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout");
+		}
+	}
+
+	void DeferredRenderSystem::createPipeline(PipelineFactory& pipelines, VkRenderPass render_pass) {
+		assert(pipelineLayout_ && "Cannot create pipeline before pipeline layout"); // NOLINT
+
+		PipelineConfigInfo pipeline_config = Pipeline::defaultPipelineConfigInfo();
+		pipeline_config.attributeDescriptions.clear();
+		pipeline_config.bindingDescriptions.clear();
+		pipeline_config.depthStencilInfo.depthTestEnable = VK_FALSE;
+		pipeline_config.depthStencilInfo.depthWriteEnable = VK_FALSE;
+		pipeline_config.renderPass = render_pass;
+		pipeline_config.subpass = SwapChain::LIGHTING_SUBPASS;
+		pipeline_config.pipelineLayout = pipelineLayout_;
+		pipeline_ = pipelines.create("../shader/build/fullscreen.vert.spv", "../shader/build/deferred_lighting.frag.spv", pipeline_config);
+	}
+
+}
@@ -11,7 +11,8 @@ namespace engine {
 			uint32_t binding,
 			VkDescriptorType desc_type,
 			VkShaderStageFlags stage_flags, // NOLINT
-			uint32_t count) {
+			uint32_t count,
+			VkDescriptorBindingFlags binding_flags) {
 		assert(bindings_.count(binding) == 0 && "Binding already in use"); // NOLINT
 
 		VkDescriptorSetLayoutBinding layout_binding {};
@@ -20,28 +21,52 @@ namespace engine {
 		layout_binding.descriptorCount = count;
 		layout_binding.stageFlags = stage_flags;
 		bindings_[binding] = layout_binding;
+		if (binding_flags != 0) {
+			bindingFlags_[binding] = binding_flags;
+		}
+		return *this;
+	}
+
+	DescriptorSetLayout::Builder& DescriptorSetLayout::Builder::layoutFlags(VkDescriptorSetLayoutCreateFlags flags) {
+		layoutFlags_ = flags;
 		return *this;
 	}
 
 	std::unique_ptr<DescriptorSetLayout> DescriptorSetLayout::Builder::build() const {
-		return std::make_unique<DescriptorSetLayout>(device_, bindings_);
+		return std::make_unique<DescriptorSetLayout>(device_, bindings_, bindingFlags_, layoutFlags_);
 	}
 
 	//DescriptorSetLayout
 
 	DescriptorSetLayout::DescriptorSetLayout( // NOLINT
 		EngineDevice& device,
-		const std::unordered_map<uint32_t,
-		VkDescriptorSetLayoutBinding>& bindings) : device_ { device }, bindings_ { bindings } {
-
-		std::vector<VkDescriptorSetLayoutBinding> layout_binding_set { bindings.size() - 1 };
+		const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding>& bindings,
+		const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& binding_flags,
+		VkDescriptorSetLayoutCreateFlags layout_flags) : device_ { device }, bindings_ { bindings } {
+
+		std::vector<VkDescriptorSetLayoutBinding> layout_binding_set {};
+		std::vector<VkDescriptorBindingFlags> layout_binding_flags {};
+		layout_binding_set.reserve(bindings.size());
+		layout_binding_flags.reserve(bindings.size());
 		for (auto key_value : bindings) {
 			layout_binding_set.push_back(key_value.second);
+			auto flags = binding_flags.find(key_value.first);
+			layout_binding_flags.push_back(flags == binding_flags.end() ? 0 : flags->second);
 		}
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info {};
+		binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		binding_flags_info.bindingCount = static_cast<uint32_t>(layout_binding_flags.size());
+		binding_flags_info.pBindingFlags = layout_binding_flags.data();
+
 		VkDescriptorSetLayoutCreateInfo descriptor_set_layout_info {};
 		descriptor_set_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptor_set_layout_info.flags = layout_flags;
 		descriptor_set_layout_info.bindingCount = static_cast<uint32_t>(layout_binding_set.size());
 		descriptor_set_layout_info.pBindings = layout_binding_set.data();
+		if (!binding_flags.empty()) {
+			descriptor_set_layout_info.pNext = &binding_flags_info;
+		}
 		if (vkCreateDescriptorSetLayout(device_.device(), &descriptor_set_layout_info, nullptr, &descriptorSetLayout_) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create descriptor set layout");
 		}
@@ -116,30 +141,33 @@ namespace engine {
 
 	// DescriptorWriter
 
-	DescriptorWriter::DescriptorWriter(DescriptorSetLayout& set_layout, DescriptorPool& pool) : setLayout_ { set_layout }, pool_ { pool } {}
+	DescriptorWriter::DescriptorWriter(DescriptorSetLayout& set_layout, DescriptorPool& pool, std::pmr::memory_resource* scratch)
+		: setLayout_ { set_layout }, pool_ { pool }, writes_ { scratch } {}
 
-	DescriptorWriter& DescriptorWriter::writeBuffer(uint32_t binding, VkDescriptorBufferInfo *buffer_info) {
+	DescriptorWriter& DescriptorWriter::writeBuffer(uint32_t binding, VkDescriptorBufferInfo *buffer_info, uint32_t array_element) {
 		assert(setLayout_.bindings_.count(binding) == 1 && "Layout does not contain specified binding");
 		auto& binding_description = setLayout_.bindings_[binding];
-		assert(binding_description.descriptorCount == 1 && "Binding single descriptor info but bindingCount expects multiple");
+		assert(array_element < binding_description.descriptorCount && "Array element is out of binding range");
 		VkWriteDescriptorSet write {};
 		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		write.descriptorType = binding_description.descriptorType;
 		write.dstBinding = binding;
+		write.dstArrayElement = array_element;
 		write.pBufferInfo = buffer_info;
 		write.descriptorCount = 1;
 		writes_.push_back(write);
 		return *this;
 	}
 
-	DescriptorWriter& DescriptorWriter::writeImage(uint32_t binding, VkDescriptorImageInfo *image_info) {
+	DescriptorWriter& DescriptorWriter::writeImage(uint32_t binding, VkDescriptorImageInfo *image_info, uint32_t array_element) {
 		assert(setLayout_.bindings_.count(binding) == 1 && "Layout does not contain specified binding");
 		auto& binding_description = setLayout_.bindings_[binding];
-		assert(binding_description.descriptorCount == 1 && "Binding single descriptor info but bindingCount expects multiple");
+		assert(array_element < binding_description.descriptorCount && "Array element is out of binding range");
 		VkWriteDescriptorSet write {};
 		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		write.descriptorType = binding_description.descriptorType;
 		write.dstBinding = binding;
+		write.dstArrayElement = array_element;
 		write.pImageInfo = image_info;
 		write.descriptorCount = 1;
 		writes_.push_back(write);
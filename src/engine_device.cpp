@@ -1,7 +1,12 @@
 #include "engine_device.hpp"
 #include "utils.hpp"
+#include "cpu_profiler.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -11,6 +16,29 @@ namespace engine {
 
 	namespace {
 
+		// Prepended to the driver's cache blob. The blob's own header carries vendor, device and cache
+		// UUID but not the driver version, and a driver update may silently reject or mis-handle old data.
+		struct PipelineCacheFileHeader {
+			std::array<char, 4> magic {};
+			uint32_t dataSize = 0;
+			uint32_t vendorId = 0;
+			uint32_t deviceId = 0;
+			uint32_t driverVersion = 0;
+			std::array<uint8_t, VK_UUID_SIZE> cacheUuid {};
+		};
+
+		const std::array<char, 4> PIPELINE_CACHE_MAGIC { 'E', 'P', 'C', 'H' };
+
+		PipelineCacheFileHeader pipelineCacheHeader(const VkPhysicalDeviceProperties& properties) {
+			PipelineCacheFileHeader header {};
+			header.magic = PIPELINE_CACHE_MAGIC;
+			header.vendorId = properties.vendorID;
+			header.deviceId = properties.deviceID;
+			header.driverVersion = properties.driverVersion;
+			std::memcpy(header.cacheUuid.data(), properties.pipelineCacheUUID, VK_UUID_SIZE);
+			return header;
+		}
+
 		VKAPI_ATTR VkBool32 VKAPI_CALL debug_callback(
 			VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
 			VkDebugUtilsMessageTypeFlagsEXT message_type,
@@ -61,22 +89,27 @@ namespace engine {
 		}
 	}
 
-	EngineDevice::EngineDevice(Window& window): window_{window}  {
+	EngineDevice::EngineDevice(Window* window): window_{window}  {
 		createInstance();
 		setupDebugMessenger();
 		createSurface();
 		pickPhysicalDevice();
 		createLogicalDevice();
 		createCommandPool();
+		createPipelineCache();
 	}
 
 	EngineDevice::~EngineDevice() {
+		savePipelineCache();
+		vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
 		vkDestroyCommandPool(device_, commandPool_, nullptr);
 		vkDestroyDevice(device_, nullptr);
 		if (enabledValidationLayers) {
 			destroy_debug_utils_messenger_ext(instance_, debugMessenger_, nullptr);
 		}
-		vkDestroySurfaceKHR(instance_, surface_, nullptr);
+		if (surface_ != VK_NULL_HANDLE) {
+			vkDestroySurfaceKHR(instance_, surface_, nullptr);
+		}
 		vkDestroyInstance(instance_, nullptr);
 	}
 
@@ -91,7 +124,7 @@ namespace engine {
 		app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		app_info.pEngineName = "No engine";
 		app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		app_info.apiVersion = VK_API_VERSION_1_0;
+		app_info.apiVersion = VK_API_VERSION_1_2;
 
 		VkInstanceCreateInfo create_info {};
 		create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -143,6 +176,55 @@ namespace engine {
 
 		vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
 		std::cout << "physical device: " << properties.deviceName << std::endl;
+		bindlessSupport_ = queryBindlessSupport(physicalDevice_);
+		std::cout << "bindless descriptors: " << bindlessSupport_.maxStorageBuffers << " storage buffers, " << bindlessSupport_.maxSampledImages << " sampled images" << std::endl;
+		VkPhysicalDeviceFeatures features {};
+		vkGetPhysicalDeviceFeatures(physicalDevice_, &features);
+		pipelineStatisticsSupported_ = features.pipelineStatisticsQuery != 0;
+
+		uint32_t extension_count = 0;
+		vkEnumerateDeviceExtensionProperties(physicalDevice_, nullptr, &extension_count, nullptr);
+		std::vector<VkExtensionProperties> extensions(extension_count);
+		vkEnumerateDeviceExtensionProperties(physicalDevice_, nullptr, &extension_count, extensions.data());
+		memoryBudgetSupported_ = std::any_of(extensions.begin(), extensions.end(), [](const VkExtensionProperties& extension) {
+			return strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+		});
+	}
+
+	BindlessSupport EngineDevice::queryBindlessSupport(VkPhysicalDevice device) {
+		BindlessSupport support {};
+		VkPhysicalDeviceProperties device_properties {};
+		vkGetPhysicalDeviceProperties(device, &device_properties);
+		if (device_properties.apiVersion < VK_API_VERSION_1_2) {
+			return support;
+		}
+
+		VkPhysicalDeviceVulkan12Features vulkan12_features {};
+		vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		VkPhysicalDeviceFeatures2 features {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &vulkan12_features;
+		vkGetPhysicalDeviceFeatures2(device, &features);
+
+		VkPhysicalDeviceDescriptorIndexingProperties indexing_properties {};
+		indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+		VkPhysicalDeviceProperties2 properties2 {};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &indexing_properties;
+		vkGetPhysicalDeviceProperties2(device, &properties2);
+
+		support.supported =
+			vulkan12_features.descriptorIndexing != 0 &&
+			vulkan12_features.runtimeDescriptorArray != 0 &&
+			vulkan12_features.descriptorBindingPartiallyBound != 0 &&
+			vulkan12_features.descriptorBindingUpdateUnusedWhilePending != 0 &&
+			vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind != 0 &&
+			vulkan12_features.descriptorBindingSampledImageUpdateAfterBind != 0 &&
+			vulkan12_features.shaderStorageBufferArrayNonUniformIndexing != 0 &&
+			vulkan12_features.shaderSampledImageArrayNonUniformIndexing != 0;
+		support.maxStorageBuffers = indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers;
+		support.maxSampledImages = indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages;
+		return support;
 	}
 
 	void EngineDevice::createLogicalDevice() {
@@ -160,13 +242,31 @@ namespace engine {
 		}
 		VkPhysicalDeviceFeatures device_features {};
 		device_features.samplerAnisotropy = VK_TRUE;
+		device_features.pipelineStatisticsQuery = pipelineStatisticsSupported_ ? VK_TRUE : VK_FALSE;
 		VkDeviceCreateInfo create_info {};
 		create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
 		create_info.pQueueCreateInfos = queue_create_infos.data();
 		create_info.pEnabledFeatures = &device_features;
-		create_info.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions_.size());
-		create_info.ppEnabledExtensionNames = deviceExtensions_.data();
+		enabledDeviceExtensions_ = requiredDeviceExtensions(physicalDevice_);
+		if (memoryBudgetSupported_) {
+			enabledDeviceExtensions_.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		}
+		create_info.enabledExtensionCount = static_cast<uint32_t>(enabledDeviceExtensions_.size());
+		create_info.ppEnabledExtensionNames = enabledDeviceExtensions_.data();
+
+		// required by isDeviceSuitable(), the scene shaders read their object data through BindlessHeap
+		VkPhysicalDeviceVulkan12Features vulkan12_features {};
+		vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		vulkan12_features.descriptorIndexing = VK_TRUE;
+		vulkan12_features.runtimeDescriptorArray = VK_TRUE;
+		vulkan12_features.descriptorBindingPartiallyBound = VK_TRUE;
+		vulkan12_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		vulkan12_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		vulkan12_features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+		vulkan12_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		create_info.pNext = &vulkan12_features;
 
 		if (this->enabledValidationLayers) {
 			create_info.enabledLayerCount = static_cast<uint32_t>(validationLayers_.size());
@@ -194,21 +294,113 @@ namespace engine {
 		}
 	}
 
+	void EngineDevice::createPipelineCache() {
+		const std::vector<char> initial_data = loadPipelineCacheData();
+		VkPipelineCacheCreateInfo cache_info {};
+		cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cache_info.initialDataSize = initial_data.size();
+		cache_info.pInitialData = initial_data.empty() ? nullptr : initial_data.data();
+		if (vkCreatePipelineCache(device_, &cache_info, nullptr, &pipelineCache_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline cache");
+		}
+		pipelineCacheStats_.warm = !initial_data.empty();
+	}
+
+	// A missing or stale cache file is not an error, the cache just starts cold
+	std::vector<char> EngineDevice::loadPipelineCacheData() {
+		std::ifstream file(PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary);
+		if (!file.is_open()) {
+			return {};
+		}
+		const auto file_size = static_cast<size_t>(file.tellg());
+		file.seekg(0);
+		PipelineCacheFileHeader header {};
+		file.read(reinterpret_cast<char*>(&header), sizeof(header)); // NOLINT
+		const PipelineCacheFileHeader expected = pipelineCacheHeader(properties);
+		if (!file || header.magic != expected.magic || header.vendorId != expected.vendorId || header.deviceId != expected.deviceId
+			|| header.driverVersion != expected.driverVersion || header.cacheUuid != expected.cacheUuid) {
+			return {};
+		}
+
+		// a truncated or corrupt file must not make us allocate whatever size it claims
+		if (header.dataSize < sizeof(VkPipelineCacheHeaderVersionOne) || header.dataSize > file_size - sizeof(header)) {
+			return {};
+		}
+		std::vector<char> data(header.dataSize);
+		file.read(data.data(), static_cast<std::streamsize>(data.size()));
+		if (!file) {
+			return {};
+		}
+		// the driver validates its blob as well, but a mismatch there is reported inconsistently
+		VkPipelineCacheHeaderVersionOne blob_header {};
+		std::memcpy(&blob_header, data.data(), sizeof(blob_header));
+		if (blob_header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || blob_header.vendorID != expected.vendorId
+			|| blob_header.deviceID != expected.deviceId || std::memcmp(blob_header.pipelineCacheUUID, expected.cacheUuid.data(), VK_UUID_SIZE) != 0) {
+			return {};
+		}
+		return data;
+	}
+
+	PipelineCacheStats EngineDevice::pipelineCacheStats() const {
+		const std::lock_guard<std::mutex> lock { pipelineCacheStatsMutex_ };
+		return pipelineCacheStats_;
+	}
+
+	void EngineDevice::recordPipelineCreation(double ms) {
+		const std::lock_guard<std::mutex> lock { pipelineCacheStatsMutex_ };
+		pipelineCacheStats_.pipelines++;
+		pipelineCacheStats_.creationMs += ms;
+	}
+
+	void EngineDevice::savePipelineCache() {
+		ENGINE_ZONE("EngineDevice::savePipelineCache");
+		size_t size = 0;
+		if (vkGetPipelineCacheData(device_, pipelineCache_, &size, nullptr) != VK_SUCCESS || size == 0) {
+			return;
+		}
+		std::vector<char> data(size);
+		if (vkGetPipelineCacheData(device_, pipelineCache_, &size, data.data()) != VK_SUCCESS) {
+			return;
+		}
+		PipelineCacheFileHeader header = pipelineCacheHeader(properties);
+		header.dataSize = static_cast<uint32_t>(size);
+
+		// write then rename so a crash mid write never leaves a torn cache behind
+		const std::string temp_path = std::string(PIPELINE_CACHE_PATH) + ".tmp";
+		{
+			std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+			if (!file.is_open()) {
+				return;
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header)); // NOLINT
+			file.write(data.data(), static_cast<std::streamsize>(size));
+			if (!file) {
+				return;
+			}
+		}
+		std::error_code error {};
+		std::filesystem::rename(temp_path, PIPELINE_CACHE_PATH, error);
+	}
+
 	void EngineDevice::createSurface() {
-		window_.createWindowSurface(instance_, &surface_);
+		if (headless()) {
+			return;
+		}
+		window_->createWindowSurface(instance_, &surface_);
 	}
 
 	bool EngineDevice::isDeviceSuitable(VkPhysicalDevice device) {
 		auto indices = findQueueFamilies(device);
 		auto extension_supported = checkDeviceExtensionSupport(device);
-		auto swap_chain_adequate = false;
-		if (extension_supported) {
+		auto swap_chain_adequate = headless();
+		if (extension_supported && !headless()) {
 			auto swap_chain_support = querySwapChainSupport(device);
 			swap_chain_adequate = !swap_chain_support.formats.empty() && !swap_chain_support.presentModes.empty();
 		}
 		VkPhysicalDeviceFeatures supported_features;
 		vkGetPhysicalDeviceFeatures(device, &supported_features);
-		return indices.isComplete() && extension_supported && swap_chain_adequate && supported_features.samplerAnisotropy != 0;
+		return indices.isComplete() && extension_supported && swap_chain_adequate && supported_features.samplerAnisotropy != 0
+			&& queryBindlessSupport(device).supported;
 	}
 
 	void EngineDevice::populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& create_info) {
@@ -243,10 +435,13 @@ namespace engine {
 	}
 
 	std::vector<const char*> EngineDevice::getRequiredExtensions() {
-		uint32_t glfw_extension_count = 0;
-		const char** glfw_extensions = {};
-		glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
-		std::vector<const char*> extensions(glfw_extensions, glfw_extensions + glfw_extension_count);
+		// GLFW is never initialized when headless and has no surface extensions to ask for
+		std::vector<const char*> extensions {};
+		if (!headless()) {
+			uint32_t glfw_extension_count = 0;
+			const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+			extensions.assign(glfw_extensions, glfw_extensions + glfw_extension_count);
+		}
 		if (this->enabledValidationLayers) {
 			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 			extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
@@ -283,7 +478,8 @@ namespace engine {
 		vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
 		std::vector<VkExtensionProperties> available_extensions(extension_count);
 		vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions.data());
-		std::set<std::string> required_extenstions(deviceExtensions_.begin(), deviceExtensions_.end());
+		const auto required = requiredDeviceExtensions(device);
+		std::set<std::string> required_extenstions(required.begin(), required.end());
 		for (const auto& extension : available_extensions) {
 			required_extenstions.erase(extension.extensionName);
 		}
@@ -291,6 +487,24 @@ namespace engine {
 		return res;
 	}
 
+	// Headless rendering needs no device extension. Portability subset still has to be enabled on
+	// the implementations that expose it, but lavapipe and other conformant drivers do not.
+	std::vector<const char*> EngineDevice::requiredDeviceExtensions(VkPhysicalDevice device) {
+		if (!headless()) {
+			return deviceExtensions_;
+		}
+		uint32_t extension_count = {};
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
+		std::vector<VkExtensionProperties> available_extensions(extension_count);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions.data());
+		for (const auto& extension : available_extensions) {
+			if (strcmp(extension.extensionName, VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME) == 0) {
+				return { VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME };
+			}
+		}
+		return {};
+	}
+
 	QueueFamilyIndices EngineDevice::findQueueFamilies(VkPhysicalDevice device) {
 		QueueFamilyIndices indices;
 		uint32_t queue_family_count = {};
@@ -304,7 +518,11 @@ namespace engine {
 				indices.graphicsFamilyHasValue = true;
 			}
 			VkBool32 present_support = 0;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &present_support);
+			if (headless()) {
+				present_support = indices.graphicsFamilyHasValue && indices.graphicsFamily == static_cast<uint32_t>(i) ? VK_TRUE : VK_FALSE;
+			} else {
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &present_support);
+			}
 			if (queue_family.queueCount > 0 && present_support != 0) {
 				indices.presentFamily = i;
 				indices.presentFamilyHasValue = true;
@@ -403,6 +621,7 @@ namespace engine {
 	}
 
 	void EngineDevice::copyBuffer(VkBuffer src_buf, VkBuffer dst_buf, VkDeviceSize size) {
+		ENGINE_ZONE("EngineDevice::copyBuffer");
 		VkCommandBuffer command_buf = this->beginSingleTimeCommands();
 		VkBufferCopy copy_region {};
 		copy_region.srcOffset = 0;
@@ -410,9 +629,11 @@ namespace engine {
 		copy_region.size = size;
 		vkCmdCopyBuffer(command_buf, src_buf, dst_buf, 1, &copy_region);
 		endSingleTimeCommands(command_buf);
+		counters_.countBufferCopy(size);
 	}
 
 	void EngineDevice::copyBufferToImage(VkBuffer buf, VkImage image, uint32_t width, uint32_t height, uint32_t layer_count) {
+		ENGINE_ZONE("EngineDevice::copyBufferToImage");
 		VkCommandBuffer command_buf = beginSingleTimeCommands();
 		VkBufferImageCopy region {};
 		region.bufferOffset = 0;
@@ -429,7 +650,7 @@ namespace engine {
 		endSingleTimeCommands(command_buf);
 	}
 
-	void EngineDevice::createImageWithInfo(const VkImageCreateInfo &image_info, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &image_memory) {
+	void EngineDevice::createImageWithInfo(const VkImageCreateInfo &image_info, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &image_memory, VkMemoryPropertyFlags preferred_properties) {
 		if (vkCreateImage(device_, &image_info, nullptr, &image) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create image");
 		}
@@ -438,6 +659,9 @@ namespace engine {
 		VkMemoryAllocateInfo alloc_info {};
 		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 		alloc_info.allocationSize = memory_reqs.size;
+		if (preferred_properties != 0 && hasMemoryType(memory_reqs.memoryTypeBits, properties | preferred_properties)) {
+			properties |= preferred_properties;
+		}
 		alloc_info.memoryTypeIndex = findMemoryType(memory_reqs.memoryTypeBits, properties);
 		if (vkAllocateMemory(device_, &alloc_info, nullptr, &image_memory) != VK_SUCCESS) {
 			throw std::runtime_error("failed to allocate image memory");
@@ -458,6 +682,17 @@ namespace engine {
 		throw std::runtime_error("failed to find suitable memory type");
 	}
 
+	bool EngineDevice::hasMemoryType(uint32_t type_filter, VkMemoryPropertyFlags properties) {
+		VkPhysicalDeviceMemoryProperties mem_properties;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &mem_properties);
+		for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
+			if ((type_filter & (1 << i)) && (mem_properties.memoryTypes[i].propertyFlags & properties) == properties) {
+				return true;
+			}
+		}
+		return false;
+	}
+
 	void EngineDevice::setupDebugMessenger() {
 		if (!enabledValidationLayers) {
 			return;
@@ -473,6 +708,41 @@ namespace engine {
 		return this->findQueueFamilies(physicalDevice_);
 	}
 
+	uint32_t EngineDevice::graphicsTimestampValidBits() {
+		uint32_t queue_family_count = {};
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &queue_family_count, nullptr);
+		std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &queue_family_count, queue_families.data());
+		return queue_families[findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+	}
+
+	void EngineDevice::collectTelemetry(MetricsWriter& metrics) {
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget {};
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+		VkPhysicalDeviceMemoryProperties2 properties2 {};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		properties2.pNext = memoryBudgetSupported_ ? &budget : nullptr;
+		vkGetPhysicalDeviceMemoryProperties2(physicalDevice_, &properties2);
+
+		const auto& heaps = properties2.memoryProperties;
+		for (uint32_t i = 0; i < heaps.memoryHeapCount; i++) {
+			metrics.gauge("engine_memory_heap_size_bytes", "Size of the memory heap", static_cast<double>(heaps.memoryHeaps[i].size), { "heap", i });
+		}
+		for (uint32_t i = 0; i < heaps.memoryHeapCount; i++) {
+			const bool device_local = (heaps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+			metrics.gauge("engine_memory_heap_device_local", "1 for heaps local to the device", device_local ? 1.0 : 0.0, { "heap", i });
+		}
+		if (!memoryBudgetSupported_) {
+			return;
+		}
+		for (uint32_t i = 0; i < heaps.memoryHeapCount; i++) {
+			metrics.gauge("engine_memory_heap_usage_bytes", "Memory of the heap used by this process", static_cast<double>(budget.heapUsage[i]), { "heap", i });
+		}
+		for (uint32_t i = 0; i < heaps.memoryHeapCount; i++) {
+			metrics.gauge("engine_memory_heap_budget_bytes", "Memory of the heap this process can use before allocations may fail or degrade", static_cast<double>(budget.heapBudget[i]), { "heap", i });
+		}
+	}
+
 	SwapChainSupportDetails EngineDevice::swapChainSupport() {
 		return querySwapChainSupport(physicalDevice_);
 	}
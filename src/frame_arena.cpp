@@ -0,0 +1,38 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace engine {
+
+	FrameArena::FrameArena(size_t capacity) : block_ { std::make_unique<std::byte[]>(capacity) }, capacity_ { capacity } { // NOLINT
+		overflow_.reserve(1);
+	}
+
+	void FrameArena::reset() {
+		peak_ = std::max(peak_, used());
+		if (!overflow_.empty()) {
+			// headroom for alignment padding and a slightly heavier frame
+			capacity_ = std::max(capacity_, peak_) * 2;
+			block_ = std::make_unique<std::byte[]>(capacity_); // NOLINT
+			overflow_.clear();
+			overflowBytes_ = 0;
+		}
+		offset_ = 0;
+	}
+
+	void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+		const auto base = reinterpret_cast<uintptr_t>(block_.get()); // NOLINT
+		const size_t aligned = ((base + offset_ + alignment - 1) & ~(alignment - 1)) - base;
+		if (aligned + bytes <= capacity_) {
+			offset_ = aligned + bytes;
+			return block_.get() + aligned; // NOLINT
+		}
+		// new[] of bytes is aligned to __STDCPP_DEFAULT_NEW_ALIGNMENT__, pad for anything stricter
+		auto& chunk = overflow_.emplace_back(std::make_unique<std::byte[]>(bytes + alignment)); // NOLINT
+		overflowBytes_ += bytes;
+		const auto chunk_base = reinterpret_cast<uintptr_t>(chunk.get()); // NOLINT
+		return chunk.get() + (((chunk_base + alignment - 1) & ~(alignment - 1)) - chunk_base); // NOLINT
+	}
+
+}
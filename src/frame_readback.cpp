@@ -0,0 +1,174 @@
+#include "frame_readback.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "swap_chain.hpp"
+#include "cpu_profiler.hpp"
+
+namespace engine {
+
+	namespace {
+
+		const uint32_t BYTES_PER_PIXEL = 4;
+
+	}
+
+	FrameReadback::FrameReadback(EngineDevice& device, VkExtent2D extent, std::string directory)
+		: device_ { device }, extent_ { extent }, directory_ { std::move(directory) } {
+		std::error_code error {};
+		std::filesystem::create_directories(directory_, error);
+		if (error) {
+			throw std::runtime_error("failed to create frame capture directory " + directory_);
+		}
+		slots_.resize(SwapChain::MAX_FRAMES);
+		for (auto& slot : slots_) {
+			slot.buffer = std::make_unique<Buffer>(
+				device_,
+				static_cast<VkDeviceSize>(extent_.width) * extent_.height * BYTES_PER_PIXEL,
+				1,
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			slot.buffer->map();
+		}
+		for (auto& frame : queue_) {
+			frame.pixels.resize(static_cast<size_t>(extent_.width) * extent_.height * BYTES_PER_PIXEL);
+		}
+		writer_ = std::thread([this] { writerLoop(); });
+	}
+
+	FrameReadback::~FrameReadback() {
+		{
+			const std::lock_guard<std::mutex> lock { mutex_ };
+			stopping_ = true;
+		}
+		queueChanged_.notify_all();
+		writer_.join();
+	}
+
+	void FrameReadback::record(VkCommandBuffer command_buf, int frame_idx, VkImage image, uint64_t frame_number) {
+		ENGINE_ZONE("FrameReadback::record");
+		auto& slot = slots_[frame_idx];
+
+		// the render pass already left the image in TRANSFER_SRC, this only orders the color writes
+		VkImageMemoryBarrier to_transfer {};
+		to_transfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		to_transfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		to_transfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		to_transfer.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		to_transfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		to_transfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		to_transfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		to_transfer.image = image;
+		to_transfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdPipelineBarrier(command_buf, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			0, nullptr, 0, nullptr, 1, &to_transfer);
+
+		VkBufferImageCopy region {};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = { extent_.width, extent_.height, 1 };
+		vkCmdCopyImageToBuffer(command_buf, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer->buffer(), 1, &region);
+
+		VkBufferMemoryBarrier to_host {};
+		to_host.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		to_host.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		to_host.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		to_host.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		to_host.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		to_host.buffer = slot.buffer->buffer();
+		to_host.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(command_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+			0, nullptr, 1, &to_host, 0, nullptr);
+
+		slot.pending = true;
+		slot.frameNumber = frame_number;
+	}
+
+	void FrameReadback::collect(int frame_idx) {
+		ENGINE_ZONE("FrameReadback::collect");
+		auto& slot = slots_[frame_idx];
+		if (!slot.pending) {
+			return;
+		}
+		slot.pending = false;
+		slot.buffer->invalidate();
+
+		size_t tail = 0;
+		{
+			// a slow disk holds the frame loop back instead of growing the queue without bound
+			ENGINE_ZONE("wait frame writer");
+			std::unique_lock<std::mutex> lock { mutex_ };
+			queueChanged_.wait(lock, [this] { return queueSize_ < MAX_QUEUED_FRAMES; });
+			tail = (queueHead_ + queueSize_) % MAX_QUEUED_FRAMES;
+		}
+		// the writer does not touch entries past the tail, so the copy needs no lock
+		auto& frame = queue_[tail];
+		frame.number = slot.frameNumber;
+		std::memcpy(frame.pixels.data(), slot.buffer->mappedMemory(), frame.pixels.size());
+		{
+			const std::lock_guard<std::mutex> lock { mutex_ };
+			queueSize_++;
+		}
+		queueChanged_.notify_all();
+	}
+
+	void FrameReadback::collectAll() {
+		for (int i = 0; i < static_cast<int>(slots_.size()); i++) {
+			collect(i);
+		}
+	}
+
+	void FrameReadback::writerLoop() {
+		ENGINE_THREAD_NAME("frame writer");
+		while (true) {
+			size_t head = 0;
+			{
+				std::unique_lock<std::mutex> lock { mutex_ };
+				queueChanged_.wait(lock, [this] { return stopping_ || queueSize_ > 0; });
+				// frames already collected are still written on shutdown
+				if (queueSize_ == 0) {
+					return;
+				}
+				head = queueHead_;
+			}
+
+			writeFrame(queue_[head]);
+
+			{
+				const std::lock_guard<std::mutex> lock { mutex_ };
+				queueHead_ = (queueHead_ + 1) % MAX_QUEUED_FRAMES;
+				queueSize_--;
+				framesWritten_++;
+			}
+			queueChanged_.notify_all();
+		}
+	}
+
+	void FrameReadback::writeFrame(const Frame& frame) const {
+		ENGINE_ZONE("FrameReadback::writeFrame");
+		std::ostringstream name {};
+		name << "frame_" << std::setw(6) << std::setfill('0') << frame.number << ".ppm"; // NOLINT
+		std::ofstream file(std::filesystem::path(directory_) / name.str(), std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			return;
+		}
+		file << "P6\n" << extent_.width << " " << extent_.height << "\n255\n";
+		// PPM has no alpha channel
+		std::vector<char> row(static_cast<size_t>(extent_.width) * 3);
+		for (uint32_t y = 0; y < extent_.height; y++) {
+			const uint8_t* src = frame.pixels.data() + static_cast<size_t>(y) * extent_.width * BYTES_PER_PIXEL; // NOLINT
+			for (uint32_t x = 0; x < extent_.width; x++) {
+				row[x * 3 + 0] = static_cast<char>(src[x * BYTES_PER_PIXEL + 0]); // NOLINT
+				row[x * 3 + 1] = static_cast<char>(src[x * BYTES_PER_PIXEL + 1]); // NOLINT
+				row[x * 3 + 2] = static_cast<char>(src[x * BYTES_PER_PIXEL + 2]); // NOLINT
+			}
+			file.write(row.data(), static_cast<std::streamsize>(row.size()));
+		}
+	}
+
+}
@@ -0,0 +1,136 @@
+#include "frame_time_stats.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace engine {
+
+	namespace {
+
+		// NOLINTBEGIN
+		std::array<double, FRAME_STAGE_COUNT> stageTimes(const FrameStats& stats) {
+			return { stats.frameMs, stats.acquireMs, stats.updateMs, stats.shadowMs, stats.recordMs, stats.submitMs };
+		}
+		// NOLINTEND
+
+		const size_t LINE_SIZE = 256;
+
+	}
+
+	const char* frameStageName(FrameStage stage) {
+		switch (stage) {
+			case FrameStage::Frame: return "frame";
+			case FrameStage::Acquire: return "acquire";
+			case FrameStage::Update: return "update";
+			case FrameStage::Shadow: return "shadow";
+			case FrameStage::Record: return "record";
+			case FrameStage::Submit: return "submit";
+		}
+		return "unknown";
+	}
+
+	const char* hitchCauseName(HitchCause cause) {
+		switch (cause) {
+			case HitchCause::SwapChainRecreation: return "swap_chain_recreation";
+			case HitchCause::ModelUpload: return "model_upload";
+			case HitchCause::FenceWait: return "fence_wait";
+			case HitchCause::Unattributed: return "unattributed";
+		}
+		return "unknown";
+	}
+
+	FrameTimeStats::FrameTimeStats(double interval_ms) : intervalMs_ { interval_ms } {
+		recentHitches_.reserve(MAX_HITCHES);
+	}
+
+	std::optional<Hitch> FrameTimeStats::record(const FrameStats& stats) {
+		if (intervalComplete_) {
+			for (auto& histogram : interval_) {
+				histogram.reset();
+			}
+			intervalElapsedMs_ = 0.0;
+			intervalHitches_ = 0;
+			intervalComplete_ = false;
+		}
+		const auto times = stageTimes(stats);
+		for (size_t stage = 0; stage < FRAME_STAGE_COUNT; stage++) {
+			interval_[stage].record(times[stage]);
+			total_[stage].record(times[stage]);
+		}
+		intervalElapsedMs_ += stats.frameMs;
+		intervalComplete_ = intervalElapsedMs_ >= intervalMs_;
+
+		std::optional<Hitch> hitch {};
+		const double expected = averageMs_[0];
+		if (averaged_ && stats.frameMs > HITCH_FACTOR * expected && stats.frameMs - expected > HITCH_MIN_MS) {
+			Hitch found {};
+			found.frame = stats.frame;
+			found.frameMs = stats.frameMs;
+			found.expectedMs = expected;
+			size_t worst = 1;
+			for (size_t stage = 2; stage < FRAME_STAGE_COUNT; stage++) {
+				if (times[stage] - averageMs_[stage] > times[worst] - averageMs_[worst]) {
+					worst = stage;
+				}
+			}
+			found.stage = static_cast<FrameStage>(worst);
+			if (stats.counters.swapChainRecreations > 0) {
+				found.cause = HitchCause::SwapChainRecreation;
+			} else if (stats.counters.modelUploads > 0) {
+				found.cause = HitchCause::ModelUpload;
+			} else if (stats.fenceWaitMs >= 0.5 * (stats.frameMs - expected)) { // NOLINT
+				found.cause = HitchCause::FenceWait;
+			}
+			hitchCount_++;
+			intervalHitches_++;
+			hitchCauses_[static_cast<size_t>(found.cause)]++;
+			if (recentHitches_.size() == MAX_HITCHES) {
+				recentHitches_.erase(recentHitches_.begin());
+			}
+			recentHitches_.push_back(found);
+			hitch = found;
+		}
+
+		// hitches move the averages too, so a lasting slowdown stops counting as hitches
+		for (size_t stage = 0; stage < FRAME_STAGE_COUNT; stage++) {
+			averageMs_[stage] = averaged_ ? averageMs_[stage] + AVERAGE_FACTOR * (times[stage] - averageMs_[stage]) : times[stage];
+		}
+		averaged_ = true;
+		return hitch;
+	}
+
+	void FrameTimeStats::resetTotals() {
+		for (auto& histogram : total_) {
+			histogram.reset();
+		}
+		hitchCount_ = 0;
+		hitchCauses_.fill(0);
+		recentHitches_.clear();
+	}
+
+	void FrameTimeStats::collectTelemetry(MetricsWriter& metrics) const {
+		for (const auto cause : { HitchCause::SwapChainRecreation, HitchCause::ModelUpload, HitchCause::FenceWait, HitchCause::Unattributed }) {
+			metrics.counter("engine_hitches_total", "Frames that took far longer than the running average", static_cast<double>(hitchCount(cause)), { "cause", hitchCauseName(cause) });
+		}
+	}
+
+	void FrameTimeStats::writeSummary(std::ostream& out) const {
+		const auto& frame = interval(FrameStage::Frame);
+		std::array<char, LINE_SIZE> line {};
+		std::snprintf(line.data(), line.size(),
+			"frame ms over %llu frames: p50 %.2f p95 %.2f p99 %.2f max %.2f | p99 acquire %.2f update %.2f shadow %.2f record %.2f submit %.2f | hitches %llu",
+			static_cast<unsigned long long>(frame.count()), frame.percentileMs(0.5), frame.percentileMs(0.95), frame.percentileMs(0.99), frame.maxMs(), // NOLINT
+			interval(FrameStage::Acquire).percentileMs(0.99), interval(FrameStage::Update).percentileMs(0.99), // NOLINT
+			interval(FrameStage::Shadow).percentileMs(0.99), interval(FrameStage::Record).percentileMs(0.99), // NOLINT
+			interval(FrameStage::Submit).percentileMs(0.99), static_cast<unsigned long long>(intervalHitches_)); // NOLINT
+		out << line.data() << "\n";
+	}
+
+	void FrameTimeStats::writeHitch(std::ostream& out, const Hitch& hitch) {
+		std::array<char, LINE_SIZE> line {};
+		std::snprintf(line.data(), line.size(), "hitch at frame %u: %.2f ms, expected %.2f ms, cause %s, slowest stage %s",
+			hitch.frame, hitch.frameMs, hitch.expectedMs, hitchCauseName(hitch.cause), frameStageName(hitch.stage));
+		out << line.data() << "\n";
+	}
+
+}
@@ -0,0 +1,111 @@
+#include "geometry.hpp"
+
+#include <algorithm>
+
+namespace engine {
+
+	float Aabb::surfaceArea() const {
+		const glm::vec3 size = max - min;
+		return 2.0F * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	void Aabb::expand(const glm::vec3& point) {
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	Aabb Aabb::merged(const Aabb& other) const {
+		return { glm::min(min, other.min), glm::max(max, other.max) };
+	}
+
+	Aabb Aabb::inflated(float margin) const {
+		return { min - glm::vec3(margin), max + glm::vec3(margin) };
+	}
+
+	// Arvo's method: the world extent along each axis is the sum of the absolute rotated local extents
+	Aabb Aabb::transformed(const glm::mat4& matrix) const {
+		const glm::vec3 local_center = center();
+		const glm::vec3 local_extent = extent();
+		const glm::vec3 world_center = glm::vec3(matrix * glm::vec4(local_center, 1.0F));
+		glm::vec3 world_extent {};
+		for (int col = 0; col < 3; col++) {
+			world_extent += glm::abs(glm::vec3(matrix[col])) * local_extent[col];
+		}
+		return fromCenter(world_center, world_extent);
+	}
+
+	bool Aabb::contains(const Aabb& other) const {
+		return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+	}
+
+	bool Aabb::intersects(const Aabb& other) const {
+		return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+	}
+
+	bool Sphere::intersects(const Aabb& box) const {
+		const glm::vec3 closest = glm::clamp(center, box.min, box.max);
+		const glm::vec3 offset = closest - center;
+		return glm::dot(offset, offset) <= radius * radius;
+	}
+
+	bool Ray::intersects(const Aabb& box, float max_t, float& t) const {
+		float t_min = 0.0F;
+		float t_max = max_t;
+		for (int axis = 0; axis < 3; axis++) {
+			const float inv_dir = 1.0F / direction[axis];
+			float t0 = (box.min[axis] - origin[axis]) * inv_dir;
+			float t1 = (box.max[axis] - origin[axis]) * inv_dir;
+			if (inv_dir < 0.0F) {
+				std::swap(t0, t1);
+			}
+			t_min = std::max(t_min, t0);
+			t_max = std::min(t_max, t1);
+			if (t_max < t_min) {
+				return false;
+			}
+		}
+		t = t_min;
+		return true;
+	}
+
+	// NOLINTBEGIN
+	Frustum Frustum::fromMatrix(const glm::mat4& view_projection) {
+		const glm::mat4 m = glm::transpose(view_projection);
+		Frustum frustum {};
+		frustum.planes[0] = m[3] + m[0]; // left
+		frustum.planes[1] = m[3] - m[0]; // right
+		frustum.planes[2] = m[3] + m[1]; // bottom
+		frustum.planes[3] = m[3] - m[1]; // top
+		frustum.planes[4] = m[2];        // near
+		frustum.planes[5] = m[3] - m[2]; // far
+		for (auto& plane : frustum.planes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return frustum;
+	}
+	// NOLINTEND
+
+	// conservative: boxes outside the frustum near its corners are reported as visible
+	bool Frustum::intersects(const Aabb& box) const {
+		const glm::vec3 center = box.center();
+		const glm::vec3 extent = box.extent();
+		for (const auto& plane : planes) {
+			const glm::vec3 normal { plane };
+			const float radius = glm::dot(extent, glm::abs(normal));
+			if (glm::dot(normal, center) + plane.w < -radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Frustum::intersects(const Sphere& sphere) const {
+		for (const auto& plane : planes) {
+			if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+}
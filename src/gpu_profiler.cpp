@@ -0,0 +1,132 @@
+#include "gpu_profiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "swap_chain.hpp"
+#include "cpu_profiler.hpp"
+
+namespace engine {
+
+	namespace {
+
+		const double NS_PER_MS = 1.0e6;
+		const double SMOOTHING = 0.1;
+		const uint32_t TIMESTAMP_BITS = 64;
+
+	}
+
+	GpuProfiler::GpuProfiler(EngineDevice& device) : device_ { device } {
+		const uint32_t valid_bits = device_.graphicsTimestampValidBits();
+		const float period = device_.properties.limits.timestampPeriod;
+		if (valid_bits == 0 || period <= 0.0F) {
+			return;
+		}
+		VkQueryPoolCreateInfo pool_info {};
+		pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		pool_info.queryCount = 2 * MAX_SCOPES_PER_FRAME * SwapChain::MAX_FRAMES;
+		if (vkCreateQueryPool(device_.device(), &pool_info, nullptr, &queryPool_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create profiler query pool");
+		}
+		nsPerTick_ = static_cast<double>(period);
+		timestampMask_ = valid_bits >= TIMESTAMP_BITS ? ~0ULL : (1ULL << valid_bits) - 1;
+		recorded_.resize(SwapChain::MAX_FRAMES);
+		for (auto& recorded : recorded_) {
+			recorded.reserve(MAX_SCOPES_PER_FRAME);
+		}
+		timestamps_.resize(2 * MAX_SCOPES_PER_FRAME);
+	}
+
+	GpuProfiler::~GpuProfiler() {
+		vkDestroyQueryPool(device_.device(), queryPool_, nullptr);
+	}
+
+	void GpuProfiler::beginFrame(VkCommandBuffer command_buf, int frame_idx) {
+		ENGINE_ZONE("GpuProfiler::beginFrame");
+		if (!enabled()) {
+			return;
+		}
+		frameIdx_ = frame_idx;
+		auto& recorded = recorded_[frame_idx];
+		if (!recorded.empty()) {
+			const auto query_count = static_cast<uint32_t>(2 * recorded.size());
+			const VkResult result = vkGetQueryPoolResults(device_.device(), queryPool_, firstQuery(frame_idx), query_count,
+				query_count * sizeof(uint64_t), timestamps_.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+			if (result == VK_SUCCESS) {
+				// negative marks scopes that did not run in this frame
+				std::fill(frameMs_.begin(), frameMs_.end(), -1.0);
+				for (const auto& entry : recorded) {
+					const uint32_t local = entry.query - firstQuery(frame_idx);
+					const uint64_t ticks = (timestamps_[local + 1] - timestamps_[local]) & timestampMask_;
+					frameMs_[entry.scope] = std::max(frameMs_[entry.scope], 0.0) + static_cast<double>(ticks) * nsPerTick_ / NS_PER_MS;
+				}
+				for (size_t i = 0; i < scopes_.size(); i++) {
+					if (frameMs_[i] < 0.0) {
+						continue;
+					}
+					auto& scope = scopes_[i];
+					scope.lastMs = frameMs_[i];
+					scope.smoothedMs = scope.samples == 0 ? frameMs_[i] : scope.smoothedMs + (frameMs_[i] - scope.smoothedMs) * SMOOTHING;
+					scope.totalMs += frameMs_[i];
+					scope.samples++;
+				}
+			}
+			recorded.clear();
+		}
+		vkCmdResetQueryPool(command_buf, queryPool_, firstQuery(frame_idx), 2 * MAX_SCOPES_PER_FRAME);
+	}
+
+	uint32_t GpuProfiler::begin(VkCommandBuffer command_buf, const char* name) {
+		if (!enabled()) {
+			return INVALID_SCOPE;
+		}
+		auto& recorded = recorded_[frameIdx_];
+		if (recorded.size() == MAX_SCOPES_PER_FRAME) {
+			return INVALID_SCOPE;
+		}
+		const uint32_t query = firstQuery(frameIdx_) + static_cast<uint32_t>(2 * recorded.size());
+		recorded.push_back({ scopeIndex(name), query });
+		vkCmdWriteTimestamp(command_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool_, query);
+		return static_cast<uint32_t>(recorded.size() - 1);
+	}
+
+	void GpuProfiler::end(VkCommandBuffer command_buf, uint32_t scope) {
+		if (scope == INVALID_SCOPE) {
+			return;
+		}
+		vkCmdWriteTimestamp(command_buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool_, recorded_[frameIdx_][scope].query + 1);
+	}
+
+	const GpuProfiler::Scope* GpuProfiler::find(const std::string& name) const {
+		const auto it = std::find_if(scopes_.begin(), scopes_.end(), [&](const Scope& scope) { return scope.name == name; });
+		return it == scopes_.end() ? nullptr : &*it;
+	}
+
+	void GpuProfiler::resetTotals() {
+		for (auto& scope : scopes_) {
+			scope.totalMs = 0.0;
+			scope.samples = 0;
+		}
+	}
+
+	void GpuProfiler::writeCsv(std::ostream& out) const {
+		out << "scope,last_ms,smoothed_ms,mean_ms,samples\n";
+		for (const auto& scope : scopes_) {
+			out << scope.name << "," << scope.lastMs << "," << scope.smoothedMs << "," << scope.meanMs() << "," << scope.samples << "\n";
+		}
+	}
+
+	// scopes are few, a linear search is cheaper than hashing the name
+	uint32_t GpuProfiler::scopeIndex(const char* name) {
+		for (uint32_t i = 0; i < scopes_.size(); i++) {
+			if (scopes_[i].name == name) {
+				return i;
+			}
+		}
+		scopes_.push_back({ name });
+		frameMs_.resize(scopes_.size());
+		return static_cast<uint32_t>(scopes_.size() - 1);
+	}
+
+}
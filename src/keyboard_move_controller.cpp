@@ -2,7 +2,7 @@
 
 namespace engine {
 
-	void KeyboardMoveController::moveInPlayeXZ(GLFWwindow* window, float dt, SceneObject& scene_object) {
+	void KeyboardMoveController::moveInPlayeXZ(GLFWwindow* window, float dt, TransformComponent& transform) {
 		glm::vec3 rotate {0};
 		if (glfwGetKey(window, keys.lookRight) == GLFW_PRESS) {
 			rotate.y += 1.0f;
@@ -17,13 +17,15 @@ namespace engine {
 			rotate.x -= 1.0f;
 		}
 
+		glm::vec3 rotation = transform.rotation();
 		if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon()) {
-			scene_object.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
+			rotation += lookSpeed * dt * glm::normalize(rotate);
 		}
 
-		scene_object.transform.rotation.x = glm::clamp(scene_object.transform.rotation.x, -1.5f, 1.5f);
-		scene_object.transform.rotation.y = glm::mod(scene_object.transform.rotation.y, glm::two_pi<float>());
-		float yaw = scene_object.transform.rotation.y;
+		rotation.x = glm::clamp(rotation.x, -1.5f, 1.5f);
+		rotation.y = glm::mod(rotation.y, glm::two_pi<float>());
+		transform.setRotation(rotation);
+		float yaw = rotation.y;
 		const glm::vec3 forward_dir { sin(yaw), 0.0f, cos(yaw) };
 		const glm::vec3 right_dir { forward_dir.z, 0.0f, -forward_dir.x};
 		const glm::vec3 up_dir { 0.0f, -1.0f, 0.0f };
@@ -48,7 +50,7 @@ namespace engine {
 		}
 
 		if (glm::dot(move_dir, move_dir) > std::numeric_limits<float>::epsilon()) {
-			scene_object.transform.translation += moveSpeed * dt * glm::normalize(move_dir);
+			transform.setTranslation(transform.translation() + moveSpeed * dt * glm::normalize(move_dir));
 		}
 	}
 
@@ -0,0 +1,59 @@
+#include "latency_histogram.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace engine {
+
+	void LatencyHistogram::record(double ms) {
+		const uint64_t us = std::min(static_cast<uint64_t>(std::llround(std::max(ms, 0.0) * 1000.0)), (uint64_t { 1 } << MAX_EXPONENT) - 1); // NOLINT
+		counts_[bucketOf(us)]++;
+		count_++;
+		maxUs_ = std::max(maxUs_, us);
+		sumMs_ += ms;
+	}
+
+	void LatencyHistogram::reset() {
+		counts_.fill(0);
+		count_ = 0;
+		maxUs_ = 0;
+		sumMs_ = 0.0;
+	}
+
+	double LatencyHistogram::percentileMs(double fraction) const {
+		if (count_ == 0) {
+			return 0.0;
+		}
+		const auto rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count_))), 1);
+		uint64_t seen = 0;
+		for (size_t bucket = 0; bucket < BUCKETS; bucket++) {
+			seen += counts_[bucket];
+			if (seen >= rank) {
+				return static_cast<double>(std::min(highestOf(bucket), maxUs_)) / 1000.0; // NOLINT
+			}
+		}
+		return maxMs();
+	}
+
+	size_t LatencyHistogram::bucketOf(uint64_t us) {
+		if (us < SUB_BUCKETS) {
+			return static_cast<size_t>(us);
+		}
+		// us lies in [2^exponent, 2^(exponent + 1)), its top SUB_BUCKET_BITS - 1 bits below the leading one pick the bucket
+		const auto exponent = static_cast<uint32_t>(std::bit_width(us)) - 1;
+		const uint32_t shift = exponent - (SUB_BUCKET_BITS - 1);
+		return SUB_BUCKETS + (exponent - SUB_BUCKET_BITS) * HALF_BUCKETS + static_cast<size_t>(us >> shift) - HALF_BUCKETS;
+	}
+
+	uint64_t LatencyHistogram::highestOf(size_t bucket) {
+		if (bucket < SUB_BUCKETS) {
+			return bucket;
+		}
+		const size_t offset = bucket - SUB_BUCKETS;
+		const auto shift = static_cast<uint32_t>(offset / HALF_BUCKETS) + 1;
+		const uint64_t mantissa = HALF_BUCKETS + offset % HALF_BUCKETS;
+		return ((mantissa + 1) << shift) - 1;
+	}
+
+}
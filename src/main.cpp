@@ -1,13 +1,54 @@
+#include <cctype>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
+#include <string>
 
 #include "app.hpp"
 #include "window.hpp"
 
-int main() {
-	auto app = engine::App {};
+// usage: 3d_engine [--deferred] [--headless [frames]] [--capture <dir>] [--trace <path>]
+//                  [--telemetry-socket <path>] [--telemetry-file <path>] [--telemetry-json]
+int main(int argc, char** argv) {
+	bool deferred = false;
+	bool headless = false;
+	engine::HeadlessOptions headless_options {};
+	headless_options.logFrameTimes = true;
+	std::string trace_path {};
+	engine::TelemetryOptions telemetry {};
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i]; // NOLINT
+		if (arg == "--deferred") {
+			deferred = true;
+		} else if (arg == "--headless") {
+			headless = true;
+			if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])) != 0) { // NOLINT
+				headless_options.frames = static_cast<uint32_t>(std::stoul(argv[++i])); // NOLINT
+			}
+		} else if (arg == "--capture" && i + 1 < argc) {
+			headless = true;
+			headless_options.captureDirectory = argv[++i]; // NOLINT
+		} else if (arg == "--trace" && i + 1 < argc) {
+			trace_path = argv[++i]; // NOLINT
+		} else if (arg == "--telemetry-socket" && i + 1 < argc) {
+			telemetry.socketPath = argv[++i]; // NOLINT
+		} else if (arg == "--telemetry-file" && i + 1 < argc) {
+			telemetry.filePath = argv[++i]; // NOLINT
+		} else if (arg == "--telemetry-json") {
+			telemetry.format = engine::TelemetryFormat::Json;
+		}
+	}
+
 	try {
-		app.run();
+		auto app = headless ? std::make_unique<engine::App>(headless_options) : std::make_unique<engine::App>();
+		if (deferred) {
+			app->setRenderPath(engine::RenderPath::Deferred);
+		}
+		app->setTracePath(trace_path);
+		if (!telemetry.socketPath.empty() || !telemetry.filePath.empty()) {
+			app->enableTelemetry(telemetry);
+		}
+		app->run();
 	} catch (const std::exception &e) {
 		std::cerr << e.what() << "\n";
 		return -1;
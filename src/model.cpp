@@ -1,5 +1,6 @@
 #include "model.hpp"
 #include "utils.hpp"
+#include "cpu_profiler.hpp"
 
 #define TINYOBJLEADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
@@ -7,7 +8,10 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <unordered_map>
 
@@ -24,14 +28,31 @@ namespace std {
 
 namespace engine {
 
-	Model::Model(EngineDevice& device, const Builder& builder) : device_ { device }, vertexCount_ { 0 }, indexCount_ { 0 } {
+	namespace {
+
+		std::atomic<uint64_t> files_loaded { 0 };
+		std::atomic<uint64_t> load_us { 0 };
+		std::atomic<uint64_t> loads_in_progress { 0 };
+		std::atomic<uint64_t> models_uploaded { 0 };
+		std::atomic<uint64_t> uploaded_bytes { 0 };
+
+	}
+
+	Model::Model(EngineDevice& device, const Builder& builder) : device_ { device }, vertexCount_ { 0 }, indexCount_ { 0 }, path_ { builder.path } {
 		createVertexBuffers(builder.vertices);
 		createIndexBuffers(builder.indices);
+		device_.counters().countModelUpload();
+		models_uploaded.fetch_add(1, std::memory_order_relaxed);
+		uploaded_bytes.fetch_add(sizeof(Vertex) * builder.vertices.size() + sizeof(uint32_t) * builder.indices.size(), std::memory_order_relaxed);
+		for (const auto& vertex : builder.vertices) {
+			bounds_.expand(vertex.position);
+		}
 	}
 
 	Model::~Model() = default;
 
 	void Model::createVertexBuffers(const std::vector<Vertex>& vertices) {
+		ENGINE_ZONE("Model::createVertexBuffers");
 		vertexCount_ = static_cast<uint32_t>(vertices.size());
 		assert(vertexCount_ >= 3);
 		const VkDeviceSize buf_size = sizeof(vertices[0]) * vertexCount_;
@@ -61,6 +82,7 @@ namespace engine {
 	}
 
 	void Model::createIndexBuffers(const std::vector<uint32_t>& indices) {
+		ENGINE_ZONE("Model::createIndexBuffers");
 		indexCount_ = static_cast<uint32_t>(indices.size());
 		hasIndexBuffer_ = indexCount_ > 0;
 		if (!hasIndexBuffer_) {
@@ -92,8 +114,8 @@ namespace engine {
 }
 
 	void Model::bind(VkCommandBuffer command_buf) {
-		std::vector<VkBuffer> buffers { vertexBuffer_->buffer() };
-		std::vector<VkDeviceSize> offsets { 0 };
+		const std::array<VkBuffer, 1> buffers { vertexBuffer_->buffer() };
+		const std::array<VkDeviceSize, 1> offsets { 0 };
 		vkCmdBindVertexBuffers(command_buf, 0, 1, buffers.data(), offsets.data());
 		if (hasIndexBuffer_) {
 			vkCmdBindIndexBuffer(command_buf, indexBuffer_->buffer(), 0, VK_INDEX_TYPE_UINT32);
@@ -103,8 +125,10 @@ namespace engine {
 	void Model::draw(VkCommandBuffer command_buf) const {
 		if (hasIndexBuffer_) {
 			vkCmdDrawIndexed(command_buf, indexCount_, 1, 0, 0, 0);
+			device_.counters().countDraw(indexCount_, 1);
 		} else {
 			vkCmdDraw(command_buf, vertexCount_, 1, 0, 0);
+			device_.counters().countDraw(vertexCount_, 1);
 		}
 	}
 
@@ -128,13 +152,38 @@ namespace engine {
 	}
 
 	std::unique_ptr<Model> Model::createModelFromFile(EngineDevice& device, const std::string& filepath) {
+		ENGINE_ZONE("Model::createModelFromFile");
 		Builder builder {};
 		builder.loadModel(filepath);
 		std::cout << "Vertex count: " << builder.vertices.size() << "\n";
 		return std::make_unique<Model>(device, builder);
 	}
 
+	void Model::collectTelemetry(MetricsWriter& metrics) {
+		metrics.counter("engine_model_files_loaded_total", "Model files parsed", static_cast<double>(files_loaded.load(std::memory_order_relaxed)));
+		metrics.counter("engine_model_load_seconds_total", "Time spent parsing model files", static_cast<double>(load_us.load(std::memory_order_relaxed)) / 1.0e6); // NOLINT
+		metrics.gauge("engine_model_loads_in_progress", "Model files being parsed", static_cast<double>(loads_in_progress.load(std::memory_order_relaxed)));
+		metrics.counter("engine_models_uploaded_total", "Models whose buffers were uploaded", static_cast<double>(models_uploaded.load(std::memory_order_relaxed)));
+		metrics.counter("engine_model_uploaded_bytes_total", "Vertex and index bytes uploaded for models", static_cast<double>(uploaded_bytes.load(std::memory_order_relaxed)));
+	}
+
 	void Model::Builder::loadModel(const std::string& filepath) {
+		ENGINE_ZONE("Model::Builder::loadModel");
+		// leaves the in progress count also when parsing throws
+		struct LoadScope {
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			LoadScope() { loads_in_progress.fetch_add(1, std::memory_order_relaxed); }
+			~LoadScope() {
+				loads_in_progress.fetch_sub(1, std::memory_order_relaxed);
+				const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+				load_us.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+			}
+			LoadScope(const LoadScope&) = delete;
+			LoadScope& operator=(const LoadScope&) = delete;
+			LoadScope(const LoadScope&&) = delete;
+			LoadScope&& operator=(const LoadScope&&) = delete;
+		};
+		const LoadScope load_scope {};
 		tinyobj::attrib_t attr;
 		std::vector<tinyobj::shape_t> shapes;
 		std::vector<tinyobj::material_t> materials;
@@ -143,6 +192,7 @@ namespace engine {
 		if (!tinyobj::LoadObj(&attr, &shapes, &materials, &warn, &err, filepath.c_str())) {
 			throw std::runtime_error(warn + err);
 		}
+		this->path = filepath;
 		this->vertices.clear();
 		this->indices.clear();
 		std::unordered_map<Vertex, uint32_t> unique_vertices {};
@@ -182,6 +232,7 @@ namespace engine {
 				indices.push_back(unique_vertices[vertex]);
 			}
 		}
+		files_loaded.fetch_add(1, std::memory_order_relaxed);
 	}
 
 }
@@ -1,5 +1,6 @@
 #include "pipeline.hpp"
 
+#include <chrono>
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
@@ -14,12 +15,27 @@ namespace engine {
 		const std::string& vert_path,
 		const std::string& frag_path,
 		const PipelineConfigInfo& config_info) : device_(device) {
-		createGraphicsPipeline(vert_path, frag_path, config_info);
+		// the modules are only needed while the pipeline is compiled
+		VkShaderModule vert_module = createShaderModule(device_, readFile(vert_path));
+		VkShaderModule frag_module = VK_NULL_HANDLE;
+		try {
+			frag_module = createShaderModule(device_, readFile(frag_path));
+			createGraphicsPipeline(vert_module, frag_module, config_info);
+		} catch (...) {
+			vkDestroyShaderModule(device_.device(), vert_module, nullptr);
+			vkDestroyShaderModule(device_.device(), frag_module, nullptr);
+			throw;
+		}
+		vkDestroyShaderModule(device_.device(), vert_module, nullptr);
+		vkDestroyShaderModule(device_.device(), frag_module, nullptr);
+	}
+
+	Pipeline::Pipeline(EngineDevice& device, VkShaderModule vert_module, VkShaderModule frag_module, const PipelineConfigInfo& config_info) // NOLINT
+		: device_(device) {
+		createGraphicsPipeline(vert_module, frag_module, config_info);
 	}
 
 	Pipeline::~Pipeline() {
-		vkDestroyShaderModule(device_.device(), vertShaderModule_, nullptr);
-		vkDestroyShaderModule(device_.device(), fragShaderModule_, nullptr);
 		vkDestroyPipeline(device_.device(), graphicsPipeline_, nullptr);
 	}
 
@@ -36,29 +52,36 @@ namespace engine {
 		return buffer;
 	}
 
-	void Pipeline::createGraphicsPipeline(const std::string& vert_path, const std::string& frag_path, const PipelineConfigInfo& config_info) {
+	void Pipeline::createGraphicsPipeline(VkShaderModule vert_module, VkShaderModule frag_module, const PipelineConfigInfo& config_info) {
 		assert(config_info.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline: no pipeline layout provided"); // NOLINT
 		assert(config_info.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline: no render pass provided"); // NOLINT
-		auto vert_code = readFile(vert_path);
-		auto frag_code = readFile(frag_path);
-		createShaderModule(vert_code, &vertShaderModule_);
-		createShaderModule(frag_code, &fragShaderModule_);
+
+		std::vector<VkSpecializationMapEntry> specialization_entries(config_info.specializationConstants.size());
+		for (uint32_t i = 0; i < specialization_entries.size(); i++) {
+			specialization_entries[i] = { i, static_cast<uint32_t>(i * sizeof(uint32_t)), sizeof(uint32_t) };
+		}
+		VkSpecializationInfo specialization_info {};
+		specialization_info.mapEntryCount = static_cast<uint32_t>(specialization_entries.size());
+		specialization_info.pMapEntries = specialization_entries.data();
+		specialization_info.dataSize = config_info.specializationConstants.size() * sizeof(uint32_t);
+		specialization_info.pData = config_info.specializationConstants.data();
+		const VkSpecializationInfo* specialization = specialization_entries.empty() ? nullptr : &specialization_info;
 
 		std::array<VkPipelineShaderStageCreateInfo, 2> shader_stages {};
 		shader_stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shader_stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-		shader_stages[0].module = vertShaderModule_;
+		shader_stages[0].module = vert_module;
 		shader_stages[0].pName = "main";
 		shader_stages[0].flags = 0;
 		shader_stages[0].pNext = nullptr;
-		shader_stages[0].pSpecializationInfo = nullptr;
+		shader_stages[0].pSpecializationInfo = specialization;
 		shader_stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shader_stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		shader_stages[1].module = fragShaderModule_;
+		shader_stages[1].module = frag_module;
 		shader_stages[1].pName = "main";
 		shader_stages[1].flags = 0;
 		shader_stages[1].pNext = nullptr;
-		shader_stages[1].pSpecializationInfo = nullptr;
+		shader_stages[1].pSpecializationInfo = specialization;
 
 		/* auto binding_descriptions = Model::Vertex::getBindingDescriptions(); */
 		/* auto attribute_descriptions = Model::Vertex::getAttributeDescriptions(); */
@@ -87,23 +110,28 @@ namespace engine {
 		pipeline_info.layout = config_info.pipelineLayout;
 		pipeline_info.renderPass = config_info.renderPass;
 		pipeline_info.subpass = config_info.subpass;
+		pipeline_info.flags = config_info.createFlags;
 		pipeline_info.basePipelineIndex = -1;
-		pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+		pipeline_info.basePipelineHandle = config_info.basePipeline;
 
 
-		if (vkCreateGraphicsPipelines(device_.device(), VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphicsPipeline_) != VK_SUCCESS) {
+		const auto start = std::chrono::steady_clock::now();
+		if (vkCreateGraphicsPipelines(device_.device(), device_.pipelineCache(), 1, &pipeline_info, nullptr, &graphicsPipeline_) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create graphics pipeline");
 		}
+		device_.recordPipelineCreation(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
 	}
 
-	void Pipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shader_module) {
+	VkShaderModule Pipeline::createShaderModule(EngineDevice& device, const std::vector<char>& code) {
 		VkShaderModuleCreateInfo create_info {};
 		create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 		create_info.codeSize = code.size();
 		create_info.pCode = reinterpret_cast<const uint32_t*>(code.data());
-		if (vkCreateShaderModule(device_.device(), &create_info, nullptr, shader_module) != VK_SUCCESS) {
+		VkShaderModule shader_module = VK_NULL_HANDLE;
+		if (vkCreateShaderModule(device.device(), &create_info, nullptr, &shader_module) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create shader module");
 		}
+		return shader_module;
 	}
 
 	PipelineConfigInfo Pipeline::defaultPipelineConfigInfo() {
@@ -182,5 +210,6 @@ namespace engine {
 
 	void Pipeline::bind(VkCommandBuffer command_buffer) {
 		vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
+		device_.counters().countPipelineBind();
 	}
 }
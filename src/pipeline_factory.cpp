@@ -0,0 +1,294 @@
+#include "pipeline_factory.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+#include "cpu_profiler.hpp"
+
+namespace engine {
+
+	namespace {
+
+		// NOLINTBEGIN
+		uint64_t fnv1a(const std::vector<char>& bytes) {
+			uint64_t hash = 0xcbf29ce484222325ULL;
+			for (const char byte : bytes) {
+				hash ^= static_cast<uint8_t>(byte);
+				hash *= 0x100000001b3ULL;
+			}
+			return hash ^ bytes.size();
+		}
+		// NOLINTEND
+
+		// appends the bytes of padding free values; create info structs are written field by field so
+		// neither pNext nor padding ends up in a key
+		class KeyWriter {
+			public:
+				explicit KeyWriter(std::string& key) : key_ { key } {}
+
+				template<typename T>
+				KeyWriter& add(const T& value) {
+					static_assert(std::is_trivially_copyable_v<T> && std::has_unique_object_representations_v<T>, "Key values must be padding free");
+					key_.append(reinterpret_cast<const char*>(&value), sizeof(T)); // NOLINT
+					return *this;
+				}
+
+				template<typename T>
+				KeyWriter& add(const T* values, size_t count) {
+					add(count);
+					for (size_t i = 0; i < count; i++) {
+						add(values[i]); // NOLINT
+					}
+					return *this;
+				}
+
+				KeyWriter& add(float value) {
+					uint32_t bits = 0;
+					std::memcpy(&bits, &value, sizeof(bits));
+					return add(bits);
+				}
+
+				KeyWriter& add(const VkViewport& viewport) {
+					return add(viewport.x).add(viewport.y).add(viewport.width).add(viewport.height).add(viewport.minDepth).add(viewport.maxDepth);
+				}
+
+			private:
+				std::string& key_;
+		};
+
+		std::string familyKey(const PipelineConfigInfo& config) {
+			std::string key {};
+			KeyWriter(key).add(config.pipelineLayout).add(config.renderPass).add(config.subpass);
+			return key;
+		}
+
+		std::string pipelineKey(const std::string& vert_path, const std::string& frag_path, const PipelineConfigInfo& config) {
+			std::string key = familyKey(config);
+			KeyWriter writer { key };
+			writer.add(vert_path.data(), vert_path.size()).add(frag_path.data(), frag_path.size());
+
+			const auto& input_assembly = config.inputAssemblyInfo;
+			writer.add(input_assembly.topology).add(input_assembly.primitiveRestartEnable);
+
+			const auto& viewport = config.viewportInfo;
+			writer.add(viewport.viewportCount).add(viewport.scissorCount);
+			if (viewport.pViewports != nullptr) {
+				writer.add(viewport.pViewports, viewport.viewportCount);
+			}
+			if (viewport.pScissors != nullptr) {
+				for (uint32_t i = 0; i < viewport.scissorCount; i++) {
+					const auto& scissor = viewport.pScissors[i]; // NOLINT
+					writer.add(scissor.offset.x).add(scissor.offset.y).add(scissor.extent.width).add(scissor.extent.height);
+				}
+			}
+
+			const auto& raster = config.rasterizationInfo;
+			writer.add(raster.depthClampEnable).add(raster.rasterizerDiscardEnable).add(raster.polygonMode).add(raster.cullMode).add(raster.frontFace)
+				.add(raster.depthBiasEnable).add(raster.depthBiasConstantFactor).add(raster.depthBiasClamp).add(raster.depthBiasSlopeFactor).add(raster.lineWidth);
+
+			const auto& multisample = config.multisampleInfo;
+			writer.add(multisample.rasterizationSamples).add(multisample.sampleShadingEnable).add(multisample.minSampleShading)
+				.add(multisample.alphaToCoverageEnable).add(multisample.alphaToOneEnable);
+			if (multisample.pSampleMask != nullptr) {
+				writer.add(multisample.pSampleMask, (multisample.rasterizationSamples + 31) / 32);
+			}
+
+			const auto& blend = config.colorBlendInfo;
+			writer.add(blend.logicOpEnable).add(blend.logicOp).add(blend.pAttachments, blend.attachmentCount);
+			for (const float constant : blend.blendConstants) {
+				writer.add(constant);
+			}
+
+			const auto& depth = config.depthStencilInfo;
+			writer.add(depth.depthTestEnable).add(depth.depthWriteEnable).add(depth.depthCompareOp).add(depth.depthBoundsTestEnable)
+				.add(depth.stencilTestEnable).add(depth.front).add(depth.back).add(depth.minDepthBounds).add(depth.maxDepthBounds);
+
+			// build() points the dynamic state info at this vector
+			writer.add(config.dynamicStateEnables.data(), config.dynamicStateEnables.size())
+				.add(config.bindingDescriptions.data(), config.bindingDescriptions.size())
+				.add(config.attributeDescriptions.data(), config.attributeDescriptions.size())
+				.add(config.specializationConstants.data(), config.specializationConstants.size());
+			return key;
+		}
+
+	}
+
+	Pipeline& PendingPipeline::get() {
+		if (pipeline_ == nullptr) {
+			assert(future_.valid() && "Pipeline was never created"); // NOLINT
+			pipeline_ = future_.get();
+		}
+		return *pipeline_;
+	}
+
+	PipelineFactory::PipelineFactory(EngineDevice& device, uint32_t worker_count) : device_ { device } {
+		worker_count = std::max(worker_count, 1U);
+		workers_.reserve(worker_count);
+		for (uint32_t i = 0; i < worker_count; i++) {
+			workers_.emplace_back([this] { workerLoop(); });
+		}
+	}
+
+	PipelineFactory::~PipelineFactory() {
+		{
+			const std::lock_guard<std::mutex> lock { mutex_ };
+			stopping_ = true;
+		}
+		jobReady_.notify_all();
+		for (auto& worker : workers_) {
+			worker.join();
+		}
+		destroyShaderModules();
+	}
+
+	PendingPipeline PipelineFactory::create(const std::string& vert_path, const std::string& frag_path, const PipelineConfigInfo& config_info) {
+		std::string key = pipelineKey(vert_path, frag_path, config_info);
+		std::string family = familyKey(config_info);
+
+		auto job = std::make_unique<Job>();
+		job->vertPath = vert_path;
+		job->fragPath = frag_path;
+		job->config = config_info;
+		// the copied config still points into the caller's storage
+		const auto& blend = config_info.colorBlendInfo;
+		job->blendAttachments.assign(blend.pAttachments, blend.pAttachments + blend.attachmentCount);
+		SharedPipeline future = job->promise.get_future().share();
+		{
+			const std::lock_guard<std::mutex> lock { mutex_ };
+			requested_++;
+			if (auto it = registry_.find(key); it != registry_.end()) {
+				return PendingPipeline { it->second };
+			}
+			registry_.emplace(std::move(key), future);
+
+			// jobs run in queue order, so the parent is built or being built when a child starts
+			if (auto [it, inserted] = families_.try_emplace(std::move(family), future); inserted) {
+				job->config.createFlags |= VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+			} else {
+				job->base = it->second;
+			}
+
+			if (unfinished_ == 0) {
+				batchStart_ = std::chrono::steady_clock::now();
+			}
+			unfinished_++;
+			jobs_.push_back(std::move(job));
+		}
+		jobReady_.notify_one();
+		return PendingPipeline { std::move(future) };
+	}
+
+	bool PipelineFactory::trimShaderModules() {
+		// holding the queue lock keeps workers from picking up a job while the modules go away
+		const std::lock_guard<std::mutex> lock { mutex_ };
+		if (unfinished_ != 0) {
+			return false;
+		}
+		const std::lock_guard<std::mutex> module_lock { moduleMutex_ };
+		if (modules_.empty()) {
+			return false;
+		}
+		destroyShaderModules();
+		return true;
+	}
+
+	void PipelineFactory::destroyShaderModules() {
+		for (auto& [hash, module] : modules_) {
+			try {
+				vkDestroyShaderModule(device_.device(), module.get(), nullptr);
+			} catch (const std::exception&) { // NOLINT
+				// creation failed, nothing to destroy
+			}
+		}
+		modules_.clear();
+	}
+
+	double PipelineFactory::lastBatchMs() const {
+		const std::lock_guard<std::mutex> lock { mutex_ };
+		return lastBatchMs_;
+	}
+
+	uint32_t PipelineFactory::requestedPipelines() const {
+		const std::lock_guard<std::mutex> lock { mutex_ };
+		return requested_;
+	}
+
+	uint32_t PipelineFactory::uniquePipelines() const {
+		const std::lock_guard<std::mutex> lock { mutex_ };
+		return static_cast<uint32_t>(registry_.size());
+	}
+
+	void PipelineFactory::workerLoop() {
+		ENGINE_THREAD_NAME("pipeline worker");
+		while (true) {
+			std::unique_ptr<Job> job {};
+			{
+				std::unique_lock<std::mutex> lock { mutex_ };
+				jobReady_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+				// queued jobs are still built on shutdown so no future is left without a value
+				if (jobs_.empty()) {
+					return;
+				}
+				job = std::move(jobs_.front());
+				jobs_.pop_front();
+			}
+
+			build(*job);
+
+			const std::lock_guard<std::mutex> lock { mutex_ };
+			if (--unfinished_ == 0) {
+				lastBatchMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - batchStart_).count();
+			}
+		}
+	}
+
+	void PipelineFactory::build(Job& job) {
+		ENGINE_ZONE("PipelineFactory::build");
+		try {
+			job.config.colorBlendInfo.pAttachments = job.blendAttachments.empty() ? nullptr : job.blendAttachments.data();
+			job.config.dynamamicStateInfo.pDynamicStates = job.config.dynamicStateEnables.data();
+			if (job.base.valid()) {
+				try {
+					job.config.basePipeline = job.base.get()->handle();
+					job.config.createFlags |= VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+				} catch (const std::exception&) { // NOLINT
+					// the parent failed, build standalone
+				}
+			}
+			VkShaderModule vert_module = shaderModule(job.vertPath);
+			VkShaderModule frag_module = shaderModule(job.fragPath);
+			job.promise.set_value(std::make_shared<Pipeline>(device_, vert_module, frag_module, job.config));
+		} catch (...) {
+			job.promise.set_exception(std::current_exception());
+		}
+	}
+
+	// The first thread to ask for a hash creates the module, others wait on its shared future
+	VkShaderModule PipelineFactory::shaderModule(const std::string& path) {
+		ENGINE_ZONE("PipelineFactory::shaderModule");
+		const std::vector<char> code = Pipeline::readFile(path);
+		std::promise<VkShaderModule> promise {};
+		std::shared_future<VkShaderModule> module {};
+		bool owner = false;
+		{
+			const std::lock_guard<std::mutex> lock { moduleMutex_ };
+			auto [it, inserted] = modules_.try_emplace(fnv1a(code));
+			if (inserted) {
+				it->second = promise.get_future().share();
+				owner = true;
+			}
+			module = it->second;
+		}
+		if (owner) {
+			try {
+				promise.set_value(Pipeline::createShaderModule(device_, code));
+			} catch (...) {
+				promise.set_exception(std::current_exception());
+			}
+		}
+		return module.get();
+	}
+
+}
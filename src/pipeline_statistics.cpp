@@ -0,0 +1,76 @@
+#include "pipeline_statistics.hpp"
+
+#include <array>
+#include <stdexcept>
+
+#include "cpu_profiler.hpp"
+#include "swap_chain.hpp"
+
+namespace engine {
+
+	namespace {
+
+		// results are written in the order of these bits
+		const VkQueryPipelineStatisticFlags STATISTICS =
+			VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+		const uint32_t STATISTICS_COUNT = 6;
+
+	}
+
+	PipelineStatistics::PipelineStatistics(EngineDevice& device) : device_ { device } {
+		if (!device_.pipelineStatisticsSupported()) {
+			return;
+		}
+		VkQueryPoolCreateInfo pool_info {};
+		pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		pool_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		pool_info.queryCount = SwapChain::MAX_FRAMES;
+		pool_info.pipelineStatistics = STATISTICS;
+		if (vkCreateQueryPool(device_.device(), &pool_info, nullptr, &queryPool_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline statistics query pool");
+		}
+		pending_.resize(SwapChain::MAX_FRAMES);
+	}
+
+	PipelineStatistics::~PipelineStatistics() {
+		vkDestroyQueryPool(device_.device(), queryPool_, nullptr);
+	}
+
+	void PipelineStatistics::beginFrame(VkCommandBuffer command_buf, int frame_idx) {
+		ENGINE_ZONE("PipelineStatistics::beginFrame");
+		if (!enabled()) {
+			return;
+		}
+		frameIdx_ = frame_idx;
+		const auto query = static_cast<uint32_t>(frame_idx);
+		if (pending_[frame_idx]) {
+			std::array<uint64_t, STATISTICS_COUNT> results {};
+			if (vkGetQueryPoolResults(device_.device(), queryPool_, query, 1, sizeof(results), results.data(),
+				sizeof(results), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+				latest_.valid = true;
+				latest_.inputVertices = results[0];
+				latest_.inputPrimitives = results[1];
+				latest_.vertexInvocations = results[2];
+				latest_.clippingInvocations = results[3];
+				latest_.clippingPrimitives = results[4];
+				latest_.fragmentInvocations = results[5]; // NOLINT
+			}
+		}
+		vkCmdResetQueryPool(command_buf, queryPool_, query, 1);
+		vkCmdBeginQuery(command_buf, queryPool_, query, 0);
+		pending_[frame_idx] = true;
+	}
+
+	void PipelineStatistics::endFrame(VkCommandBuffer command_buf) {
+		if (!enabled()) {
+			return;
+		}
+		vkCmdEndQuery(command_buf, queryPool_, static_cast<uint32_t>(frameIdx_));
+	}
+
+}
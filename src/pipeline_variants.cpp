@@ -0,0 +1,107 @@
+#include "pipeline_variants.hpp"
+
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+#include "swap_chain.hpp"
+#include "cpu_profiler.hpp"
+
+namespace engine {
+
+	namespace {
+
+		const double NS_PER_MS = 1.0e6;
+		const double SMOOTHING = 0.1;
+
+	}
+
+	PipelineVariants::PipelineVariants( // NOLINT
+		EngineDevice& device,
+		PipelineFactory& factory,
+		std::string vert_path,
+		std::string frag_path,
+		const PipelineConfigInfo& config_info
+	) : device_ { device }, factory_ { factory }, vertPath_ { std::move(vert_path) }, fragPath_ { std::move(frag_path) }, config_ { config_info } {
+		// later create() calls read the blend attachments through the stored config
+		const auto& blend = config_info.colorBlendInfo;
+		blendAttachments_.assign(blend.pAttachments, blend.pAttachments + blend.attachmentCount);
+		config_.colorBlendInfo.pAttachments = blendAttachments_.empty() ? nullptr : blendAttachments_.data();
+		config_.dynamamicStateInfo.pDynamicStates = config_.dynamicStateEnables.data();
+		variants_.reserve(MAX_VARIANTS);
+
+		if (device_.properties.limits.timestampComputeAndGraphics == VK_FALSE) {
+			return;
+		}
+		VkQueryPoolCreateInfo pool_info {};
+		pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		pool_info.queryCount = 2 * MAX_VARIANTS * SwapChain::MAX_FRAMES;
+		if (vkCreateQueryPool(device_.device(), &pool_info, nullptr, &queryPool_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create variant query pool");
+		}
+		timestampPeriod_ = device_.properties.limits.timestampPeriod;
+		timed_.assign(SwapChain::MAX_FRAMES, std::vector<bool>(MAX_VARIANTS, false));
+	}
+
+	PipelineVariants::~PipelineVariants() {
+		vkDestroyQueryPool(device_.device(), queryPool_, nullptr);
+	}
+
+	uint32_t PipelineVariants::variant(const std::vector<uint32_t>& constants) {
+		for (uint32_t i = 0; i < variants_.size(); i++) {
+			if (variants_[i]->constants == constants) {
+				return i;
+			}
+		}
+		if (variants_.size() == MAX_VARIANTS) {
+			throw std::runtime_error("too many pipeline variants");
+		}
+		config_.specializationConstants = constants;
+		auto entry = std::make_unique<Variant>();
+		entry->constants = constants;
+		entry->pipeline = factory_.create(vertPath_, fragPath_, config_);
+		variants_.push_back(std::move(entry));
+		return static_cast<uint32_t>(variants_.size() - 1);
+	}
+
+	void PipelineVariants::beginFrame(VkCommandBuffer command_buf, int frame_idx) {
+		ENGINE_ZONE("PipelineVariants::beginFrame");
+		if (queryPool_ == VK_NULL_HANDLE) {
+			return;
+		}
+		auto& timed = timed_[frame_idx];
+		for (uint32_t i = 0; i < variants_.size(); i++) {
+			if (!timed[i]) {
+				continue;
+			}
+			std::array<uint64_t, 2> timestamps {};
+			const VkResult result = vkGetQueryPoolResults(device_.device(), queryPool_, query(frame_idx, i), 2, sizeof(timestamps),
+				timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+			if (result == VK_SUCCESS) {
+				const double ms = static_cast<double>(timestamps[1] - timestamps[0]) * timestampPeriod_ / NS_PER_MS;
+				auto& gpu_ms = variants_[i]->gpuMs;
+				gpu_ms = gpu_ms == 0.0 ? ms : gpu_ms + (ms - gpu_ms) * SMOOTHING;
+			}
+			timed[i] = false;
+		}
+		vkCmdResetQueryPool(command_buf, queryPool_, query(frame_idx, 0), 2 * MAX_VARIANTS);
+	}
+
+	void PipelineVariants::beginTimed(VkCommandBuffer command_buf, int frame_idx, uint32_t variant) {
+		if (queryPool_ == VK_NULL_HANDLE) {
+			return;
+		}
+		assert(!timed_[frame_idx][variant] && "Variant already timed this frame"); // NOLINT
+		vkCmdWriteTimestamp(command_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool_, query(frame_idx, variant));
+	}
+
+	void PipelineVariants::endTimed(VkCommandBuffer command_buf, int frame_idx, uint32_t variant) {
+		if (queryPool_ == VK_NULL_HANDLE) {
+			return;
+		}
+		vkCmdWriteTimestamp(command_buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool_, query(frame_idx, variant) + 1);
+		timed_[frame_idx][variant] = true;
+	}
+
+}
@@ -2,56 +2,133 @@
 
 #include <glm/gtc/constants.hpp>
 
+#include <array>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+#include "swap_chain.hpp"
+#include "cpu_profiler.hpp"
+
 namespace engine {
 
-	struct PushConstantData {
+	// World matrices come from the hierarchy and may shear (a rotated child of a non-uniformly scaled
+	// parent), so the normal matrix is the full inverse transpose, stored as three vec4 columns to
+	// match the std430 layout in simple_shader.vert
+	struct ObjectData {
 		glm::mat4 modelMatrix { 1.0F };
-		glm::mat4 normalMatrix { 1.0F };
+		std::array<glm::vec4, 3> normalMatrix {};
+	};
+
+	// the object buffer is read through its heap handle, see simple_shader.vert
+	struct PushConstantData {
+		uint32_t objectIdx = 0;
+		uint32_t objectBuffer = BindlessHeap::INVALID_HANDLE;
 	};
 
-	RenderSystem::RenderSystem(EngineDevice& device, VkRenderPass render_pass, VkDescriptorSetLayout global_set_layout) : device_{ device }  { // NOLINT
+	RenderSystem::RenderSystem(EngineDevice& device, PipelineFactory& pipelines, VkRenderPass render_pass, VkDescriptorSetLayout global_set_layout, BindlessHeap& heap, RenderPath path) : device_{ device }, heap_ { heap } { // NOLINT
+		createObjectBuffers();
 		createPipelineLayout(global_set_layout);
-		createPipeline(render_pass);
+		createPipeline(pipelines, render_pass, path);
 	}
 
 	RenderSystem::~RenderSystem() {
+		// each buffer is only read by its own frame slot, so its handle can be reused once that slot comes around
+		for (size_t i = 0; i < objectHandles_.size(); i++) {
+			heap_.removeStorageBuffer(objectHandles_[i], static_cast<int>(i));
+		}
 		vkDestroyPipelineLayout(device_.device(), pipelineLayout_, nullptr);
 	}
 
 
+	void RenderSystem::createObjectBuffers() {
+		passSetLayout_ = DescriptorSetLayout::Builder(device_).build();
+
+		objectBuffers_.resize(SwapChain::MAX_FRAMES);
+		objectHandles_.resize(SwapChain::MAX_FRAMES);
+		uploadedObjects_.assign(SwapChain::MAX_FRAMES, std::vector<UploadedObject>(MAX_OBJECTS));
+		for (size_t i = 0; i < objectBuffers_.size(); i++) {
+			objectBuffers_[i] = std::make_unique<Buffer>(
+				device_,
+				sizeof(ObjectData),
+				MAX_OBJECTS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			objectBuffers_[i]->map();
+			objectHandles_[i] = heap_.addStorageBuffer(objectBuffers_[i]->decriptorInfo());
+		}
+	}
+
+	void RenderSystem::setShadingFeatures(const ShadingFeatures& features) {
+		features_ = features;
+		variant_ = variants_->variant(features_.specializationConstants());
+	}
+
 	void RenderSystem::renderSceneObjects(FrameInfo& frame_info) {
-		pipeline_->bind(frame_info.cmdBuf);
+		ENGINE_ZONE("RenderSystem::renderSceneObjects");
+		variants_->beginTimed(frame_info.cmdBuf, frame_info.frameIdx, variant_);
+		variants_->bind(frame_info.cmdBuf, variant_);
 
 		vkCmdBindDescriptorSets(frame_info.cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &frame_info.globalDescriptorSet, 0, nullptr);
-
-		for (auto& kv : frame_info.sceneObjects) { // NOLINT
-			auto& obj = kv.second;
-			if (obj.model == nullptr) {
-				continue;
+		vkCmdBindDescriptorSets(frame_info.cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, BindlessHeap::SET, 1, &frame_info.bindlessDescriptorSet, 0, nullptr);
+
+		auto& object_buffer = *objectBuffers_[frame_info.frameIdx];
+		auto& uploaded_objects = uploadedObjects_[frame_info.frameIdx];
+		uint32_t object_idx = 0;
+		uint32_t skipped = 0;
+		bool buffer_changed = false;
+		auto& scene = frame_info.scene;
+		scene.spatialIndex().query(frame_info.camera.frustum(), [&](Entity entity) {
+			const auto* model = scene.tryGet<ModelComponent>(entity);
+			if (model == nullptr) {
+				return;
+			}
+			// the object buffer has no slot left, so the rest of the visible objects are not drawn
+			if (object_idx == MAX_OBJECTS) {
+				skipped++;
+				return;
+			}
+			auto& uploaded = uploaded_objects[object_idx];
+			const uint32_t version = scene.worldVersion(entity);
+			if (uploaded.entity != entity || uploaded.version != version) {
+				ObjectData object_data {};
+				object_data.modelMatrix = scene.worldMatrix(entity);
+				const glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(object_data.modelMatrix)));
+				for (int column = 0; column < 3; column++) {
+					object_data.normalMatrix[column] = glm::vec4(normal_matrix[column], 0.0F); // NOLINT
+				}
+				object_buffer.writeToIndex(&object_data, static_cast<int>(object_idx));
+				uploaded = { entity, version };
+				buffer_changed = true;
 			}
+
 			PushConstantData push {};
-			push.modelMatrix = obj.transform.mat4();
-			push.normalMatrix = obj.transform.normalMatrix();
-			vkCmdPushConstants(
-				frame_info.cmdBuf,
-				pipelineLayout_,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(PushConstantData),
-				&push
-			);
-			obj.model->bind(frame_info.cmdBuf);
-			obj.model->draw(frame_info.cmdBuf);
+			push.objectIdx = object_idx;
+			push.objectBuffer = objectHandles_[frame_info.frameIdx];
+			vkCmdPushConstants(frame_info.cmdBuf, pipelineLayout_, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstantData), &push);
+			model->model->bind(frame_info.cmdBuf);
+			model->model->draw(frame_info.cmdBuf);
+			object_idx++;
+		});
+		if (buffer_changed) {
+			object_buffer.flush();
+		}
+		// warn once per run of frames that overflow, not every frame
+		if (skipped > 0 && skippedObjects_ == 0) {
+			std::cerr << "more than " << MAX_OBJECTS << " visible objects, " << skipped << " were not drawn\n";
 		}
+		skippedObjects_ = skipped;
+		variants_->endTimed(frame_info.cmdBuf, frame_info.frameIdx, variant_);
 	}
 
 	void RenderSystem::createPipelineLayout(VkDescriptorSetLayout global_set_layout) {
 		VkPushConstantRange pushConstantRange {};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 		pushConstantRange.offset = 0;
 		pushConstantRange.size = sizeof(PushConstantData);
 
-		std::vector<VkDescriptorSetLayout> descriptor_set_layouts { global_set_layout };
+		std::vector<VkDescriptorSetLayout> descriptor_set_layouts { global_set_layout, passSetLayout_->descriptorSetLayout(), heap_.descriptorSetLayout() };
 
 		VkPipelineLayoutCreateInfo layout_create_info {};
 		layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -64,13 +141,26 @@ namespace engine {
 		}
 	}
 
-	void RenderSystem::createPipeline(VkRenderPass render_pass) {
+	void RenderSystem::createPipeline(PipelineFactory& pipelines, VkRenderPass render_pass, RenderPath path) {
 		assert(pipelineLayout_ && "Cannot create pipeline before pipeline layout"); // NOLINT
 
 		PipelineConfigInfo pipeline_config = Pipeline::defaultPipelineConfigInfo();
 		pipeline_config.renderPass = render_pass;
 		pipeline_config.pipelineLayout = pipelineLayout_;
-		pipeline_ = std::make_unique<Pipeline>(device_, "../shader/build/simple_shader.vert.spv", "../shader/build/simple_shader.frag.spv", pipeline_config);
+		if (path == RenderPath::Forward) {
+			variants_ = std::make_unique<PipelineVariants>(device_, pipelines, "../shader/build/simple_shader.vert.spv", "../shader/build/simple_shader.frag.spv", pipeline_config);
+			setShadingFeatures(features_);
+			return;
+		}
+
+		// one blend state per G-buffer attachment
+		const std::array<VkPipelineColorBlendAttachmentState, 2> blend_attachments { pipeline_config.colorBlendAttachment, pipeline_config.colorBlendAttachment };
+		pipeline_config.colorBlendInfo.attachmentCount = static_cast<uint32_t>(blend_attachments.size());
+		pipeline_config.colorBlendInfo.pAttachments = blend_attachments.data();
+		pipeline_config.subpass = SwapChain::GEOMETRY_SUBPASS;
+		// the G-buffer shader does no lighting, so it only ever has the default variant
+		variants_ = std::make_unique<PipelineVariants>(device_, pipelines, "../shader/build/simple_shader.vert.spv", "../shader/build/gbuffer.frag.spv", pipeline_config);
+		setShadingFeatures(features_);
 
 	}
 
@@ -4,20 +4,46 @@
 #include <cassert>
 #include <stdexcept>
 
+#include "cpu_profiler.hpp"
+
 namespace engine {
-	Renderer::Renderer(Window& window, EngineDevice& device) : window_ { window }, device_ { device } {
+	Renderer::Renderer(Window& window, EngineDevice& device) : window_ { &window }, device_ { device } {
+		recreateSwapChain();
+		createCmdBuffers();
+	}
+
+	Renderer::Renderer(EngineDevice& device, VkExtent2D extent) : device_ { device }, offscreenExtent_ { extent } {
+		assert(device_.headless() && "Offscreen renderer needs a headless device");
 		recreateSwapChain();
 		createCmdBuffers();
 	}
 
 	Renderer::~Renderer() {
+		if (readback_ != nullptr) {
+			vkDeviceWaitIdle(device_.device());
+			readback_->collectAll();
+			readback_.reset();
+		}
 		freeCmdBuffers();
 	}
 
+	void Renderer::captureFrames(const std::string& directory) {
+		assert(isHeadless() && "Frames can only be captured from an offscreen renderer");
+		readback_ = std::make_unique<FrameReadback>(device_, swapChain_->getSwapChainExtent(), directory);
+	}
+
 	void Renderer::recreateSwapChain() {
-		auto extent = window_.extent();
+		ENGINE_ZONE("Renderer::recreateSwapChain");
+		if (swapChain_ != nullptr) {
+			device_.counters().countSwapChainRecreation();
+		}
+		if (isHeadless()) {
+			swapChain_ = std::make_unique<SwapChain>(device_, offscreenExtent_);
+			return;
+		}
+		auto extent = window_->extent();
 		while (extent.width == 0 || extent.height == 0) {
-			extent = window_.extent();
+			extent = window_->extent();
 			glfwWaitEvents();
 		}
 		vkDeviceWaitIdle(device_.device());
@@ -51,6 +77,7 @@ namespace engine {
 	}
 
 	VkCommandBuffer Renderer::beginFrame() {
+		ENGINE_ZONE("Renderer::beginFrame");
 		assert(!isFrameStarted_ && "Can't call beginFrame while already in progress");
 		auto res = swapChain_->acquireNextImage(&curImageIdx_);
 		if (res == VK_ERROR_OUT_OF_DATE_KHR) {
@@ -60,6 +87,10 @@ namespace engine {
 		if (res != VK_SUCCESS && res != VK_SUBOPTIMAL_KHR) {
 			throw std::runtime_error("failed to acquire swap chain image");
 		}
+		// the slot's fence was just waited on, so its previous readback has landed
+		if (readback_ != nullptr) {
+			readback_->collect(curFrameIdx_);
+		}
 		isFrameStarted_ = true;
 		auto cmd_buf = currentCmdbuffer();
 		VkCommandBufferBeginInfo begin_info {};
@@ -71,35 +102,57 @@ namespace engine {
 	}
 
 	void Renderer::endFrame() {
+		ENGINE_ZONE("Renderer::endFrame");
 		assert(isFrameStarted_ && "Can't call endFrame while frame is not in progress");
 		auto cmd_buf = currentCmdbuffer();
+		if (readback_ != nullptr) {
+			readback_->record(cmd_buf, curFrameIdx_, swapChain_->getImage(static_cast<int>(curImageIdx_)), frameNumber_);
+		}
 		if (vkEndCommandBuffer(cmd_buf) != VK_SUCCESS) {
 			std::runtime_error("failed to record command buffer");
 		}
 		auto res = swapChain_->submitCommandBuffers(&cmd_buf, &curImageIdx_);
-		if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR || window_.wasResized()) {
-			window_.resetWindowResize();
+		if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR || (window_ != nullptr && window_->wasResized())) {
+			window_->resetWindowResize();
 			recreateSwapChain();
 		} else if (res != VK_SUCCESS) {
 			throw std::runtime_error("failed to present swap chain image");
 		}
 		isFrameStarted_ = false;
 		curFrameIdx_ = (curFrameIdx_ + 1) % SwapChain::MAX_FRAMES;
+		frameNumber_++;
+		// commands copy their parameters when recorded, nothing in the arena outlives the submit
+		frameArena_.reset();
+	}
+
+	void Renderer::collectTelemetry(MetricsWriter& metrics) const {
+		const auto extent = swapChain_->getSwapChainExtent();
+		metrics.gauge("engine_swap_chain_width", "Width of the swap chain images", static_cast<double>(extent.width));
+		metrics.gauge("engine_swap_chain_height", "Height of the swap chain images", static_cast<double>(extent.height));
+		metrics.gauge("engine_fence_wait_ms", "Time the last frame blocked on fences", swapChain_->fenceWaitMs());
+		metrics.gauge("engine_frame_arena_capacity_bytes", "Capacity of the frame arena", static_cast<double>(frameArena_.capacity()));
+		metrics.gauge("engine_frame_arena_peak_bytes", "Most of the frame arena used by one frame", static_cast<double>(frameArena_.peak()));
+		if (readback_ != nullptr) {
+			metrics.gauge("engine_capture_queue_depth", "Captured frames waiting to be written", static_cast<double>(readback_->queuedFrames()));
+			metrics.counter("engine_captured_frames_total", "Captured frames written to disk", static_cast<double>(readback_->framesWritten()));
+		}
 	}
 
-	void Renderer::beginSwapChainRenderPass(VkCommandBuffer cmd_buf) {
+	void Renderer::beginSwapChainRenderPass(VkCommandBuffer cmd_buf, RenderPath path) {
 		assert(isFrameStarted_ && "Can't call beginSwapChainRenderPass if frame is not in progress");
 		assert(cmd_buf == currentCmdbuffer() && "Can't begin render pass on command buffer from a different frame");
 		VkRenderPassBeginInfo render_pass_info {};
 		render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		render_pass_info.renderPass = swapChain_->getRenderPass();
-		render_pass_info.framebuffer = swapChain_->getFrameBuffer(curImageIdx_);
+		const bool deferred = path == RenderPath::Deferred;
+		render_pass_info.renderPass = deferred ? swapChain_->getDeferredRenderPass() : swapChain_->getRenderPass();
+		render_pass_info.framebuffer = deferred ? swapChain_->getDeferredFrameBuffer(curImageIdx_) : swapChain_->getFrameBuffer(curImageIdx_);
 		render_pass_info.renderArea.offset = { 0, 0 };
 		render_pass_info.renderArea.extent = swapChain_->getSwapChainExtent();
-		std::array<VkClearValue, 2> clear_values {};
+		// the deferred pass also clears albedo and normal
+		std::array<VkClearValue, 4> clear_values {};
 		clear_values[0].color = {{ 0.01f, 0.01f, 0.01f, 1.0f }};
 		clear_values[1].depthStencil = { 1.0f, 0 };
-		render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+		render_pass_info.clearValueCount = deferred ? 4 : 2;
 		render_pass_info.pClearValues = clear_values.data();
 
 		vkCmdBeginRenderPass(cmd_buf, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
@@ -117,6 +170,12 @@ namespace engine {
 
 	}
 
+	void Renderer::nextSubpass(VkCommandBuffer cmd_buf) {
+		assert(isFrameStarted_ && "Can't call nextSubpass if frame is not in progress");
+		assert(cmd_buf == currentCmdbuffer() && "Can't advance render pass on command buffer from a different frame");
+		vkCmdNextSubpass(cmd_buf, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
 	void Renderer::endSwapChainRenderPass(VkCommandBuffer cmd_buf) {
 		assert(isFrameStarted_ && "Can't call endSwapChainRenderPass if frame is not in progress");
 		assert(cmd_buf == currentCmdbuffer() && "Can't end render pass on command buffer from a different frame");
@@ -0,0 +1,264 @@
+#include "scene_file.hpp"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "cpu_profiler.hpp"
+
+namespace engine {
+
+	namespace {
+
+		const std::array<char, 4> MAGIC { 'E', 'S', 'C', 'N' };
+		const uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+
+		struct Header {
+			std::array<char, 4> magic {};
+			uint32_t version = 0;
+			uint32_t entityCount = 0;
+			uint32_t lightCount = 0;
+			uint32_t modelCount = 0;
+			uint32_t stringTableSize = 0;
+		};
+
+		struct EntityRecord {
+			std::array<float, 3> translation {};
+			std::array<float, 3> rotation {};
+			std::array<float, 3> scale {};
+			uint32_t parent = NO_INDEX;
+			uint32_t model = NO_INDEX;
+		};
+
+		struct LightRecord {
+			uint32_t entity = 0;
+			float intensity = 0.0F;
+			std::array<float, 3> color {};
+		};
+
+		struct StringRecord {
+			uint32_t offset = 0;
+			uint32_t length = 0;
+		};
+
+		static_assert(sizeof(Header) == 24 && sizeof(EntityRecord) == 44 && sizeof(LightRecord) == 20 && sizeof(StringRecord) == 8, "Scene file records must be tightly packed");
+
+		std::array<float, 3> toArray(const glm::vec3& v) { return { v.x, v.y, v.z }; }
+		glm::vec3 toVec3(const std::array<float, 3>& a) { return { a[0], a[1], a[2] }; }
+
+		template<typename T>
+		void append(std::vector<char>& out, const T* data, size_t count) {
+			const auto* bytes = reinterpret_cast<const char*>(data); // NOLINT
+			out.insert(out.end(), bytes, bytes + sizeof(T) * count);
+		}
+
+		// bounds checked view over the file contents
+		template<typename T>
+		const T* view(const std::vector<char>& data, size_t& offset, size_t count, const std::string& filepath) {
+			if (data.size() - offset < sizeof(T) * count) {
+				throw std::runtime_error("truncated scene file: " + filepath);
+			}
+			const auto* ptr = reinterpret_cast<const T*>(data.data() + offset); // NOLINT
+			offset += sizeof(T) * count;
+			return ptr;
+		}
+
+		// Indices in range, no parent cycles, at most one light per entity and no entity with both a
+		// model and a light; both would get a BoundsComponent on load.
+		bool validRecords(const EntityRecord* entities, size_t count, const LightRecord* lights, size_t light_count, size_t model_count) {
+			for (size_t i = 0; i < count; i++) {
+				const auto& record = entities[i]; // NOLINT
+				if ((record.model != NO_INDEX && record.model >= model_count) || (record.parent != NO_INDEX && record.parent >= count)) {
+					return false;
+				}
+			}
+
+			// 0 unvisited, 1 on the current parent chain, 2 known to reach a root
+			std::vector<uint8_t> state(count, 0);
+			for (size_t i = 0; i < count; i++) {
+				uint32_t node = static_cast<uint32_t>(i);
+				while (node != NO_INDEX && state[node] == 0) {
+					state[node] = 1;
+					node = entities[node].parent; // NOLINT
+				}
+				if (node != NO_INDEX && state[node] == 1) {
+					return false;
+				}
+				for (node = static_cast<uint32_t>(i); node != NO_INDEX && state[node] == 1; node = entities[node].parent) { // NOLINT
+					state[node] = 2;
+				}
+			}
+
+			std::vector<uint8_t> has_light(count, 0);
+			for (size_t i = 0; i < light_count; i++) {
+				const uint32_t entity = lights[i].entity; // NOLINT
+				if (entity >= count || has_light[entity] != 0 || entities[entity].model != NO_INDEX) { // NOLINT
+					return false;
+				}
+				has_light[entity] = 1;
+			}
+			return true;
+		}
+
+	}
+
+	void SceneFile::save(const std::string& filepath, Scene& scene) {
+		ENGINE_ZONE("SceneFile::save");
+		auto& transform_pool = scene.pool<TransformComponent>();
+		const auto& entities = transform_pool.entities();
+		const auto& transforms = transform_pool.components();
+
+		std::unordered_map<Entity, uint32_t> index_of {};
+		index_of.reserve(entities.size());
+		for (size_t i = 0; i < entities.size(); i++) {
+			index_of.emplace(entities[i], static_cast<uint32_t>(i));
+		}
+
+		std::vector<StringRecord> models {};
+		std::string string_table {};
+		std::unordered_map<std::string, uint32_t> model_index {};
+		std::vector<EntityRecord> entity_records(entities.size());
+		for (size_t i = 0; i < entities.size(); i++) {
+			auto& record = entity_records[i];
+			record.translation = toArray(transforms[i].translation());
+			record.rotation = toArray(transforms[i].rotation());
+			record.scale = toArray(transforms[i].scale());
+			const Entity parent = scene.parent(entities[i]);
+			record.parent = parent == NULL_ENTITY ? NO_INDEX : index_of.at(parent);
+
+			const auto* model = scene.tryGet<ModelComponent>(entities[i]);
+			if (model == nullptr || model->model == nullptr || model->model->path().empty()) {
+				continue;
+			}
+			const auto& path = model->model->path();
+			auto [it, inserted] = model_index.emplace(path, static_cast<uint32_t>(models.size()));
+			if (inserted) {
+				models.push_back({ static_cast<uint32_t>(string_table.size()), static_cast<uint32_t>(path.size()) });
+				string_table += path;
+			}
+			record.model = it->second;
+		}
+
+		std::vector<LightRecord> light_records {};
+		scene.each<PointLightComponent>([&](Entity entity, PointLightComponent& light) {
+			light_records.push_back({ index_of.at(entity), light.lightIntensity, toArray(light.color) });
+		});
+		// never write a file load() would reject
+		if (!validRecords(entity_records.data(), entity_records.size(), light_records.data(), light_records.size(), models.size())) {
+			throw std::runtime_error("failed to save scene, an entity has both a model and a light or is its own ancestor: " + filepath);
+		}
+
+		Header header {};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.entityCount = static_cast<uint32_t>(entity_records.size());
+		header.lightCount = static_cast<uint32_t>(light_records.size());
+		header.modelCount = static_cast<uint32_t>(models.size());
+		header.stringTableSize = static_cast<uint32_t>(string_table.size());
+
+		std::vector<char> data {};
+		append(data, &header, 1);
+		append(data, entity_records.data(), entity_records.size());
+		append(data, light_records.data(), light_records.size());
+		append(data, models.data(), models.size());
+		append(data, string_table.data(), string_table.size());
+
+		std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+		file.write(data.data(), static_cast<std::streamsize>(data.size()));
+		if (!file) {
+			throw std::runtime_error("failed to write scene file: " + filepath);
+		}
+	}
+
+	std::vector<Entity> SceneFile::load(const std::string& filepath, Scene& scene, const ModelLoader& loader) {
+		ENGINE_ZONE("SceneFile::load");
+		std::ifstream file(filepath, std::ios::ate | std::ios::binary);
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+		auto size = static_cast<size_t>(file.tellg());
+		std::vector<char> data(size);
+		file.seekg(0);
+		file.read(data.data(), static_cast<std::streamsize>(size));
+		file.close();
+
+		size_t offset = 0;
+		const auto& header = *view<Header>(data, offset, 1, filepath);
+		if (header.magic != MAGIC || header.version != VERSION) {
+			throw std::runtime_error("invalid scene file: " + filepath);
+		}
+		const auto* entity_records = view<EntityRecord>(data, offset, header.entityCount, filepath);
+		const auto* light_records = view<LightRecord>(data, offset, header.lightCount, filepath);
+		const auto* model_records = view<StringRecord>(data, offset, header.modelCount, filepath);
+		const auto* string_table = view<char>(data, offset, header.stringTableSize, filepath);
+
+		const size_t count = header.entityCount;
+		// validate everything before loading models so a bad file leaves the scene untouched
+		for (uint32_t i = 0; i < header.modelCount; i++) {
+			if (static_cast<size_t>(model_records[i].offset) + model_records[i].length > header.stringTableSize) {
+				throw std::runtime_error("invalid scene file: " + filepath);
+			}
+		}
+		if (!validRecords(entity_records, count, light_records, header.lightCount, header.modelCount)) {
+			throw std::runtime_error("invalid scene file: " + filepath);
+		}
+
+		std::vector<std::shared_ptr<Model>> models(header.modelCount);
+		for (uint32_t i = 0; i < header.modelCount; i++) {
+			models[i] = loader(std::string(string_table + model_records[i].offset, model_records[i].length));
+		}
+
+		std::vector<Entity> entities = scene.createObjects(count);
+		if (count == 0) {
+			return entities;
+		}
+		auto* transforms = &scene.get<TransformComponent>(entities[0]);
+		// record indices of entities that get a model
+		std::vector<uint32_t> model_entities {};
+		for (size_t i = 0; i < count; i++) {
+			const auto& record = entity_records[i];
+			transforms[i] = TransformComponent { toVec3(record.translation), toVec3(record.rotation), toVec3(record.scale) };
+			if (record.model != NO_INDEX && models[record.model] != nullptr) {
+				model_entities.push_back(static_cast<uint32_t>(i));
+			}
+		}
+		for (size_t i = 0; i < count; i++) {
+			const uint32_t parent = entity_records[i].parent;
+			if (parent != NO_INDEX) {
+				scene.setParent(entities[i], entities[parent]);
+			}
+		}
+
+		std::vector<Entity> batch(model_entities.size());
+		for (size_t i = 0; i < model_entities.size(); i++) {
+			batch[i] = entities[model_entities[i]];
+		}
+		auto* model_components = scene.pool<ModelComponent>().emplaceBatch(batch.data(), batch.size());
+		auto* model_bounds = scene.pool<BoundsComponent>().emplaceBatch(batch.data(), batch.size());
+		for (size_t i = 0; i < model_entities.size(); i++) {
+			const auto& model = models[entity_records[model_entities[i]].model];
+			model_components[i].model = model;
+			model_bounds[i].local = model->bounds();
+		}
+
+		batch.resize(header.lightCount);
+		for (uint32_t i = 0; i < header.lightCount; i++) {
+			batch[i] = entities[light_records[i].entity];
+		}
+		auto* lights = scene.pool<PointLightComponent>().emplaceBatch(batch.data(), batch.size());
+		auto* light_bounds = scene.pool<BoundsComponent>().emplaceBatch(batch.data(), batch.size());
+		for (uint32_t i = 0; i < header.lightCount; i++) {
+			lights[i].lightIntensity = light_records[i].intensity;
+			lights[i].color = toVec3(light_records[i].color);
+			light_bounds[i].radius = lights[i].range();
+		}
+		return entities;
+	}
+
+}
@@ -1,54 +1,88 @@
 #include "scene_object.hpp"
+#include "cpu_profiler.hpp"
 
 namespace engine {
 
+	void TransformComponent::setTranslation(const glm::vec3& translation) {
+		if (translation == translation_) {
+			return;
+		}
+		translation_ = translation;
+		matrix_[3] = glm::vec4(translation_, 1.0F);
+		version_++;
+		link_.queue();
+	}
+
+	void TransformComponent::setScale(const glm::vec3& scale) {
+		if (scale == scale_) {
+			return;
+		}
+		scale_ = scale;
+		dirty_ = true;
+		version_++;
+		link_.queue();
+	}
+
+	void TransformComponent::setRotation(const glm::vec3& rotation) {
+		if (rotation == rotation_) {
+			return;
+		}
+		rotation_ = rotation;
+		dirty_ = true;
+		version_++;
+		link_.queue();
+	}
+
+	const glm::mat4& TransformComponent::mat4() const {
+		if (dirty_) {
+			updateMatrices();
+		}
+		return matrix_;
+	}
+
+	const glm::mat3& TransformComponent::normalMatrix() const {
+		if (dirty_ || normalDirty_) {
+			updateMatrices();
+		}
+		return normalMatrix_;
+	}
+
 	// NOLINTBEGIN
-	glm::mat4 TransformComponent::mat4() const {
-		const float c3 = glm::cos(rotation.z);
-		const float s3 = glm::sin(rotation.z);
-		const float c2 = glm::cos(rotation.x);
-		const float s2 = glm::sin(rotation.x);
-		const float c1 = glm::cos(rotation.y);
-		const float s1 = glm::sin(rotation.y);
-		return glm::mat4{
+	void TransformComponent::updateMatrices() const {
+		const float c3 = glm::cos(rotation_.z);
+		const float s3 = glm::sin(rotation_.z);
+		const float c2 = glm::cos(rotation_.x);
+		const float s2 = glm::sin(rotation_.x);
+		const float c1 = glm::cos(rotation_.y);
+		const float s1 = glm::sin(rotation_.y);
+		const glm::vec3 inv_scale = 1.0F / scale_;
+		matrix_ = glm::mat4{
 			{
-				scale.x * (c1 * c3 + s1 * s2 * s3),
-				scale.x * (c2 * s3),
-				scale.x * (c1 * s2 * s3 - c3 * s1),
+				scale_.x * (c1 * c3 + s1 * s2 * s3),
+				scale_.x * (c2 * s3),
+				scale_.x * (c1 * s2 * s3 - c3 * s1),
 				0.0F,
 			},
 			{
-				scale.y * (c3 * s1 * s2 - c1 * s3),
-				scale.y * (c2 * c3),
-				scale.y * (c1 * c3 * s2 + s1 * s3),
+				scale_.y * (c3 * s1 * s2 - c1 * s3),
+				scale_.y * (c2 * c3),
+				scale_.y * (c1 * c3 * s2 + s1 * s3),
 				0.0F,
 			},
 			{
-				scale.z * (c2 * s1),
-				scale.z * (-s2),
-				scale.z * (c1 * c2),
+				scale_.z * (c2 * s1),
+				scale_.z * (-s2),
+				scale_.z * (c1 * c2),
 				0.0F,
 			},
 			{
-				translation.x,
-				translation.y,
-				translation.z,
+				translation_.x,
+				translation_.y,
+				translation_.z,
 				1.0F
 			}
 		};
-	}
-	// NOLINTEND
-
-	// NOLINTBEGIN
-	glm::mat3 TransformComponent::normalMatrix() {
-		const float c3 = glm::cos(rotation.z);
-		const float s3 = glm::sin(rotation.z);
-		const float c2 = glm::cos(rotation.x);
-		const float s2 = glm::sin(rotation.x);
-		const float c1 = glm::cos(rotation.y);
-		const float s1 = glm::sin(rotation.y);
-		const glm::vec3 inv_scale = 1.0F / scale;
-		return glm::mat3 {
+		normalMatrix_ = glm::mat3 {
 			{
 				inv_scale.x * (c1 * c3 + s1 * s2 * s3),
 				inv_scale.x * (c2 * s3),
@@ -65,16 +99,145 @@ namespace engine {
 				inv_scale.z * (c1 * c2)
 			}
 		};
+		dirty_ = false;
+		normalDirty_ = false;
 	}
 	// NOLINTEND
 
-	SceneObject SceneObject::createPointLight(float intensity, float radius, glm::vec3 color) {
-		SceneObject obj = SceneObject::createObject();
-		obj.color = color;
-		obj.transform.scale.x = radius;
-		obj.pointLight = std::make_unique<PointLightComponent>();
-		obj.pointLight->lightIntensity = intensity;
-		return obj;
+	Entity Scene::createObject() {
+		const Entity entity = create();
+		auto& link = emplace<TransformComponent>(entity).link_;
+		link = TransformChangeLink { changedTransforms_.get(), entity };
+		link.queue();
+		hierarchy_.add(entity);
+		return entity;
+	}
+
+	std::vector<Entity> Scene::createObjects(size_t count) {
+		std::vector<Entity> entities(count);
+		createBatch(entities.data(), count);
+		hierarchy_.reserve(count);
+		for (const Entity entity : entities) {
+			hierarchy_.add(entity);
+		}
+		auto* transforms = pool<TransformComponent>().emplaceBatch(entities.data(), count);
+		changedTransforms_->reserve(changedTransforms_->size() + count);
+		for (size_t i = 0; i < count; i++) {
+			transforms[i].link_ = TransformChangeLink { changedTransforms_.get(), entities[i] };
+			transforms[i].link_.queue();
+		}
+		return entities;
+	}
+
+	Entity Scene::createModelObject(std::shared_ptr<Model> model) {
+		const Entity entity = createObject();
+		emplace<BoundsComponent>(entity, model->bounds());
+		emplace<ModelComponent>(entity, std::move(model));
+		return entity;
+	}
+
+	Entity Scene::createPointLight(float intensity, float radius, glm::vec3 color) {
+		const Entity entity = createObject();
+		get<TransformComponent>(entity).setScale({ radius, 1.0F, 1.0F });
+		const auto& light = emplace<PointLightComponent>(entity, intensity, color);
+		emplace<BoundsComponent>(entity, Aabb {}, light.range());
+		return entity;
+	}
+
+	void Scene::destroy(Entity entity) {
+		if (const auto* bounds = tryGet<BoundsComponent>(entity); bounds != nullptr && bounds->proxy != Bvh::NULL_NODE) {
+			spatialIndex_.remove(bounds->proxy);
+		}
+		if (hierarchy_.contains(entity)) {
+			hierarchy_.remove(entity);
+		}
+		Registry::destroy(entity);
+	}
+
+	void Scene::setLightIntensity(Entity light, float intensity) {
+		auto& component = get<PointLightComponent>(light);
+		component.lightIntensity = intensity;
+		if (auto* bounds = tryGet<BoundsComponent>(light); bounds != nullptr && bounds->radius != component.range()) {
+			bounds->radius = component.range();
+			refitBounds_.push_back(light);
+		}
+	}
+
+	void Scene::updateTransforms() {
+		ENGINE_ZONE("Scene::updateTransforms");
+		auto& transform_pool = pool<TransformComponent>();
+		auto& transforms = transform_pool.components();
+		dirtyTransforms_.clear();
+		for (const Entity entity : *changedTransforms_) {
+			// skips entities destroyed after they were queued
+			if (auto* transform = transform_pool.tryGet(entity); transform != nullptr) {
+				transform->link_.clear();
+				hierarchy_.markDirty(entity);
+				if (transform->dirty_) {
+					dirtyTransforms_.push_back(static_cast<uint32_t>(transform - transforms.data()));
+				}
+			}
+		}
+		changedTransforms_->clear();
+		if (!dirtyTransforms_.empty()) {
+			updateTransformCaches(transforms);
+		}
+		hierarchy_.update(pool<TransformComponent>());
+		updateBounds();
+	}
+
+	void Scene::updateBounds() {
+		ENGINE_ZONE("Scene::updateBounds");
+		auto& bounds_pool = pool<BoundsComponent>();
+		for (const Entity entity : hierarchy_.changed()) {
+			if (auto* bounds = bounds_pool.tryGet(entity); bounds != nullptr) {
+				refit(entity, *bounds);
+			}
+		}
+		for (const Entity entity : refitBounds_) {
+			if (auto* bounds = bounds_pool.tryGet(entity); bounds != nullptr) {
+				refit(entity, *bounds);
+			}
+		}
+		refitBounds_.clear();
+		// bounds attached to an entity whose transform has not changed since
+		if (spatialIndex_.size() != bounds_pool.size()) {
+			each<BoundsComponent>([&](Entity entity, BoundsComponent& bounds) {
+				if (bounds.proxy == Bvh::NULL_NODE) {
+					refit(entity, bounds);
+				}
+			});
+		}
+	}
+
+	void Scene::refit(Entity entity, BoundsComponent& bounds) {
+		const glm::mat4& world = hierarchy_.world(entity);
+		const Aabb world_bounds = bounds.radius > 0.0F
+			? Aabb::fromCenter(glm::vec3(world[3]), glm::vec3(bounds.radius))
+			: bounds.local.transformed(world);
+		if (bounds.proxy == Bvh::NULL_NODE) {
+			bounds.proxy = spatialIndex_.insert(world_bounds, entity);
+		} else {
+			spatialIndex_.move(bounds.proxy, world_bounds);
+		}
+	}
+
+	void Scene::updateTransformCaches(std::vector<TransformComponent>& transforms) {
+		const size_t count = dirtyTransforms_.size();
+		transformBatch_.resize(count);
+		batchMatrices_.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			const auto& transform = transforms[dirtyTransforms_[i]];
+			transformBatch_.set(i, transform.translation_, transform.rotation_, transform.scale_);
+		}
+		// nothing on the render path reads normalMatrix(), see RenderSystem's ObjectData
+		computeTransforms(transformBatch_, batchMatrices_.data(), nullptr);
+		for (size_t i = 0; i < count; i++) {
+			const auto& transform = transforms[dirtyTransforms_[i]];
+			transform.matrix_ = batchMatrices_[i];
+			transform.dirty_ = false;
+			transform.normalDirty_ = true;
+		}
 	}
 
 }
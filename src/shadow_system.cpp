@@ -0,0 +1,468 @@
+#include "shadow_system.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "camera.hpp"
+#include "swap_chain.hpp"
+#include "cpu_profiler.hpp"
+
+namespace engine {
+
+	namespace {
+
+		struct ShadowPushConstants {
+			glm::mat4 modelViewProjection { 1.0F };
+		};
+
+		// cube face order +X, -X, +Y, -Y, +Z, -Z, matching the face selection in shadows.glsl
+		const std::array<glm::vec3, ShadowSystem::FACES> FACE_DIRECTIONS {
+			glm::vec3 { 1.0F, 0.0F, 0.0F }, glm::vec3 { -1.0F, 0.0F, 0.0F },
+			glm::vec3 { 0.0F, 1.0F, 0.0F }, glm::vec3 { 0.0F, -1.0F, 0.0F },
+			glm::vec3 { 0.0F, 0.0F, 1.0F }, glm::vec3 { 0.0F, 0.0F, -1.0F }
+		};
+		const std::array<glm::vec3, ShadowSystem::FACES> FACE_UPS {
+			glm::vec3 { 0.0F, -1.0F, 0.0F }, glm::vec3 { 0.0F, -1.0F, 0.0F },
+			glm::vec3 { 0.0F, 0.0F, 1.0F }, glm::vec3 { 0.0F, 0.0F, 1.0F },
+			glm::vec3 { 0.0F, -1.0F, 0.0F }, glm::vec3 { 0.0F, -1.0F, 0.0F }
+		};
+
+		// NOLINTBEGIN
+		uint64_t mix(uint64_t x) {
+			x += 0x9e3779b97f4a7c15ULL;
+			x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+			return x ^ (x >> 31);
+		}
+
+		uint64_t mix(Entity entity, uint32_t version) {
+			return mix((static_cast<uint64_t>(entity) << 32) | version);
+		}
+		// NOLINTEND
+
+		VkRect2D tileRect(uint32_t tile) {
+			const auto x = static_cast<int32_t>((tile % ShadowSystem::TILES_PER_ROW) * ShadowSystem::TILE_SIZE);
+			const auto y = static_cast<int32_t>((tile / ShadowSystem::TILES_PER_ROW) * ShadowSystem::TILE_SIZE);
+			return { { x, y }, { ShadowSystem::TILE_SIZE, ShadowSystem::TILE_SIZE } };
+		}
+
+		void transition(
+			VkCommandBuffer command_buf,
+			VkImage image,
+			VkImageLayout old_layout,
+			VkImageLayout new_layout,
+			VkPipelineStageFlags src_stage,
+			VkAccessFlags src_access,
+			VkPipelineStageFlags dst_stage,
+			VkAccessFlags dst_access
+		) {
+			VkImageMemoryBarrier barrier {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = old_layout;
+			barrier.newLayout = new_layout;
+			barrier.srcAccessMask = src_access;
+			barrier.dstAccessMask = dst_access;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+			vkCmdPipelineBarrier(command_buf, src_stage, dst_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		constexpr VkPipelineStageFlags DEPTH_TEST_STAGES = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		constexpr VkAccessFlags DEPTH_ACCESS = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	}
+
+	ShadowSystem::ShadowSystem(EngineDevice& device, PipelineFactory& pipelines) : device_ { device } {
+		depthFormat_ = device_.findSupportedFormat(
+			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+		);
+		createRenderPass();
+		createAtlases();
+		createSampler();
+		createPipelineLayout();
+		createPipeline(pipelines);
+
+		shadowDataBuffers_.resize(SwapChain::MAX_FRAMES);
+		for (auto& buffer : shadowDataBuffers_) {
+			buffer = std::make_unique<Buffer>(
+				device_,
+				sizeof(ShadowData),
+				1,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			buffer->map();
+		}
+		faces_.reserve(static_cast<size_t>(MAX_SHADOW_LIGHTS) * FACES);
+	}
+
+	ShadowSystem::~ShadowSystem() {
+		vkDestroyPipelineLayout(device_.device(), pipelineLayout_, nullptr);
+		vkDestroySampler(device_.device(), sampler_, nullptr);
+		for (auto& atlas : atlases_) {
+			vkDestroyFramebuffer(device_.device(), atlas.frameBuffer, nullptr);
+			vkDestroyImageView(device_.device(), atlas.view, nullptr);
+			vkDestroyImage(device_.device(), atlas.image, nullptr);
+			vkFreeMemory(device_.device(), atlas.memory, nullptr);
+		}
+		vkDestroyRenderPass(device_.device(), renderPass_, nullptr);
+	}
+
+	void ShadowSystem::createRenderPass() {
+		// tiles are cleared or composited individually, so the atlas is always loaded and kept
+		VkAttachmentDescription depth_attachment {};
+		depth_attachment.format = depthFormat_;
+		depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depth_attachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference depth_ref { 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+		VkSubpassDescription subpass {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 0;
+		subpass.pDepthStencilAttachment = &depth_ref;
+
+		VkRenderPassCreateInfo render_pass_info {};
+		render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		render_pass_info.attachmentCount = 1;
+		render_pass_info.pAttachments = &depth_attachment;
+		render_pass_info.subpassCount = 1;
+		render_pass_info.pSubpasses = &subpass;
+
+		if (vkCreateRenderPass(device_.device(), &render_pass_info, nullptr, &renderPass_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create shadow render pass");
+		}
+	}
+
+	void ShadowSystem::createAtlases() {
+		const std::array<VkImageUsageFlags, 2> usages {
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+		};
+		for (size_t i = 0; i < atlases_.size(); i++) {
+			auto& atlas = atlases_[i];
+			VkImageCreateInfo image_info {};
+			image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			image_info.imageType = VK_IMAGE_TYPE_2D;
+			image_info.extent.width = ATLAS_SIZE;
+			image_info.extent.height = ATLAS_SIZE;
+			image_info.extent.depth = 1;
+			image_info.mipLevels = 1;
+			image_info.arrayLayers = 1;
+			image_info.format = depthFormat_;
+			image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+			image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			image_info.usage = usages[i];
+			image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+			image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			image_info.flags = 0;
+			device_.createImageWithInfo(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, atlas.image, atlas.memory);
+
+			VkImageViewCreateInfo view_info {};
+			view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			view_info.image = atlas.image;
+			view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			view_info.format = depthFormat_;
+			view_info.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+			if (vkCreateImageView(device_.device(), &view_info, nullptr, &atlas.view) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create shadow atlas view");
+			}
+
+			VkFramebufferCreateInfo frame_buffer_info {};
+			frame_buffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			frame_buffer_info.renderPass = renderPass_;
+			frame_buffer_info.attachmentCount = 1;
+			frame_buffer_info.pAttachments = &atlas.view;
+			frame_buffer_info.width = ATLAS_SIZE;
+			frame_buffer_info.height = ATLAS_SIZE;
+			frame_buffer_info.layers = 1;
+			if (vkCreateFramebuffer(device_.device(), &frame_buffer_info, nullptr, &atlas.frameBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create shadow atlas framebuffer");
+			}
+		}
+
+		// start both atlases at the far plane, in the layouts render() expects between frames
+		auto* command_buf = device_.beginSingleTimeCommands();
+		const VkClearDepthStencilValue far_plane { 1.0F, 0 };
+		const VkImageSubresourceRange range { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+		for (auto& atlas : atlases_) {
+			transition(command_buf, atlas.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+			vkCmdClearDepthStencilImage(command_buf, atlas.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &far_plane, 1, &range);
+		}
+		transition(command_buf, atlases_[CACHED].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+		transition(command_buf, atlases_[SAMPLED].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+		device_.endSingleTimeCommands(command_buf);
+	}
+
+	void ShadowSystem::createSampler() {
+		// hardware depth comparison with bilinear filtering gives 2x2 PCF per lookup
+		VkSamplerCreateInfo sampler_info {};
+		sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		sampler_info.magFilter = VK_FILTER_LINEAR;
+		sampler_info.minFilter = VK_FILTER_LINEAR;
+		sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.compareEnable = VK_TRUE;
+		sampler_info.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+		sampler_info.maxLod = 0.0F;
+		sampler_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+		if (vkCreateSampler(device_.device(), &sampler_info, nullptr, &sampler_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create shadow sampler");
+		}
+	}
+
+	void ShadowSystem::createPipelineLayout() {
+		VkPushConstantRange push_constant_range {};
+		push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		push_constant_range.offset = 0;
+		push_constant_range.size = sizeof(ShadowPushConstants);
+
+		VkPipelineLayoutCreateInfo layout_create_info {};
+		layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layout_create_info.setLayoutCount = 0;
+		layout_create_info.pSetLayouts = nullptr;
+		layout_create_info.pushConstantRangeCount = 1;
+		layout_create_info.pPushConstantRanges = &push_constant_range;
+		if (vkCreatePipelineLayout(device_.device(), &layout_create_info, nullptr, &pipelineLayout_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout");
+		}
+	}
+
+	void ShadowSystem::createPipeline(PipelineFactory& pipelines) {
+		assert(pipelineLayout_ && "Cannot create pipeline before pipeline layout"); // NOLINT
+
+		PipelineConfigInfo pipeline_config = Pipeline::defaultPipelineConfigInfo();
+		pipeline_config.renderPass = renderPass_;
+		pipeline_config.pipelineLayout = pipelineLayout_;
+		// depth only: positions in, no color attachments
+		pipeline_config.attributeDescriptions = { Model::Vertex::getAttributeDescriptions()[0] };
+		pipeline_config.colorBlendInfo.attachmentCount = 0;
+		pipeline_config.colorBlendInfo.pAttachments = nullptr;
+		// slope scaled bias against acne on surfaces facing away from the light
+		pipeline_config.rasterizationInfo.depthBiasEnable = VK_TRUE;
+		pipeline_config.rasterizationInfo.depthBiasConstantFactor = 1.25F; // NOLINT
+		pipeline_config.rasterizationInfo.depthBiasSlopeFactor = 1.75F; // NOLINT
+		pipeline_ = pipelines.create("../shader/build/shadow.vert.spv", "../shader/build/shadow.frag.spv", pipeline_config);
+	}
+
+	uint32_t ShadowSystem::acquireSlot(Entity light) {
+		if (auto it = std::find_if(slots_.begin(), slots_.end(), [&](const Slot& slot) { return slot.light == light; }); it != slots_.end()) {
+			it->lastUsedFrame = frame_;
+			return static_cast<uint32_t>(it - slots_.begin());
+		}
+		// free slots were never used, so they sort first
+		auto lru = std::min_element(slots_.begin(), slots_.end(), [](const Slot& a, const Slot& b) { return a.lastUsedFrame < b.lastUsedFrame; });
+		assert(lru->lastUsedFrame != frame_ && "More shadowed lights than slots"); // NOLINT
+		*lru = Slot {};
+		lru->light = light;
+		lru->lastUsedFrame = frame_;
+		return static_cast<uint32_t>(lru - slots_.begin());
+	}
+
+	void ShadowSystem::update(FrameInfo& frame_info, const std::vector<Entity>& lights) {
+		ENGINE_ZONE("ShadowSystem::update");
+		auto& scene = frame_info.scene;
+		frame_++;
+		faces_.clear();
+		staticCasters_.clear();
+		dynamicCasters_.clear();
+
+		// the lights nearest to the camera get shadows
+		const glm::vec3 camera_position = frame_info.camera.inverseView()[3];
+		candidates_.resize(lights.size());
+		for (uint32_t i = 0; i < candidates_.size(); i++) {
+			candidates_[i] = i;
+		}
+		if (candidates_.size() > MAX_SHADOW_LIGHTS) {
+			distances_.resize(lights.size());
+			for (size_t i = 0; i < lights.size(); i++) {
+				const glm::vec3 offset = glm::vec3(scene.worldMatrix(lights[i])[3]) - camera_position;
+				distances_[i] = glm::dot(offset, offset);
+			}
+			std::partial_sort(candidates_.begin(), candidates_.begin() + MAX_SHADOW_LIGHTS, candidates_.end(), [&](uint32_t a, uint32_t b) {
+				return distances_[a] < distances_[b];
+			});
+			candidates_.resize(MAX_SHADOW_LIGHTS);
+		}
+
+		// the buffer may be write combined, so it is only ever written
+		auto& shadow_buffer = *shadowDataBuffers_[frame_info.frameIdx];
+		auto* data = static_cast<ShadowData*>(shadow_buffer.mappedMemory());
+		std::fill_n(data->lightSlot.begin(), std::min<size_t>(lights.size(), ClusteredLighting::MAX_LIGHTS), -1);
+
+		for (const uint32_t light_idx : candidates_) {
+			const Entity light = lights[light_idx];
+			const uint32_t slot_idx = acquireSlot(light);
+			auto& slot = slots_[slot_idx];
+			data->lightSlot[light_idx] = static_cast<int32_t>(slot_idx);
+
+			const glm::vec3 position = scene.worldMatrix(light)[3];
+			const float range = scene.get<PointLightComponent>(light).range();
+			uint32_t range_bits = 0;
+			std::memcpy(&range_bits, &range, sizeof(range));
+			const uint64_t light_signature = mix(light, scene.worldVersion(light)) ^ mix(range_bits);
+
+			for (uint32_t face = 0; face < FACES; face++) {
+				Camera face_camera {};
+				face_camera.viewDirection(position, FACE_DIRECTIONS[face], FACE_UPS[face]);
+				face_camera.perspectiveProjection(glm::half_pi<float>(), 1.0F, NEAR_PLANE, range);
+
+				FaceWork work {};
+				work.tile = slot_idx * FACES + face;
+				work.viewProjection = face_camera.projection() * face_camera.view();
+				data->faceViewProjection[work.tile] = work.viewProjection;
+				work.staticBegin = static_cast<uint32_t>(staticCasters_.size());
+				work.dynamicBegin = static_cast<uint32_t>(dynamicCasters_.size());
+
+				// order independent so the BVH traversal order does not matter
+				uint64_t static_sum = 0;
+				scene.spatialIndex().query(face_camera.frustum(), [&](Entity entity) {
+					if (!scene.has<ModelComponent>(entity)) {
+						return;
+					}
+					if (scene.has<DynamicComponent>(entity)) {
+						dynamicCasters_.push_back(entity);
+						return;
+					}
+					staticCasters_.push_back(entity);
+					static_sum += mix(entity, scene.worldVersion(entity));
+				});
+				work.staticEnd = static_cast<uint32_t>(staticCasters_.size());
+				work.dynamicEnd = static_cast<uint32_t>(dynamicCasters_.size());
+
+				const uint64_t signature = mix(static_sum + light_signature + (work.staticEnd - work.staticBegin)) | 1U;
+				work.renderStatic = signature != slot.staticSignature[face];
+				const bool has_dynamic = work.dynamicEnd > work.dynamicBegin;
+				// a face that lost its dynamic casters still needs the static depth copied back once
+				const bool composite = work.renderStatic || has_dynamic || slot.hadDynamic[face];
+				slot.staticSignature[face] = signature;
+				slot.hadDynamic[face] = has_dynamic;
+
+				if (!work.renderStatic) {
+					staticCasters_.resize(work.staticBegin);
+					work.staticEnd = work.staticBegin;
+				}
+				if (composite) {
+					faces_.push_back(work);
+				}
+			}
+		}
+		shadow_buffer.flush();
+	}
+
+	void ShadowSystem::drawCasters(FrameInfo& frame_info, const FaceWork& face, const std::vector<Entity>& casters, uint32_t begin, uint32_t end) {
+		auto& scene = frame_info.scene;
+		const VkRect2D rect = tileRect(face.tile);
+		VkViewport viewport {};
+		viewport.x = static_cast<float>(rect.offset.x);
+		viewport.y = static_cast<float>(rect.offset.y);
+		viewport.width = static_cast<float>(rect.extent.width);
+		viewport.height = static_cast<float>(rect.extent.height);
+		viewport.minDepth = 0.0F;
+		viewport.maxDepth = 1.0F;
+		vkCmdSetViewport(frame_info.cmdBuf, 0, 1, &viewport);
+		vkCmdSetScissor(frame_info.cmdBuf, 0, 1, &rect);
+
+		for (uint32_t i = begin; i < end; i++) {
+			const Entity entity = casters[i];
+			ShadowPushConstants push {};
+			push.modelViewProjection = face.viewProjection * scene.worldMatrix(entity);
+			vkCmdPushConstants(frame_info.cmdBuf, pipelineLayout_, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ShadowPushConstants), &push);
+			auto& model = scene.get<ModelComponent>(entity).model;
+			model->bind(frame_info.cmdBuf);
+			model->draw(frame_info.cmdBuf);
+		}
+	}
+
+	void ShadowSystem::render(FrameInfo& frame_info) {
+		ENGINE_ZONE("ShadowSystem::render");
+		renderedViews_ = 0;
+		if (faces_.empty()) {
+			return;
+		}
+		auto* command_buf = frame_info.cmdBuf;
+		auto begin_pass = [&](const AtlasImage& atlas) {
+			VkRenderPassBeginInfo begin_info {};
+			begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			begin_info.renderPass = renderPass_;
+			begin_info.framebuffer = atlas.frameBuffer;
+			begin_info.renderArea = { { 0, 0 }, { ATLAS_SIZE, ATLAS_SIZE } };
+			vkCmdBeginRenderPass(command_buf, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+			pipeline_->bind(command_buf);
+		};
+
+		// re-render the invalidated static tiles into the cache
+		const bool any_static = std::any_of(faces_.begin(), faces_.end(), [](const FaceWork& face) { return face.renderStatic; });
+		if (any_static) {
+			const auto& cached = atlases_[CACHED];
+			transition(command_buf, cached.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, 0, DEPTH_TEST_STAGES, DEPTH_ACCESS);
+			begin_pass(cached);
+			for (const auto& face : faces_) {
+				if (!face.renderStatic) {
+					continue;
+				}
+				VkClearAttachment clear {};
+				clear.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+				clear.clearValue.depthStencil = { 1.0F, 0 };
+				const VkClearRect clear_rect { tileRect(face.tile), 0, 1 };
+				vkCmdClearAttachments(command_buf, 1, &clear, 1, &clear_rect);
+				drawCasters(frame_info, face, staticCasters_, face.staticBegin, face.staticEnd);
+				renderedViews_++;
+			}
+			vkCmdEndRenderPass(command_buf);
+			transition(command_buf, cached.image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+		}
+
+		// restore the cached static depth of every touched tile, then draw the dynamic casters over it
+		const auto& sampled = atlases_[SAMPLED];
+		copyRegions_.clear();
+		for (const auto& face : faces_) {
+			const VkRect2D rect = tileRect(face.tile);
+			VkImageCopy region {};
+			region.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+			region.srcOffset = { rect.offset.x, rect.offset.y, 0 };
+			region.dstSubresource = region.srcSubresource;
+			region.dstOffset = region.srcOffset;
+			region.extent = { rect.extent.width, rect.extent.height, 1 };
+			copyRegions_.push_back(region);
+		}
+		transition(command_buf, sampled.image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+		vkCmdCopyImage(command_buf, atlases_[CACHED].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, sampled.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(copyRegions_.size()), copyRegions_.data());
+		transition(command_buf, sampled.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, DEPTH_TEST_STAGES, DEPTH_ACCESS);
+
+		begin_pass(sampled);
+		for (const auto& face : faces_) {
+			if (face.dynamicEnd > face.dynamicBegin) {
+				drawCasters(frame_info, face, dynamicCasters_, face.dynamicBegin, face.dynamicEnd);
+				renderedViews_++;
+			}
+		}
+		vkCmdEndRenderPass(command_buf);
+		transition(command_buf, sampled.image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	}
+
+}
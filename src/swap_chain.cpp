@@ -1,6 +1,7 @@
 #include "swap_chain.hpp"
 
 #include <array>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -8,6 +9,8 @@
 #include <set>
 #include <stdexcept>
 
+#include "cpu_profiler.hpp"
+
 namespace engine {
 	SwapChain::SwapChain(EngineDevice& device, VkExtent2D extent) : device_{ device }, windowExtent_{ extent } {
 		init();
@@ -28,15 +31,31 @@ namespace engine {
 			vkDestroySwapchainKHR(device_.device(), swapChain_, nullptr);
 			swapChain_ = nullptr;
 		}
+		for (size_t i = 0; i < offscreenImageMemories_.size(); i++) {
+			vkDestroyImage(device_.device(), swapChainImages_[i], nullptr);
+			vkFreeMemory(device_.device(), offscreenImageMemories_[i], nullptr);
+		}
 		for (size_t i = 0; i < depthImages_.size(); i++) {
 			vkDestroyImageView(device_.device(), depthImageViews_[i], nullptr);
 			vkDestroyImage(device_.device(), depthImages_[i], nullptr);
 			vkFreeMemory(device_.device(), depthImageMemories_[i], nullptr);
 		}
+		for (size_t i = 0; i < albedoImages_.size(); i++) {
+			vkDestroyImageView(device_.device(), albedoImageViews_[i], nullptr);
+			vkDestroyImage(device_.device(), albedoImages_[i], nullptr);
+			vkFreeMemory(device_.device(), albedoImageMemories_[i], nullptr);
+			vkDestroyImageView(device_.device(), normalImageViews_[i], nullptr);
+			vkDestroyImage(device_.device(), normalImages_[i], nullptr);
+			vkFreeMemory(device_.device(), normalImageMemories_[i], nullptr);
+		}
 		for (auto frame_buffer : swapChainFrameBuffers_) {
 			vkDestroyFramebuffer(device_.device(), frame_buffer, nullptr);
 		}
+		for (auto frame_buffer : deferredFrameBuffers_) {
+			vkDestroyFramebuffer(device_.device(), frame_buffer, nullptr);
+		}
 		vkDestroyRenderPass(device_.device(), renderPass_, nullptr);
+		vkDestroyRenderPass(device_.device(), deferredRenderPass_, nullptr);
 		for (size_t i = 0; i < MAX_FRAMES; i++) {
 			vkDestroySemaphore(device_.device(), renderFinishedSemaphores_[i], nullptr);
 			vkDestroySemaphore(device_.device(), imageAvailableSemaphores_[i], nullptr);
@@ -45,7 +64,18 @@ namespace engine {
 	}
 
 	VkResult SwapChain::acquireNextImage(uint32_t *image_idx) {
-		vkWaitForFences(device_.device(), 1, &inFlightFences_[currentFrame_], VK_TRUE, UINT64_MAX);
+		ENGINE_ZONE("SwapChain::acquireNextImage");
+		{
+			ENGINE_ZONE("wait frame fence");
+			const auto wait_start = std::chrono::steady_clock::now();
+			vkWaitForFences(device_.device(), 1, &inFlightFences_[currentFrame_], VK_TRUE, UINT64_MAX);
+			fenceWaitMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wait_start).count();
+		}
+		if (isOffscreen()) {
+			// the frame's own image is free once its fence has signaled
+			*image_idx = static_cast<uint32_t>(currentFrame_);
+			return VK_SUCCESS;
+		}
 		auto res = vkAcquireNextImageKHR(
 			device_.device(),
 			swapChain_,
@@ -57,8 +87,12 @@ namespace engine {
 	}
 
 	VkResult SwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *image_idx) {
+		ENGINE_ZONE("SwapChain::submitCommandBuffers");
 		if (imagesInFlight_[*image_idx] != VK_NULL_HANDLE) {
+			ENGINE_ZONE("wait image fence");
+			const auto wait_start = std::chrono::steady_clock::now();
 			vkWaitForFences(device_.device(), 1, &imagesInFlight_[*image_idx], VK_TRUE, UINT64_MAX);
+			fenceWaitMs_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wait_start).count();
 		}
 		imagesInFlight_[*image_idx] = inFlightFences_[currentFrame_];
 		VkSubmitInfo submit_info {};
@@ -74,10 +108,21 @@ namespace engine {
 		VkSemaphore signal_semaphores[] = { renderFinishedSemaphores_[currentFrame_] };
 		submit_info.signalSemaphoreCount = 1;
 		submit_info.pSignalSemaphores = signal_semaphores;
+		if (isOffscreen()) {
+			submit_info.waitSemaphoreCount = 0;
+			submit_info.signalSemaphoreCount = 0;
+		}
 
 		vkResetFences(device_.device(), 1, &inFlightFences_[currentFrame_]);
-		if (vkQueueSubmit(device_.graphicsQueue(), 1, &submit_info, inFlightFences_[currentFrame_]) != VK_SUCCESS) {
-			throw std::runtime_error("failed to submit draw command buffer");
+		{
+			ENGINE_ZONE("vkQueueSubmit");
+			if (vkQueueSubmit(device_.graphicsQueue(), 1, &submit_info, inFlightFences_[currentFrame_]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to submit draw command buffer");
+			}
+		}
+		if (isOffscreen()) {
+			currentFrame_ = (currentFrame_ + 1) % MAX_FRAMES;
+			return VK_SUCCESS;
 		}
 
 		VkPresentInfoKHR present_info {};
@@ -90,7 +135,11 @@ namespace engine {
 		present_info.pSwapchains = swap_chains;
 		present_info.pImageIndices = image_idx;
 
-		auto res = vkQueuePresentKHR(device_.presentQueue(), &present_info);
+		VkResult res = VK_SUCCESS;
+		{
+			ENGINE_ZONE("vkQueuePresentKHR");
+			res = vkQueuePresentKHR(device_.presentQueue(), &present_info);
+		}
 		currentFrame_ = (currentFrame_ + 1) % MAX_FRAMES;
 		return res;
 	}
@@ -144,6 +193,35 @@ namespace engine {
 		swapChainExtent_ = extent;
 	}
 
+	void SwapChain::createOffscreenImages() {
+		swapChainImageFormat_ = OFFSCREEN_FORMAT;
+		swapChainExtent_ = windowExtent_;
+		swapChainImages_.resize(MAX_FRAMES);
+		offscreenImageMemories_.resize(MAX_FRAMES);
+		for (size_t i = 0; i < MAX_FRAMES; i++) {
+			VkImageCreateInfo image_info {};
+			image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			image_info.imageType = VK_IMAGE_TYPE_2D;
+			image_info.extent.width = swapChainExtent_.width;
+			image_info.extent.height = swapChainExtent_.height;
+			image_info.extent.depth = 1;
+			image_info.mipLevels = 1;
+			image_info.arrayLayers = 1;
+			image_info.format = swapChainImageFormat_;
+			image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+			image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+			image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			image_info.flags = 0;
+			device_.createImageWithInfo(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapChainImages_[i], offscreenImageMemories_[i]);
+		}
+	}
+
+	VkImageLayout SwapChain::finalColorLayout() const {
+		return isOffscreen() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	}
+
 	void SwapChain::createImageViews() {
 		swapChainImageViews_.resize(swapChainImages_.size());
 		for (size_t i = 0; i < swapChainImages_.size(); i++) {
@@ -187,7 +265,7 @@ namespace engine {
 		color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		color_attachment.finalLayout = this->finalColorLayout();
 
 		VkAttachmentReference color_attachment_ref = {};
 		color_attachment_ref.attachment = 0;
@@ -225,6 +303,98 @@ namespace engine {
 		}
 	}
 
+	void SwapChain::createDeferredRenderPass() {
+		// 0: swap chain image, 1: depth, 2: albedo, 3: normal. The G-buffer is cleared and never
+		// stored, so a tiler keeps it on chip for both subpasses.
+		std::array<VkAttachmentDescription, 4> attachments {};
+		attachments[0].format = this->getSwapChainImageFormat();
+		attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachments[0].finalLayout = this->finalColorLayout();
+
+		attachments[1] = attachments[0];
+		attachments[1].format = this->findDepthFormat();
+		attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+		attachments[2] = attachments[1];
+		attachments[2].format = ALBEDO_FORMAT;
+		attachments[2].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		attachments[3] = attachments[2];
+		attachments[3].format = NORMAL_FORMAT;
+
+		const std::array<VkAttachmentReference, 2> g_buffer_refs {{
+			{ 2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+			{ 3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL }
+		}};
+		const VkAttachmentReference depth_write_ref { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+		// input attachment order matches input_attachment_index in deferred_lighting.frag
+		const std::array<VkAttachmentReference, 3> input_refs {{
+			{ 2, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+			{ 3, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+			{ 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL }
+		}};
+		const VkAttachmentReference color_ref { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		// depth stays bound read only so light billboards can still be depth tested
+		const VkAttachmentReference depth_read_ref { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+
+		std::array<VkSubpassDescription, 2> subpasses {};
+		subpasses[GEOMETRY_SUBPASS].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpasses[GEOMETRY_SUBPASS].colorAttachmentCount = static_cast<uint32_t>(g_buffer_refs.size());
+		subpasses[GEOMETRY_SUBPASS].pColorAttachments = g_buffer_refs.data();
+		subpasses[GEOMETRY_SUBPASS].pDepthStencilAttachment = &depth_write_ref;
+
+		subpasses[LIGHTING_SUBPASS].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpasses[LIGHTING_SUBPASS].inputAttachmentCount = static_cast<uint32_t>(input_refs.size());
+		subpasses[LIGHTING_SUBPASS].pInputAttachments = input_refs.data();
+		subpasses[LIGHTING_SUBPASS].colorAttachmentCount = 1;
+		subpasses[LIGHTING_SUBPASS].pColorAttachments = &color_ref;
+		subpasses[LIGHTING_SUBPASS].pDepthStencilAttachment = &depth_read_ref;
+
+		std::array<VkSubpassDependency, 3> dependencies {};
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = GEOMETRY_SUBPASS;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].srcAccessMask = 0;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		// the swap chain image is first touched by the lighting subpass and must wait for acquire
+		dependencies[1].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].dstSubpass = LIGHTING_SUBPASS;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].srcAccessMask = 0;
+		dependencies[1].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+		// by region: each pixel only reads its own G-buffer texel
+		dependencies[2].srcSubpass = GEOMETRY_SUBPASS;
+		dependencies[2].dstSubpass = LIGHTING_SUBPASS;
+		dependencies[2].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[2].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[2].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[2].dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+		dependencies[2].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+		VkRenderPassCreateInfo render_pass_info = {};
+		render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		render_pass_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+		render_pass_info.pAttachments = attachments.data();
+		render_pass_info.subpassCount = static_cast<uint32_t>(subpasses.size());
+		render_pass_info.pSubpasses = subpasses.data();
+		render_pass_info.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		render_pass_info.pDependencies = dependencies.data();
+
+		if (vkCreateRenderPass(device_.device(), &render_pass_info, nullptr, &deferredRenderPass_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create deferred render pass");
+		}
+	}
+
 	void SwapChain::createFrameBuffers() {
 		swapChainFrameBuffers_.resize(this->imageCount());
 		for (size_t i = 0; i < this->imageCount(); i++) {
@@ -243,6 +413,24 @@ namespace engine {
 				throw std::runtime_error("failed to create frame buffer");
 			}
 		}
+
+		deferredFrameBuffers_.resize(this->imageCount());
+		for (size_t i = 0; i < this->imageCount(); i++) {
+			std::array<VkImageView, 4> attachments = { swapChainImageViews_[i], depthImageViews_[i], albedoImageViews_[i], normalImageViews_[i] };
+			auto swap_chain_extent = this->getSwapChainExtent();
+			VkFramebufferCreateInfo frame_buffer_info {};
+			frame_buffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			frame_buffer_info.renderPass = deferredRenderPass_;
+			frame_buffer_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+			frame_buffer_info.pAttachments = attachments.data();
+			frame_buffer_info.width = swap_chain_extent.width;
+			frame_buffer_info.height = swap_chain_extent.height;
+			frame_buffer_info.layers = 1;
+
+			if (vkCreateFramebuffer(device_.device(), &frame_buffer_info, nullptr, &deferredFrameBuffers_[i]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create frame buffer");
+			}
+		}
 	}
 
 	void SwapChain::createDepthResources() {
@@ -267,7 +455,7 @@ namespace engine {
 			image_info.format = depth_format;
 			image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
 			image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			image_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			image_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
 			image_info.samples = VK_SAMPLE_COUNT_1_BIT;
 			image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			image_info.flags = 0;
@@ -290,6 +478,55 @@ namespace engine {
 		}
 	}
 
+	void SwapChain::createGBufferResources() {
+		albedoImages_.resize(this->imageCount());
+		albedoImageMemories_.resize(this->imageCount());
+		albedoImageViews_.resize(this->imageCount());
+		normalImages_.resize(this->imageCount());
+		normalImageMemories_.resize(this->imageCount());
+		normalImageViews_.resize(this->imageCount());
+		for (size_t i = 0; i < this->imageCount(); i++) {
+			createGBufferAttachment(ALBEDO_FORMAT, albedoImages_[i], albedoImageMemories_[i], albedoImageViews_[i]);
+			createGBufferAttachment(NORMAL_FORMAT, normalImages_[i], normalImageMemories_[i], normalImageViews_[i]);
+		}
+	}
+
+	void SwapChain::createGBufferAttachment(VkFormat format, VkImage& image, VkDeviceMemory& memory, VkImageView& view) {
+		auto swap_chain_extent = this->getSwapChainExtent();
+		VkImageCreateInfo image_info {};
+		image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		image_info.imageType = VK_IMAGE_TYPE_2D;
+		image_info.extent.width = swap_chain_extent.width;
+		image_info.extent.height = swap_chain_extent.height;
+		image_info.extent.depth = 1;
+		image_info.mipLevels = 1;
+		image_info.arrayLayers = 1;
+		image_info.format = format;
+		image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+		image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+		image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		image_info.flags = 0;
+
+		// lazily allocated memory lets tile based GPUs skip backing the G-buffer entirely
+		device_.createImageWithInfo(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+		VkImageViewCreateInfo view_info {};
+		view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		view_info.image = image;
+		view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		view_info.format = format;
+		view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		view_info.subresourceRange.baseMipLevel = 0;
+		view_info.subresourceRange.levelCount = 1;
+		view_info.subresourceRange.baseArrayLayer = 0;
+		view_info.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(device_.device(), &view_info, nullptr, &view) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create texture image view");
+		}
+	}
+
 	void SwapChain::createSyncObjects() {
 		imageAvailableSemaphores_.resize(MAX_FRAMES);
 		renderFinishedSemaphores_.resize(MAX_FRAMES);
@@ -347,10 +584,16 @@ namespace engine {
 	}
 
 	void SwapChain::init() {
-		createSwapChain();
+		if (isOffscreen()) {
+			createOffscreenImages();
+		} else {
+			createSwapChain();
+		}
 		createImageViews();
 		createRenderPass();
+		createDeferredRenderPass();
 		createDepthResources();
+		createGBufferResources();
 		createFrameBuffers();
 		createSyncObjects();
 	}
@@ -0,0 +1,319 @@
+#include "telemetry.hpp"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "cpu_profiler.hpp"
+
+namespace engine {
+
+	namespace {
+
+		// how long the export thread blocks at a time, bounds how late shutdown notices
+		const int POLL_MS = 100;
+		const int LISTEN_BACKLOG = 8;
+		const size_t REQUEST_SIZE = 1024;
+#ifdef MSG_NOSIGNAL
+		const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+		const int SEND_FLAGS = 0;
+#endif
+
+		void accumulate(FrameCounters& total, const FrameCounters& frame) {
+			total.drawCalls += frame.drawCalls;
+			total.triangles += frame.triangles;
+			total.pipelineBinds += frame.pipelineBinds;
+			total.bufferWrites += frame.bufferWrites;
+			total.bytesWritten += frame.bytesWritten;
+			total.bufferCopies += frame.bufferCopies;
+			total.bytesCopied += frame.bytesCopied;
+			total.modelUploads += frame.modelUploads;
+			total.swapChainRecreations += frame.swapChainRecreations;
+		}
+
+		// exact for integers up to 2^53, which covers every counter
+		void writeValue(std::ostream& out, double value) {
+			std::array<char, 32> text {}; // NOLINT
+			std::snprintf(text.data(), text.size(), "%.15g", value);
+			out << text.data();
+		}
+
+		void writeLabel(std::ostream& out, const MetricLabel& label) {
+			out << label.name << "=\"";
+			if (label.text != nullptr) {
+				out << label.text;
+			} else {
+				out << label.number;
+			}
+			out << "\"";
+		}
+
+		void sendAll(int socket, const std::string& data) {
+			size_t sent = 0;
+			while (sent < data.size()) {
+				const ssize_t written = send(socket, data.data() + sent, data.size() - sent, SEND_FLAGS); // NOLINT
+				if (written <= 0) {
+					return;
+				}
+				sent += static_cast<size_t>(written);
+			}
+		}
+
+	}
+
+	Telemetry::Telemetry(TelemetryOptions options) : options_ { std::move(options) } {
+		if (!options_.socketPath.empty()) {
+			openSocket();
+		}
+		if (!options_.filePath.empty()) {
+			std::error_code error {};
+			const auto size = std::filesystem::file_size(options_.filePath, error);
+			fileBytes_ = error ? 0 : size;
+		}
+		exporter_ = std::thread([this] { exportLoop(); });
+	}
+
+	Telemetry::~Telemetry() {
+		stopping_.store(true, std::memory_order_release);
+		exporter_.join();
+		if (listenFd_ >= 0) {
+			close(listenFd_);
+			unlink(options_.socketPath.c_str());
+		}
+	}
+
+	void Telemetry::addSource(Source source) {
+		sources_.push_back(std::move(source));
+	}
+
+	void Telemetry::recordFrame(const FrameStats& stats) {
+		ENGINE_ZONE("Telemetry::recordFrame");
+		frames_++;
+		accumulate(totals_, stats.counters);
+		allocations_ += stats.allocations;
+		intervalUploadBytes_ += stats.counters.bytesCopied + stats.counters.bytesWritten;
+		intervalFrameTimes_.record(stats.frameMs);
+		const auto now = std::chrono::steady_clock::now();
+		if (std::chrono::duration<double, std::milli>(now - lastPublish_).count() >= options_.intervalMs) {
+			publish(now);
+		}
+	}
+
+	void Telemetry::publish(std::chrono::steady_clock::time_point now) {
+		ENGINE_ZONE("Telemetry::publish");
+		auto& snapshot = snapshots_[back_];
+		auto& metrics = snapshot.metrics;
+		metrics.clear();
+		const double seconds = std::chrono::duration<double>(now - lastPublish_).count();
+
+		metrics.counter("engine_frames_total", "Frames rendered", static_cast<double>(frames_));
+		metrics.gauge("engine_frame_time_p50_ms", "Median frame time over the last interval", intervalFrameTimes_.percentileMs(0.50)); // NOLINT
+		metrics.gauge("engine_frame_time_p95_ms", "95th percentile frame time over the last interval", intervalFrameTimes_.percentileMs(0.95)); // NOLINT
+		metrics.gauge("engine_frame_time_p99_ms", "99th percentile frame time over the last interval", intervalFrameTimes_.percentileMs(0.99)); // NOLINT
+		metrics.gauge("engine_frame_time_max_ms", "Longest frame of the last interval", intervalFrameTimes_.maxMs());
+		metrics.counter("engine_draw_calls_total", "Draw calls recorded", static_cast<double>(totals_.drawCalls));
+		metrics.counter("engine_triangles_total", "Triangles submitted in draw calls", static_cast<double>(totals_.triangles));
+		metrics.counter("engine_pipeline_binds_total", "Pipelines bound", static_cast<double>(totals_.pipelineBinds));
+		metrics.counter("engine_buffer_written_bytes_total", "Bytes written by the host into mapped buffers", static_cast<double>(totals_.bytesWritten));
+		metrics.counter("engine_buffer_copied_bytes_total", "Bytes copied between buffers on the graphics queue", static_cast<double>(totals_.bytesCopied));
+		metrics.gauge("engine_upload_bytes_per_second", "Bytes written and copied into buffers per second over the last interval",
+			seconds > 0.0 ? static_cast<double>(intervalUploadBytes_) / seconds : 0.0);
+		metrics.counter("engine_model_uploads_total", "Models uploaded to the device", static_cast<double>(totals_.modelUploads));
+		metrics.counter("engine_swap_chain_recreations_total", "Swap chain recreations", static_cast<double>(totals_.swapChainRecreations));
+		metrics.counter("engine_frame_allocations_total", "Heap allocations on the frame loop's thread", static_cast<double>(allocations_));
+		for (const auto& source : sources_) {
+			source(metrics);
+		}
+
+		snapshot.sequence = ++sequence_;
+		snapshot.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		// the slot handed back is the one the exporter gave up, or this one's predecessor if it took none
+		back_ = shared_.exchange(back_ | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+
+		intervalFrameTimes_.reset();
+		intervalUploadBytes_ = 0;
+		lastPublish_ = now;
+	}
+
+	const Telemetry::Snapshot* Telemetry::takeLatest() {
+		if ((shared_.load(std::memory_order_acquire) & FRESH_BIT) != 0) {
+			front_ = shared_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+		}
+		const auto& snapshot = snapshots_[front_];
+		return snapshot.sequence == 0 ? nullptr : &snapshot;
+	}
+
+	void Telemetry::exportLoop() {
+		ENGINE_THREAD_NAME("telemetry");
+		uint64_t written_sequence = 0;
+		while (!stopping_.load(std::memory_order_acquire)) {
+			if (listenFd_ >= 0) {
+				pollfd listener { listenFd_, POLLIN, 0 };
+				if (poll(&listener, 1, POLL_MS) > 0 && (listener.revents & POLLIN) != 0) {
+					const int client = accept(listenFd_, nullptr, nullptr);
+					if (client >= 0) {
+						serve(client);
+						close(client);
+					}
+				}
+			} else {
+				std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+			}
+			if (options_.filePath.empty()) {
+				continue;
+			}
+			const Snapshot* snapshot = takeLatest();
+			if (snapshot != nullptr && snapshot->sequence != written_sequence) {
+				appendToFile(*snapshot);
+				written_sequence = snapshot->sequence;
+			}
+		}
+	}
+
+	void Telemetry::openSocket() {
+		const auto& path = options_.socketPath;
+		sockaddr_un address {};
+		address.sun_family = AF_UNIX;
+		if (path.size() >= sizeof(address.sun_path)) {
+			throw std::runtime_error("telemetry socket path is too long: " + path);
+		}
+		std::memcpy(address.sun_path, path.c_str(), path.size() + 1); // NOLINT
+		// left behind by a previous run that did not shut down
+		struct stat existing {};
+		if (lstat(path.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+			unlink(path.c_str());
+		}
+		listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listenFd_ < 0) {
+			throw std::runtime_error("failed to create telemetry socket");
+		}
+		if (bind(listenFd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listenFd_, LISTEN_BACKLOG) != 0) { // NOLINT
+			close(listenFd_);
+			listenFd_ = -1;
+			throw std::runtime_error("failed to bind telemetry socket " + path);
+		}
+	}
+
+	void Telemetry::serve(int client) {
+#ifdef SO_NOSIGPIPE
+		const int no_sigpipe = 1;
+		setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+		// clients that send nothing get the bare snapshot
+		std::array<char, REQUEST_SIZE> request {};
+		pollfd readable { client, POLLIN, 0 };
+		ssize_t received = 0;
+		if (poll(&readable, 1, POLL_MS) > 0) {
+			received = recv(client, request.data(), request.size(), 0);
+		}
+		const bool http = received >= 4 && std::strncmp(request.data(), "GET ", 4) == 0;
+
+		std::ostringstream body {};
+		if (const Snapshot* snapshot = takeLatest()) {
+			write(body, *snapshot);
+		}
+		std::string response = body.str();
+		if (http) {
+			const char* content_type = options_.format == TelemetryFormat::Json ? "application/json" : "text/plain; version=0.0.4";
+			response = "HTTP/1.0 200 OK\r\nContent-Type: " + std::string { content_type } + "\r\nContent-Length: "
+				+ std::to_string(response.size()) + "\r\nConnection: close\r\n\r\n" + response;
+		}
+		sendAll(client, response);
+	}
+
+	void Telemetry::appendToFile(const Snapshot& snapshot) {
+		std::ostringstream text {};
+		write(text, snapshot);
+		const std::string data = text.str();
+		if (fileBytes_ > 0 && fileBytes_ + data.size() > options_.maxFileBytes) {
+			std::error_code error {};
+			const auto& path = options_.filePath;
+			if (options_.rotatedFiles == 0) {
+				std::filesystem::remove(path, error);
+			} else {
+				for (uint32_t i = options_.rotatedFiles; i > 1; i--) {
+					std::filesystem::rename(path + "." + std::to_string(i - 1), path + "." + std::to_string(i), error);
+				}
+				std::filesystem::rename(path, path + ".1", error);
+			}
+			fileBytes_ = 0;
+		}
+		std::ofstream file(options_.filePath, std::ios::binary | std::ios::app);
+		if (!file.is_open()) {
+			return;
+		}
+		file << data;
+		fileBytes_ += data.size();
+	}
+
+	void Telemetry::write(std::ostream& out, const Snapshot& snapshot) const {
+		if (options_.format == TelemetryFormat::Json) {
+			writeJson(out, snapshot);
+		} else {
+			writePrometheus(out, snapshot);
+		}
+	}
+
+	void Telemetry::writePrometheus(std::ostream& out, const Snapshot& snapshot) {
+		out << "# snapshot " << snapshot.sequence << " at " << snapshot.timestampMs << " ms\n";
+		const auto& metrics = snapshot.metrics;
+		const char* previous = nullptr;
+		for (size_t i = 0; i < metrics.size(); i++) {
+			const auto& metric = metrics[i];
+			if (previous == nullptr || std::strcmp(previous, metric.name) != 0) {
+				out << "# HELP " << metric.name << " " << metric.help << "\n"
+					<< "# TYPE " << metric.name << " " << (metric.kind == MetricKind::Counter ? "counter" : "gauge") << "\n";
+				previous = metric.name;
+			}
+			out << metric.name;
+			if (metric.label.name != nullptr) {
+				out << "{";
+				writeLabel(out, metric.label);
+				out << "}";
+			}
+			out << " ";
+			writeValue(out, metric.value);
+			out << "\n";
+		}
+		if (metrics.dropped() > 0) {
+			out << "# " << metrics.dropped() << " metrics dropped past MetricsWriter::MAX_METRICS\n";
+		}
+	}
+
+	// one line per snapshot, so an appended file reads as JSON Lines
+	void Telemetry::writeJson(std::ostream& out, const Snapshot& snapshot) {
+		const auto& metrics = snapshot.metrics;
+		out << "{\"sequence\":" << snapshot.sequence << ",\"timestamp_ms\":" << snapshot.timestampMs
+			<< ",\"dropped\":" << metrics.dropped() << ",\"metrics\":[";
+		for (size_t i = 0; i < metrics.size(); i++) {
+			const auto& metric = metrics[i];
+			out << (i == 0 ? "" : ",") << "{\"name\":\"" << metric.name << "\",\"type\":\""
+				<< (metric.kind == MetricKind::Counter ? "counter" : "gauge") << "\"";
+			if (metric.label.name != nullptr) {
+				out << ",\"labels\":{\"";
+				out << metric.label.name << "\":\"";
+				if (metric.label.text != nullptr) {
+					out << metric.label.text;
+				} else {
+					out << metric.label.number;
+				}
+				out << "\"}";
+			}
+			out << ",\"value\":";
+			writeValue(out, metric.value);
+			out << "}";
+		}
+		out << "]}\n";
+	}
+
+}
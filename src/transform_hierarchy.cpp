@@ -0,0 +1,367 @@
+#include "transform_hierarchy.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "cpu_profiler.hpp"
+#include "scene_object.hpp"
+
+namespace engine {
+
+	// Threads that update the chunks of one update() at a time. The calling thread claims chunks too
+	// and returns once every chunk is done; the threads sleep between updates.
+	struct TransformHierarchy::Workers {
+		std::vector<std::thread> threads {};
+		std::mutex mutex {};
+		std::condition_variable chunksReady {};
+		std::condition_variable chunksDone {};
+		// the current update, set by run() under the mutex
+		TransformHierarchy* hierarchy = nullptr;
+		const ComponentPool<TransformComponent>* transforms = nullptr;
+		size_t chunkCount = 0;
+		size_t nextChunk = 0;
+		size_t unfinished = 0;
+		bool stopping = false;
+
+		explicit Workers(size_t count) {
+			threads.reserve(count);
+			for (size_t i = 0; i < count; i++) {
+				threads.emplace_back([this] { loop(); });
+			}
+		}
+
+		~Workers() {
+			{
+				const std::lock_guard<std::mutex> lock { mutex };
+				stopping = true;
+			}
+			chunksReady.notify_all();
+			for (auto& thread : threads) {
+				thread.join();
+			}
+		}
+
+		Workers(const Workers&) = delete;
+		Workers& operator=(const Workers&) = delete;
+		Workers(const Workers&&) = delete;
+		Workers&& operator=(const Workers&&) = delete;
+
+		void run(TransformHierarchy& owner, const ComponentPool<TransformComponent>& pool, size_t chunks) {
+			{
+				const std::lock_guard<std::mutex> lock { mutex };
+				hierarchy = &owner;
+				transforms = &pool;
+				chunkCount = chunks;
+				nextChunk = 0;
+				unfinished = chunks;
+			}
+			chunksReady.notify_all();
+			std::unique_lock<std::mutex> lock { mutex };
+			while (nextChunk < chunkCount) {
+				runChunk(lock);
+			}
+			chunksDone.wait(lock, [this] { return unfinished == 0; });
+		}
+
+		void loop() {
+			ENGINE_THREAD_NAME("transform worker");
+			std::unique_lock<std::mutex> lock { mutex };
+			while (true) {
+				chunksReady.wait(lock, [this] { return stopping || nextChunk < chunkCount; });
+				if (stopping) {
+					return;
+				}
+				runChunk(lock);
+			}
+		}
+
+		// claims the next chunk and updates it with the lock released
+		void runChunk(std::unique_lock<std::mutex>& lock) {
+			const size_t chunk = nextChunk++;
+			lock.unlock();
+			const auto& bounds = hierarchy->chunkBounds_;
+			hierarchy->updateSubtrees(*transforms, bounds[chunk], bounds[chunk + 1], hierarchy->chunkChanged_[chunk]);
+			lock.lock();
+			if (--unfinished == 0) {
+				chunksDone.notify_all();
+			}
+		}
+	};
+
+	TransformHierarchy::TransformHierarchy() = default;
+	TransformHierarchy::~TransformHierarchy() = default;
+	TransformHierarchy::TransformHierarchy(TransformHierarchy&&) noexcept = default;
+	TransformHierarchy& TransformHierarchy::operator=(TransformHierarchy&&) noexcept = default;
+
+	void TransformHierarchy::add(Entity entity) {
+		assert(!contains(entity) && "Entity is already in the hierarchy"); // NOLINT
+		const uint32_t index = entityIndex(entity);
+		if (index >= indexOf_.size()) {
+			indexOf_.resize(static_cast<size_t>(index) + 1, NULL_INDEX);
+			for (auto* array : { &parentOf_, &firstChild_, &lastChild_, &nextSibling_, &prevSibling_ }) {
+				array->resize(static_cast<size_t>(index) + 1, NULL_ENTITY);
+			}
+		}
+		// a new root goes after every existing subtree, which keeps the depth-first order valid
+		const auto idx = static_cast<uint32_t>(order_.size());
+		indexOf_[index] = idx;
+		parentOf_[index] = NULL_ENTITY;
+		firstChild_[index] = lastChild_[index] = NULL_ENTITY;
+		nextSibling_[index] = prevSibling_[index] = NULL_ENTITY;
+		order_.push_back(entity);
+		parentIdx_.push_back(NULL_INDEX);
+		subtreeEnd_.push_back(idx + 1);
+		world_.emplace_back(1.0F);
+		worldVersion_.push_back(0);
+		dirtyNodes_.push_back(entity);
+	}
+
+	void TransformHierarchy::reserve(size_t count) {
+		const size_t size = order_.size() + count;
+		for (auto* array : { &parentIdx_, &subtreeEnd_, &worldVersion_ }) {
+			array->reserve(size);
+		}
+		order_.reserve(size);
+		world_.reserve(size);
+		dirtyNodes_.reserve(dirtyNodes_.size() + count);
+	}
+
+	void TransformHierarchy::remove(Entity entity) {
+		assert(contains(entity) && "Entity is not in the hierarchy"); // NOLINT
+		const Entity grandparent = parentOf_[entityIndex(entity)];
+		unlink(entity);
+		Entity child = firstChild_[entityIndex(entity)];
+		while (child != NULL_ENTITY) {
+			const Entity next = nextSibling_[entityIndex(child)];
+			parentOf_[entityIndex(child)] = grandparent;
+			link(child, grandparent);
+			dirtyNodes_.push_back(child);
+			child = next;
+		}
+		// the stale slot stays in order_ until the next rebuild drops it
+		indexOf_[entityIndex(entity)] = NULL_INDEX;
+		parentOf_[entityIndex(entity)] = NULL_ENTITY;
+		firstChild_[entityIndex(entity)] = lastChild_[entityIndex(entity)] = NULL_ENTITY;
+		structureDirty_ = true;
+	}
+
+	void TransformHierarchy::setParent(Entity child, Entity parent) {
+		assert(contains(child) && "Entity is not in the hierarchy"); // NOLINT
+		assert((parent == NULL_ENTITY || contains(parent)) && "Parent is not in the hierarchy"); // NOLINT
+		if (parentOf_[entityIndex(child)] == parent) {
+			return;
+		}
+		assert(!isAncestor(child, parent) && "Parenting would create a cycle"); // NOLINT
+		unlink(child);
+		parentOf_[entityIndex(child)] = parent;
+		link(child, parent);
+		dirtyNodes_.push_back(child);
+		structureDirty_ = true;
+	}
+
+	void TransformHierarchy::markDirty(Entity entity) {
+		assert(contains(entity) && "Entity is not in the hierarchy"); // NOLINT
+		dirtyNodes_.push_back(entity);
+	}
+
+	Entity TransformHierarchy::parent(Entity entity) const {
+		assert(contains(entity) && "Entity is not in the hierarchy"); // NOLINT
+		return parentOf_[entityIndex(entity)];
+	}
+
+	bool TransformHierarchy::isAncestor(Entity ancestor, Entity entity) const {
+		for (Entity node = entity; node != NULL_ENTITY; node = parentOf_[entityIndex(node)]) {
+			if (node == ancestor) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void TransformHierarchy::link(Entity child, Entity parent) {
+		const uint32_t index = entityIndex(child);
+		nextSibling_[index] = prevSibling_[index] = NULL_ENTITY;
+		if (parent == NULL_ENTITY) {
+			return;
+		}
+		const Entity last = lastChild_[entityIndex(parent)];
+		prevSibling_[index] = last;
+		if (last == NULL_ENTITY) {
+			firstChild_[entityIndex(parent)] = child;
+		} else {
+			nextSibling_[entityIndex(last)] = child;
+		}
+		lastChild_[entityIndex(parent)] = child;
+	}
+
+	void TransformHierarchy::unlink(Entity child) {
+		const uint32_t index = entityIndex(child);
+		const Entity parent = parentOf_[index];
+		if (parent == NULL_ENTITY) {
+			return;
+		}
+		const Entity prev = prevSibling_[index];
+		const Entity next = nextSibling_[index];
+		if (prev == NULL_ENTITY) {
+			firstChild_[entityIndex(parent)] = next;
+		} else {
+			nextSibling_[entityIndex(prev)] = next;
+		}
+		if (next == NULL_ENTITY) {
+			lastChild_[entityIndex(parent)] = prev;
+		} else {
+			prevSibling_[entityIndex(next)] = prev;
+		}
+		nextSibling_[index] = prevSibling_[index] = NULL_ENTITY;
+	}
+
+	const glm::mat4& TransformHierarchy::world(Entity entity) const {
+		assert(contains(entity) && "Entity is not in the hierarchy"); // NOLINT
+		return world_[indexOf_[entityIndex(entity)]];
+	}
+
+	uint32_t TransformHierarchy::worldVersion(Entity entity) const {
+		assert(contains(entity) && "Entity is not in the hierarchy"); // NOLINT
+		return worldVersion_[indexOf_[entityIndex(entity)]];
+	}
+
+	// Re-sorts the nodes depth-first after parenting changes. Roots keep their previous relative order,
+	// children follow their child lists and the walk is iterative, so arbitrarily deep chains do not
+	// grow the stack.
+	void TransformHierarchy::rebuild() {
+		std::vector<Entity> roots {};
+		for (size_t i = 0; i < order_.size(); i++) {
+			const Entity entity = order_[i];
+			if (indexOf_[entityIndex(entity)] == i && parentOf_[entityIndex(entity)] == NULL_ENTITY) {
+				roots.push_back(entity);
+			}
+		}
+
+		std::vector<uint32_t> new_index(indexOf_.size(), NULL_INDEX);
+		std::vector<Entity> order {};
+		std::vector<uint32_t> parent_idx {};
+		std::vector<uint32_t> subtree_end {};
+		std::vector<glm::mat4> world {};
+		std::vector<uint32_t> world_version {};
+		for (auto* array : { &parent_idx, &subtree_end, &world_version }) {
+			array->reserve(order_.size());
+		}
+		order.reserve(order_.size());
+		world.reserve(order_.size());
+
+		for (const Entity root : roots) {
+			Entity entity = root;
+			bool done = false;
+			while (!done) {
+				const uint32_t old_idx = indexOf_[entityIndex(entity)];
+				new_index[entityIndex(entity)] = static_cast<uint32_t>(order.size());
+				order.push_back(entity);
+				parent_idx.push_back(parentOf_[entityIndex(entity)] == NULL_ENTITY ? NULL_INDEX : new_index[entityIndex(parentOf_[entityIndex(entity)])]);
+				subtree_end.push_back(0);
+				world.push_back(world_[old_idx]);
+				world_version.push_back(worldVersion_[old_idx]);
+
+				if (firstChild_[entityIndex(entity)] != NULL_ENTITY) {
+					entity = firstChild_[entityIndex(entity)];
+					continue;
+				}
+				// close this node and every ancestor whose last child it was
+				while (true) {
+					subtree_end[new_index[entityIndex(entity)]] = static_cast<uint32_t>(order.size());
+					if (entity == root) {
+						done = true;
+						break;
+					}
+					if (nextSibling_[entityIndex(entity)] != NULL_ENTITY) {
+						entity = nextSibling_[entityIndex(entity)];
+						break;
+					}
+					entity = parentOf_[entityIndex(entity)];
+				}
+			}
+		}
+
+		indexOf_ = std::move(new_index);
+		order_ = std::move(order);
+		parentIdx_ = std::move(parent_idx);
+		subtreeEnd_ = std::move(subtree_end);
+		world_ = std::move(world);
+		worldVersion_ = std::move(world_version);
+		structureDirty_ = false;
+	}
+
+	void TransformHierarchy::update(const ComponentPool<TransformComponent>& transforms) {
+		if (structureDirty_) {
+			rebuild();
+		}
+		changed_.clear();
+
+		// sort the marked nodes depth-first and drop those inside an earlier stale subtree
+		dirtyRoots_.clear();
+		for (const Entity entity : dirtyNodes_) {
+			if (contains(entity)) {
+				dirtyRoots_.push_back(indexOf_[entityIndex(entity)]);
+			}
+		}
+		dirtyNodes_.clear();
+		std::sort(dirtyRoots_.begin(), dirtyRoots_.end());
+		size_t roots = 0;
+		size_t count = 0;
+		for (const uint32_t idx : dirtyRoots_) {
+			if (roots > 0 && idx < subtreeEnd_[dirtyRoots_[roots - 1]]) {
+				continue;
+			}
+			dirtyRoots_[roots++] = idx;
+			count += subtreeEnd_[idx] - idx;
+		}
+		dirtyRoots_.resize(roots);
+
+		const size_t threads = workers_ != nullptr ? workers_->threads.size() + 1 : std::thread::hardware_concurrency();
+		if (count < PARALLEL_THRESHOLD || threads < 2) {
+			updateSubtrees(transforms, 0, roots, changed_);
+			return;
+		}
+
+		// cut the stale subtrees into chunks of roughly equal node counts
+		const size_t chunk = count / threads + 1;
+		chunkBounds_.clear();
+		chunkBounds_.push_back(0);
+		size_t nodes = 0;
+		for (size_t i = 0; i < roots; i++) {
+			nodes += subtreeEnd_[dirtyRoots_[i]] - dirtyRoots_[i];
+			if (i + 1 == roots || nodes >= chunk) {
+				chunkBounds_.push_back(i + 1);
+				nodes = 0;
+			}
+		}
+		const size_t chunks = chunkBounds_.size() - 1;
+		chunkChanged_.resize(std::max(chunkChanged_.size(), chunks));
+		for (size_t i = 0; i < chunks; i++) {
+			chunkChanged_[i].clear();
+		}
+		if (workers_ == nullptr) {
+			workers_ = std::make_unique<Workers>(threads - 1);
+		}
+		workers_->run(*this, transforms, chunks);
+		for (size_t i = 0; i < chunks; i++) {
+			changed_.insert(changed_.end(), chunkChanged_[i].begin(), chunkChanged_[i].end());
+		}
+	}
+
+	void TransformHierarchy::updateSubtrees(const ComponentPool<TransformComponent>& transforms, size_t first, size_t last, std::vector<Entity>& changed) {
+		for (size_t root = first; root < last; root++) {
+			// a parent outside the subtree is not stale, so its world matrix is current
+			const size_t subtree_end = subtreeEnd_[dirtyRoots_[root]];
+			for (size_t node = dirtyRoots_[root]; node < subtree_end; node++) {
+				const uint32_t parent = parentIdx_[node];
+				const glm::mat4& local = transforms.get(order_[node]).mat4();
+				world_[node] = parent == NULL_INDEX ? local : world_[parent] * local;
+				worldVersion_[node]++;
+				changed.push_back(order_[node]);
+			}
+		}
+	}
+
+}
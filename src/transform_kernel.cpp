@@ -0,0 +1,182 @@
+#include "transform_kernel.hpp"
+
+#include <cassert>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ENGINE_TRANSFORM_KERNEL_AVX2
+#include <immintrin.h>
+#endif
+
+namespace engine {
+
+	void TransformArrays::resize(size_t count) {
+		for (auto* array : { &translationX, &translationY, &translationZ, &rotationX, &rotationY, &rotationZ, &scaleX, &scaleY, &scaleZ }) {
+			array->resize(count);
+		}
+	}
+
+	void TransformArrays::set(size_t idx, const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale) {
+		translationX[idx] = translation.x;
+		translationY[idx] = translation.y;
+		translationZ[idx] = translation.z;
+		rotationX[idx] = rotation.x;
+		rotationY[idx] = rotation.y;
+		rotationZ[idx] = rotation.z;
+		scaleX[idx] = scale.x;
+		scaleY[idx] = scale.y;
+		scaleZ[idx] = scale.z;
+	}
+
+	namespace {
+
+		// NOLINTBEGIN
+		// same Tait-Bryan YXZ expansion as TransformComponent::updateMatrices
+		void computeScalar(const TransformArrays& t, size_t begin, size_t end, glm::mat4* model_matrices, glm::mat3* normal_matrices) {
+			for (size_t i = begin; i < end; i++) {
+				const float c3 = std::cos(t.rotationZ[i]);
+				const float s3 = std::sin(t.rotationZ[i]);
+				const float c2 = std::cos(t.rotationX[i]);
+				const float s2 = std::sin(t.rotationX[i]);
+				const float c1 = std::cos(t.rotationY[i]);
+				const float s1 = std::sin(t.rotationY[i]);
+				const glm::vec3 r0 { c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1 };
+				const glm::vec3 r1 { c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3 };
+				const glm::vec3 r2 { c2 * s1, -s2, c1 * c2 };
+				model_matrices[i] = glm::mat4 {
+					glm::vec4(t.scaleX[i] * r0, 0.0F),
+					glm::vec4(t.scaleY[i] * r1, 0.0F),
+					glm::vec4(t.scaleZ[i] * r2, 0.0F),
+					glm::vec4(t.translationX[i], t.translationY[i], t.translationZ[i], 1.0F)
+				};
+				if (normal_matrices != nullptr) {
+					normal_matrices[i] = glm::mat3 { r0 / t.scaleX[i], r1 / t.scaleY[i], r2 / t.scaleZ[i] };
+				}
+			}
+		}
+		// NOLINTEND
+
+#ifdef ENGINE_TRANSFORM_KERNEL_AVX2
+
+		const size_t LANES = 8;
+
+		// NOLINTBEGIN
+		// Cephes single precision sin/cos: reduce to [-pi/4, pi/4] by octant and evaluate both polynomials
+		__attribute__((target("avx2"))) inline void sincos8(__m256 x, __m256& sin_out, __m256& cos_out) {
+			const __m256 sign_mask = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(0x80000000)));
+			__m256 sign_sin = _mm256_and_ps(x, sign_mask);
+			x = _mm256_andnot_ps(sign_mask, x);
+
+			__m256i octant = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516F)));
+			octant = _mm256_and_si256(_mm256_add_epi32(octant, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+			const __m256 y = _mm256_cvtepi32_ps(octant);
+
+			const __m256 swap_sin = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(4)), 29));
+			const __m256 poly_mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+			const __m256 sign_cos = _mm256_castsi256_ps(_mm256_slli_epi32(
+				_mm256_andnot_si256(_mm256_sub_epi32(octant, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+			sign_sin = _mm256_xor_ps(sign_sin, swap_sin);
+
+			x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(-0.78515625F)));
+			x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(-2.4187564849853515625e-4F)));
+			x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(-3.77489497744594108e-8F)));
+			const __m256 z = _mm256_mul_ps(x, x);
+
+			__m256 cos_poly = _mm256_set1_ps(2.443315711809948e-5F);
+			cos_poly = _mm256_add_ps(_mm256_mul_ps(cos_poly, z), _mm256_set1_ps(-1.388731625493765e-3F));
+			cos_poly = _mm256_add_ps(_mm256_mul_ps(cos_poly, z), _mm256_set1_ps(4.166664568298827e-2F));
+			cos_poly = _mm256_mul_ps(_mm256_mul_ps(cos_poly, z), z);
+			cos_poly = _mm256_sub_ps(cos_poly, _mm256_mul_ps(z, _mm256_set1_ps(0.5F)));
+			cos_poly = _mm256_add_ps(cos_poly, _mm256_set1_ps(1.0F));
+
+			__m256 sin_poly = _mm256_set1_ps(-1.9515295891e-4F);
+			sin_poly = _mm256_add_ps(_mm256_mul_ps(sin_poly, z), _mm256_set1_ps(8.3321608736e-3F));
+			sin_poly = _mm256_add_ps(_mm256_mul_ps(sin_poly, z), _mm256_set1_ps(-1.6666654611e-1F));
+			sin_poly = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sin_poly, z), x), x);
+
+			sin_out = _mm256_xor_ps(_mm256_blendv_ps(cos_poly, sin_poly, poly_mask), sign_sin);
+			cos_out = _mm256_xor_ps(_mm256_blendv_ps(sin_poly, cos_poly, poly_mask), sign_cos);
+		}
+
+		__attribute__((target("avx2"))) void computeAvx2(const TransformArrays& t, size_t count, glm::mat4* model_matrices, glm::mat3* normal_matrices) {
+			const __m256 one = _mm256_set1_ps(1.0F);
+			alignas(32) float out[9][LANES];
+			alignas(32) float scale[3][LANES];
+			alignas(32) float inv_scale[3][LANES];
+			for (size_t base = 0; base < count; base += LANES) {
+				__m256 s1, c1, s2, c2, s3, c3;
+				sincos8(_mm256_loadu_ps(&t.rotationY[base]), s1, c1);
+				sincos8(_mm256_loadu_ps(&t.rotationX[base]), s2, c2);
+				sincos8(_mm256_loadu_ps(&t.rotationZ[base]), s3, c3);
+				const __m256 s1s2 = _mm256_mul_ps(s1, s2);
+				const __m256 c1s2 = _mm256_mul_ps(c1, s2);
+
+				_mm256_store_ps(out[0], _mm256_add_ps(_mm256_mul_ps(c1, c3), _mm256_mul_ps(s1s2, s3)));
+				_mm256_store_ps(out[1], _mm256_mul_ps(c2, s3));
+				_mm256_store_ps(out[2], _mm256_sub_ps(_mm256_mul_ps(c1s2, s3), _mm256_mul_ps(c3, s1)));
+				_mm256_store_ps(out[3], _mm256_sub_ps(_mm256_mul_ps(c3, s1s2), _mm256_mul_ps(c1, s3)));
+				_mm256_store_ps(out[4], _mm256_mul_ps(c2, c3));
+				_mm256_store_ps(out[5], _mm256_add_ps(_mm256_mul_ps(c1s2, c3), _mm256_mul_ps(s1, s3)));
+				_mm256_store_ps(out[6], _mm256_mul_ps(c2, s1));
+				_mm256_store_ps(out[7], _mm256_xor_ps(s2, _mm256_set1_ps(-0.0F)));
+				_mm256_store_ps(out[8], _mm256_mul_ps(c1, c2));
+
+				const __m256 sx = _mm256_loadu_ps(&t.scaleX[base]);
+				const __m256 sy = _mm256_loadu_ps(&t.scaleY[base]);
+				const __m256 sz = _mm256_loadu_ps(&t.scaleZ[base]);
+				_mm256_store_ps(scale[0], sx);
+				_mm256_store_ps(scale[1], sy);
+				_mm256_store_ps(scale[2], sz);
+				_mm256_store_ps(inv_scale[0], _mm256_div_ps(one, sx));
+				_mm256_store_ps(inv_scale[1], _mm256_div_ps(one, sy));
+				_mm256_store_ps(inv_scale[2], _mm256_div_ps(one, sz));
+
+				for (size_t lane = 0; lane < LANES; lane++) {
+					const size_t i = base + lane;
+					const glm::vec3 r0 { out[0][lane], out[1][lane], out[2][lane] };
+					const glm::vec3 r1 { out[3][lane], out[4][lane], out[5][lane] };
+					const glm::vec3 r2 { out[6][lane], out[7][lane], out[8][lane] };
+					model_matrices[i] = glm::mat4 {
+						glm::vec4(scale[0][lane] * r0, 0.0F),
+						glm::vec4(scale[1][lane] * r1, 0.0F),
+						glm::vec4(scale[2][lane] * r2, 0.0F),
+						glm::vec4(t.translationX[i], t.translationY[i], t.translationZ[i], 1.0F)
+					};
+					if (normal_matrices != nullptr) {
+						normal_matrices[i] = glm::mat3 { inv_scale[0][lane] * r0, inv_scale[1][lane] * r1, inv_scale[2][lane] * r2 };
+					}
+				}
+			}
+		}
+		// NOLINTEND
+
+#endif
+
+	}
+
+	TransformKernel bestTransformKernel() {
+#ifdef ENGINE_TRANSFORM_KERNEL_AVX2
+		static const bool has_avx2 = __builtin_cpu_supports("avx2") != 0;
+		if (has_avx2) {
+			return TransformKernel::Avx2;
+		}
+#endif
+		return TransformKernel::Scalar;
+	}
+
+	void computeTransforms(const TransformArrays& transforms, glm::mat4* model_matrices, glm::mat3* normal_matrices, TransformKernel kernel) {
+		assert(model_matrices != nullptr && "Transform kernel needs an output for model matrices"); // NOLINT
+		const size_t count = transforms.size();
+		size_t vectorized = 0;
+#ifdef ENGINE_TRANSFORM_KERNEL_AVX2
+		if (kernel == TransformKernel::Avx2 && bestTransformKernel() == TransformKernel::Avx2) {
+			vectorized = count - count % LANES;
+			computeAvx2(transforms, vectorized, model_matrices, normal_matrices);
+		}
+#else
+		(void)kernel;
+#endif
+		computeScalar(transforms, vectorized, count, model_matrices, normal_matrices);
+	}
+
+}
@@ -28,6 +28,11 @@ namespace engine {
 		return glfwWindowShouldClose(window_);
 	}
 
+	void Window::setTitle(std::string_view title) {
+		title_.assign(title);
+		glfwSetWindowTitle(window_, title_.c_str());
+	}
+
 	void Window::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface) {
 		if (glfwCreateWindowSurface(instance, window_, nullptr, surface) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create window surface");